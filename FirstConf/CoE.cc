@@ -28,6 +28,21 @@
 #include "pedestrians-application.h"
 #include "car-application.h"
 #include "globals.h"
+#include "trace-sink.h"
+#include "task-registry.h"
+#include "allocation-counter.h"
+#include "event-profiler.h"
+#include "controller-benchmark.h"
+#include "run-stats.h"
+#include "convergence-controller.h"
+#include "latency-histogram.h"
+#include "replication-server.h"
+#include "radio-abstraction.h"
+#include "radio-probe.h"
+#include "waypoint-trace.h"
+#include "manhattan-mobility.h"
+
+#include <memory>
 
 // Terminal color codes for log formatting
 #define PURPLE_CODE "\033[95m"
@@ -45,14 +60,21 @@ using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("CloudEdgeOffloading");
 
+// First stream of the pedestrian request generators, far above the radio and vehicle streams
+static const int64_t REQUEST_STREAM_BASE = 1 << 30;
+
 int main(int argc, char* argv[])
 {
+    // Wall-clock time of the scenario setup, for --runStats
+    RunStats::Start();
+    
     //-------------------------------------------------------------------------
     // Default simulation parameters
     //-------------------------------------------------------------------------
     
     // Simulation time
     double simTime = 120.0;   // seconds
+    double drainTime = 1.0;   // seconds without new requests at the end, for the last ones to complete
     
     // 5G NR parameters
     uint16_t numerology = 2;
@@ -64,6 +86,23 @@ int main(int argc, char* argv[])
     uint8_t fixedMcs = 27;              // Modulation and coding scheme
     bool useFixedMcs = true;
     
+    // Radio model: "nr" (full 5G NR stack) or "abstract" (calibrated lookup table)
+    std::string radioModel = "nr";
+    std::string radioTable = "";        // Table written by scripts/calibrate_radio.py
+    double radioLoadWindow = 100;       // Milliseconds, window of the radio load
+    bool radioProbe = false;            // Write per-packet radio measurements (NR only)
+    
+    // Vehicle mobility: "trace" (traceFile) or "manhattan" (built-in grid generator)
+    std::string mobility = "trace";
+    uint32_t gridNumber = 2;            // Junctions per side
+    double gridXLength = 600;           // m (1200 for the double rectangle)
+    double gridYLength = 50;            // m
+    uint32_t gridLanes = 1;
+    double gridSpeed = 13.88889;        // Speed limit (m/s)
+    uint64_t mobilitySeed = 1;          // Seed of the generated traffic, independent of RngRun
+    double mobilityTolerance = 0.1;     // Max position error (m) when merging generated waypoints
+    std::string mobilityOutput = "";    // Save the generated traffic as a .wpt trace
+    
     // Node positions
     double gNBPosition_x = 1000;
     double gNBPosition_y = 1000;
@@ -79,16 +118,56 @@ int main(int argc, char* argv[])
     uint32_t vehicleQueueLength = 1;
     double requestRate = 1000;          // Milliseconds
     
+    // Vehicle beaconing
+    std::string beaconMode = "fixed";   // "fixed", "delta" or "adaptive"
+    double beaconInterval = 100;        // Milliseconds, period (fixed) or check period (delta)
+    double beaconDrift = 10;            // Meters of position drift that trigger a beacon
+    double neighborTimeout = 0.5;       // Seconds; delta/adaptive keep-alive is half of it
+    
     // Computation capacities (MIPS)
     double cloudComputationCapacity = 2356230.0;
     double edgeComputationCapacity = 749070.0;
     double carComputationCapacity = 221720.0;
+    uint32_t edgeWorkers = 1;           // Parallel workers sharing the edge capacity
+    std::string edgeWorkerShares = "";  // e.g. "2,1,1"; empty for equal shares
+    uint32_t edgeQueueSize = 100;       // Tasks waiting for an edge worker
+    
+    // Cloud server pool (cloudComputationCapacity is per instance)
+    uint32_t cloudInstances = 1;
+    uint32_t cloudMaxInstances = 1;     // Above cloudInstances enables autoscaling
+    uint32_t cloudQueueSize = 1000;
+    double cloudScaleOutDelay = 30;     // Seconds for a new instance to enter service
+    double cloudScaleInterval = 1;      // Seconds between autoscaling decisions
+    double cloudScaleOutQueue = 2;      // Queued tasks per instance that trigger a scale-out
+    double cloudScaleInUtilization = 0.3;
     
     // Output parameters
     std::string outputDataCsv;
     std::string chosenStrategy;
     std::string traceFile;
     std::string simType;
+    std::string traceFormat = "csv";    // "csv" or "binary" (.npy columns)
+    bool traceAsync = false;
+    uint32_t traceRingSize = 16384;     // Trace records buffered for the writer thread
+    bool traceDropWhenFull = false;
+    bool latencyHistograms = true;
+    bool allocationStats = false;
+    bool profileEvents = false;
+    uint32_t profileTop = 20;           // Rows of the event profile table
+    bool runStats = false;
+    double stopPrecision = 0;           // Relative CI half-width of the mean offloading time; 0 runs for simTime
+    double stopConfidence = 0.95;
+    uint32_t stopBatchSize = 50;        // Completed requests per batch mean of the stopping rule
+    uint32_t stopMinBatches = 20;       // Batches per tier before it can converge
+    double stopMinShare = 0.01;         // Share of the completed requests below which a tier does not hold the run
+    double stopCheckInterval = 1.0;     // Seconds between two checks of the stopping rule
+    std::string microbenchmark = "";    // JSON output of the controller microbenchmarks; empty to simulate
+    double microbenchmarkTime = 0.2;    // Minimum measured time per microbenchmark (s)
+    
+    // Replication server mode
+    std::string forkVariants = "";      // e.g. "VCCFirst:1-10,EC_and_CC:1-10"; empty for a single run
+    double forkWarmup = 1.0;            // Seconds simulated once before forking
+    uint32_t forkJobs = 0;              // Concurrent replications, 0 for the number of cores
     
     //-------------------------------------------------------------------------
     // Command line parameter parsing
@@ -97,12 +176,51 @@ int main(int argc, char* argv[])
     
     // Output parameters
     cmd.AddValue("outputDataCsv", "CSV output data folder", outputDataCsv);
-    cmd.AddValue("strategy", "Offloading strategy to use", chosenStrategy);
-    cmd.AddValue("traceFile", "NS2 mobility trace file", traceFile);
+    cmd.AddValue("strategy", "Offloading strategy to use (Random, VCCFirst, EC_and_CC, VCC_and_CC, MinCompletionTime)", chosenStrategy);
+    cmd.AddValue("traceFile", "NS2 mobility trace file, or binary waypoint trace (.wpt)", traceFile);
     cmd.AddValue("simType", "Simulation type", simType);
+    cmd.AddValue("traceFormat", "Trace output format (csv, binary)", traceFormat);
+    cmd.AddValue("traceAsync", "Write traces from a background thread", traceAsync);
+    cmd.AddValue("traceRingSize", "Trace records buffered for the writer thread", traceRingSize);
+    cmd.AddValue("latencyHistograms", "Dump per-tier offloading latency histograms at the end of the run", latencyHistograms);
+    cmd.AddValue("allocationStats", "Write the heap allocations per request after the first second of requests", allocationStats);
+    cmd.AddValue("profileEvents", "Profile the wall-clock time of the simulation events and application handlers", profileEvents);
+    cmd.AddValue("profileTop", "Rows of the event profile table", profileTop);
+    cmd.AddValue("runStats", "Write the wall-clock time, events, peak memory and completed requests of the run", runStats);
+    cmd.AddValue("stopPrecision", "Stop once the CI half-width of the mean offloading time of every tier is below this fraction of the mean (0: run for simTime)", stopPrecision);
+    cmd.AddValue("stopConfidence", "Confidence level of the stopping rule", stopConfidence);
+    cmd.AddValue("stopBatchSize", "Completed requests per batch of the stopping rule (multiple of 5)", stopBatchSize);
+    cmd.AddValue("stopMinBatches", "Batches per tier before the stopping rule can end the run", stopMinBatches);
+    cmd.AddValue("stopMinShare", "Share of the completed requests below which a tier does not hold the stopping rule", stopMinShare);
+    cmd.AddValue("stopCheckInterval", "Time between two checks of the stopping rule (s)", stopCheckInterval);
+    cmd.AddValue("microbenchmark", "Run the controller microbenchmarks instead of the simulation and write them to this JSON file", microbenchmark);
+    cmd.AddValue("microbenchmarkTime", "Minimum measured time per microbenchmark (s)", microbenchmarkTime);
+    cmd.AddValue("traceDropWhenFull", "Drop (and count) trace records when the ring is full instead of blocking", traceDropWhenFull);
+    cmd.AddValue("forkVariants", "Replication server mode: strategy:run[-lastRun] list forked after the warm-up", forkVariants);
+    cmd.AddValue("forkWarmup", "Replication server mode: time simulated once before forking (s)", forkWarmup);
+    cmd.AddValue("forkJobs", "Replication server mode: concurrent replications (0 for the number of cores)", forkJobs);
     
     // Simulation parameters
     cmd.AddValue("simTime", "Duration of the simulation (s)", simTime);
+    cmd.AddValue("drainTime", "Time without new requests at the end of the run, for the requests in flight to complete (s)", drainTime);
+    
+    // Radio model parameters
+    cmd.AddValue("radioModel", "Radio model (nr, abstract)", radioModel);
+    cmd.AddValue("radioTable", "Calibrated radio table used by the abstract radio model", radioTable);
+    cmd.AddValue("radioLoadWindow", "Window over which the radio load is measured (ms)", radioLoadWindow);
+    cmd.AddValue("mcs", "Fixed MCS of the NR scheduler and of the abstract radio table", fixedMcs);
+    cmd.AddValue("radioProbe", "Write per-packet radio measurements for the calibration (nr only)", radioProbe);
+    
+    // Mobility parameters
+    cmd.AddValue("mobility", "Vehicle mobility (trace, manhattan)", mobility);
+    cmd.AddValue("gridNumber", "Manhattan mobility: junctions per side", gridNumber);
+    cmd.AddValue("gridXLength", "Manhattan mobility: street length along x (m)", gridXLength);
+    cmd.AddValue("gridYLength", "Manhattan mobility: street length along y (m)", gridYLength);
+    cmd.AddValue("gridLanes", "Manhattan mobility: lanes per direction", gridLanes);
+    cmd.AddValue("gridSpeed", "Manhattan mobility: speed limit (m/s)", gridSpeed);
+    cmd.AddValue("mobilitySeed", "Manhattan mobility: seed of the generated traffic", mobilitySeed);
+    cmd.AddValue("mobilityTolerance", "Manhattan mobility: maximum position error when merging waypoints (m)", mobilityTolerance);
+    cmd.AddValue("mobilityOutput", "Manhattan mobility: save the generated traffic as a waypoint trace (.wpt)", mobilityOutput);
     
     // Node position parameters
     cmd.AddValue("gNBPosition_x", "x-position of gNB", gNBPosition_x);
@@ -119,10 +237,28 @@ int main(int argc, char* argv[])
     cmd.AddValue("carQueueLength", "Queue length in vehicles", vehicleQueueLength);
     cmd.AddValue("requestRate", "Request rate (ms)", requestRate);
     
+    // Beaconing parameters
+    cmd.AddValue("beaconMode", "Vehicle beaconing (fixed, delta, adaptive)", beaconMode);
+    cmd.AddValue("beaconInterval", "Beacon period, or shortest check period in delta/adaptive mode (ms)", beaconInterval);
+    cmd.AddValue("beaconDrift", "Position drift that triggers a beacon in delta/adaptive mode (m)", beaconDrift);
+    cmd.AddValue("neighborTimeout", "Time after its last beacon at which the edge forgets a vehicle (s)", neighborTimeout);
+    
     // Computation capacity parameters
     cmd.AddValue("edgeComputationCapacity", "Edge computation capacity (MIPS)", edgeComputationCapacity);
     cmd.AddValue("carComputationCapacity", "Vehicle computation capacity (MIPS)", carComputationCapacity);
-    cmd.AddValue("cloudComputationCapacity", "Cloud computation capacity (MIPS)", cloudComputationCapacity);
+    cmd.AddValue("cloudComputationCapacity", "Cloud computation capacity per instance (MIPS)", cloudComputationCapacity);
+    cmd.AddValue("edgeWorkers", "Number of parallel edge workers sharing the edge capacity", edgeWorkers);
+    cmd.AddValue("edgeWorkerShares", "Comma-separated capacity shares of the edge workers (overrides edgeWorkers)", edgeWorkerShares);
+    cmd.AddValue("edgeQueueSize", "Maximum number of tasks waiting for an edge worker", edgeQueueSize);
+    
+    // Cloud server pool parameters
+    cmd.AddValue("cloudInstances", "Cloud instances at the start (minimum when autoscaling)", cloudInstances);
+    cmd.AddValue("cloudMaxInstances", "Maximum cloud instances (autoscaling when above cloudInstances)", cloudMaxInstances);
+    cmd.AddValue("cloudQueueSize", "Maximum number of tasks waiting for a cloud instance", cloudQueueSize);
+    cmd.AddValue("cloudScaleOutDelay", "Time for a new cloud instance to enter service (s)", cloudScaleOutDelay);
+    cmd.AddValue("cloudScaleInterval", "Period of the cloud autoscaling decision (s)", cloudScaleInterval);
+    cmd.AddValue("cloudScaleOutQueue", "Queued tasks per cloud instance that trigger a scale-out", cloudScaleOutQueue);
+    cmd.AddValue("cloudScaleInUtilization", "Cloud utilization below which an instance is retired", cloudScaleInUtilization);
     
     cmd.Parse(argc, argv);
     
@@ -140,7 +276,62 @@ int main(int argc, char* argv[])
     cloud_computation_capacity = cloudComputationCapacity;
     edge_computation_capacity = edgeComputationCapacity;
     car_computation_capacity = carComputationCapacity;
+    edge_workers = edgeWorkers;
+    edge_worker_shares = edgeWorkerShares;
+    edge_queue_size = edgeQueueSize;
+    cloud_instances = cloudInstances;
+    cloud_max_instances = cloudMaxInstances;
+    cloud_queue_size = cloudQueueSize;
+    cloud_scale_out_delay = cloudScaleOutDelay;
+    cloud_scale_interval = cloudScaleInterval;
+    cloud_scale_out_queue = cloudScaleOutQueue;
+    cloud_scale_in_utilization = cloudScaleInUtilization;
     sim_type = simType;
+    beacon_mode = beaconMode;
+    beacon_drift = beaconDrift;
+    neighbor_timeout = neighborTimeout;
+    
+    NS_ABORT_MSG_IF(traceFormat != "csv" && traceFormat != "binary",
+                    "Unknown trace format " << traceFormat);
+    NS_ABORT_MSG_IF(radioModel != "nr" && radioModel != "abstract",
+                    "Unknown radio model " << radioModel);
+    NS_ABORT_MSG_IF(radioModel == "abstract" && radioTable.empty(),
+                    "The abstract radio model needs a calibrated --radioTable");
+    NS_ABORT_MSG_IF(radioModel == "abstract" && radioProbe,
+                    "The radio probe calibrates against the nr radio model");
+    NS_ABORT_MSG_IF(mobility != "trace" && mobility != "manhattan",
+                    "Unknown vehicle mobility " << mobility);
+    NS_ABORT_MSG_IF(beaconMode != "fixed" && beaconMode != "delta" && beaconMode != "adaptive",
+                    "Unknown beacon mode " << beaconMode);
+    
+    // Heap allocations are only counted when they are reported
+    if (allocationStats || !microbenchmark.empty()) {
+        AllocationCounter::Enable();
+    }
+    
+    // The microbenchmarks use the configuration above but no scenario
+    if (!microbenchmark.empty()) {
+        NS_ABORT_MSG_IF(microbenchmarkTime <= 0, "The microbenchmark time must be positive");
+        ControllerBenchmark::Run(microbenchmark, microbenchmarkTime);
+        return 0;
+    }
+    
+    // In replication server mode the applications start after the shared warm-up,
+    // so that every random draw of the applications happens in the forked replications
+    bool forkMode = !forkVariants.empty();
+    NS_ABORT_MSG_IF(forkMode && (forkWarmup <= 0 || forkWarmup >= simTime),
+                    "The fork warm-up must be within the simulation time");
+    double appStartTime = forkMode ? forkWarmup : 0;
+    NS_ABORT_MSG_IF(drainTime < 0 || appStartTime + drainTime >= simTime,
+                    "The drain time must leave some time for the requests");
+    requests_end_time = simTime - drainTime;
+    NS_ABORT_MSG_IF(allocationStats && appStartTime + 1 >= simTime,
+                    "Allocation statistics need more than one second of requests");
+    
+    // Profiled events go through their own scheduler, installed before anything is scheduled
+    if (profileEvents) {
+        EventProfiler::Enable();
+    }
     
     //-------------------------------------------------------------------------
     // Create nodes and set up mobility
@@ -149,111 +340,141 @@ int main(int argc, char* argv[])
     // Create vehicle nodes and set up SUMO mobility
     NodeContainer carNodes;
     carNodes.Create(nVehicles);
-    Ns2MobilityHelper sumoMobility = Ns2MobilityHelper(traceFile);
-    sumoMobility.Install(); // Configure movements for each vehicle from trace file
+    if (mobility == "manhattan") {
+        // Same grids as SUMO_Mobility/scripts/manhattan_*.sh, generated in memory
+        ManhattanGridParameters grid;
+        grid.gridNumber = gridNumber;
+        grid.xLength = gridXLength;
+        grid.yLength = gridYLength;
+        grid.lanes = gridLanes;
+        grid.speedLimit = gridSpeed;
+        grid.duration = simTime;
+        grid.tolerance = mobilityTolerance;
+        ManhattanMobilityGenerator generator(grid, mobilitySeed);
+        Ptr<WaypointTrace> traffic = generator.Generate(nVehicles);
+        if (!mobilityOutput.empty()) {
+            traffic->Write(mobilityOutput);
+        }
+        WaypointTraceMobilityHelper waypointMobility(traffic);
+        waypointMobility.Install(carNodes);
+    } else if (traceFile.size() > 4 && traceFile.compare(traceFile.size() - 4, 4, ".wpt") == 0) {
+        // Binary waypoint trace: memory-mapped, waypoints handed out during the run
+        WaypointTraceMobilityHelper waypointMobility(traceFile);
+        waypointMobility.Install(carNodes);
+    } else {
+        Ns2MobilityHelper sumoMobility = Ns2MobilityHelper(traceFile);
+        sumoMobility.Install(); // Configure movements for each vehicle from trace file
+    }
     
     // Ensure we have at least one pedestrian
     NS_ASSERT(nPedestrians > 0);
     
     //-------------------------------------------------------------------------
-    // Set up the 5G NR network
+    // Set up the 5G NR network (replaced by calibrated links in abstract radio mode)
     //-------------------------------------------------------------------------
-    Ptr<NrHelper> nrHelper = CreateObject<NrHelper>();
-    
-    // Spectrum configuration: create one operation band with one component carrier
-    // The CC contains a single Bandwidth Part (BWP) that occupies the entire bandwidth
-    CcBwpCreator ccBwpCreator;
-    const uint8_t numCcPerBand = 1;
-    BandwidthPartInfo::Scenario scenario = BandwidthPartInfo::UMa_LoS;
-    
-    // Create a configuration for the CcBwpHelper
-    CcBwpCreator::SimpleOperationBandConf bandConf(centralFrequency,
-                                                  bandwidth,
-                                                  numCcPerBand,
-                                                  scenario);
-    
-    // Create the operation band with the configuration
-    OperationBandInfo band = ccBwpCreator.CreateOperationBandContiguousCc(bandConf);
-    
-    // Initialize channel, pathloss, and other spectrum parameters
-    nrHelper->InitializeOperationBand(&band);
-    BandwidthPartInfoPtrVector allBwps = CcBwpCreator::GetAllBwps({band});
-    
-    // Set SRS periodicity
-    Config::SetDefault("ns3::LteEnbRrc::SrsPeriodicity", UintegerValue(320));
-    
-    //-------------------------------------------------------------------------
-    // Configure 5G NR parameters for gNB and UEs
-    //-------------------------------------------------------------------------
-    
-    // gNB configuration
-    nrHelper->SetGnbPhyAttribute("TxPower", DoubleValue(txPowergNb));
-    nrHelper->SetGnbPhyAttribute("Numerology", UintegerValue(numerology));
-    
-    // UE configuration
-    nrHelper->SetUePhyAttribute("TxPower", DoubleValue(txPowerUe));
-    
-    // Scheduler configuration
-    nrHelper->SetSchedulerTypeId(TypeId::LookupByName("ns3::NrMacSchedulerTdmaRR"));
-    nrHelper->SetSchedulerAttribute("FixedMcsDl", BooleanValue(useFixedMcs));
-    nrHelper->SetSchedulerAttribute("FixedMcsUl", BooleanValue(useFixedMcs));
-    
-    if (useFixedMcs) {
-        nrHelper->SetSchedulerAttribute("StartingMcsDl", UintegerValue(fixedMcs));
-        nrHelper->SetSchedulerAttribute("StartingMcsUl", UintegerValue(fixedMcs));
+    bool abstractRadio = radioModel == "abstract";
+    Ptr<NrHelper> nrHelper;
+    Ptr<NrPointToPointEpcHelper> epcHelper;
+    OperationBandInfo band;
+    BandwidthPartInfoPtrVector allBwps;
+    if (!abstractRadio) {
+        nrHelper = CreateObject<NrHelper>();
+        
+        // Spectrum configuration: create one operation band with one component carrier
+        // The CC contains a single Bandwidth Part (BWP) that occupies the entire bandwidth
+        CcBwpCreator ccBwpCreator;
+        const uint8_t numCcPerBand = 1;
+        BandwidthPartInfo::Scenario scenario = BandwidthPartInfo::UMa_LoS;
+        
+        // Create a configuration for the CcBwpHelper
+        CcBwpCreator::SimpleOperationBandConf bandConf(centralFrequency,
+                                                      bandwidth,
+                                                      numCcPerBand,
+                                                      scenario);
+        
+        // Create the operation band with the configuration
+        band = ccBwpCreator.CreateOperationBandContiguousCc(bandConf);
+        
+        // Initialize channel, pathloss, and other spectrum parameters
+        nrHelper->InitializeOperationBand(&band);
+        allBwps = CcBwpCreator::GetAllBwps({band});
+        
+        // Set SRS periodicity
+        Config::SetDefault("ns3::LteEnbRrc::SrsPeriodicity", UintegerValue(320));
+        
+        //-------------------------------------------------------------------------
+        // Configure 5G NR parameters for gNB and UEs
+        //-------------------------------------------------------------------------
+        
+        // gNB configuration
+        nrHelper->SetGnbPhyAttribute("TxPower", DoubleValue(txPowergNb));
+        nrHelper->SetGnbPhyAttribute("Numerology", UintegerValue(numerology));
+        
+        // UE configuration
+        nrHelper->SetUePhyAttribute("TxPower", DoubleValue(txPowerUe));
+        
+        // Scheduler configuration
+        nrHelper->SetSchedulerTypeId(TypeId::LookupByName("ns3::NrMacSchedulerTdmaRR"));
+        nrHelper->SetSchedulerAttribute("FixedMcsDl", BooleanValue(useFixedMcs));
+        nrHelper->SetSchedulerAttribute("FixedMcsUl", BooleanValue(useFixedMcs));
+        
+        if (useFixedMcs) {
+            nrHelper->SetSchedulerAttribute("StartingMcsDl", UintegerValue(fixedMcs));
+            nrHelper->SetSchedulerAttribute("StartingMcsUl", UintegerValue(fixedMcs));
+        }
+        
+        // Set RLC buffer size
+        Config::SetDefault("ns3::LteRlcUm::MaxTxBufferSize", UintegerValue(999999999));
+        
+        // Configure UE antennas (1x1 SISO)
+        nrHelper->SetUeAntennaAttribute("NumRows", UintegerValue(1));
+        nrHelper->SetUeAntennaAttribute("NumColumns", UintegerValue(1));
+        nrHelper->SetUeAntennaAttribute("AntennaElement",
+                                      PointerValue(CreateObject<IsotropicAntennaModel>()));
+        
+        // Configure gNB antennas (8x8 MIMO)
+        nrHelper->SetGnbAntennaAttribute("NumRows", UintegerValue(8));
+        nrHelper->SetGnbAntennaAttribute("NumColumns", UintegerValue(8));
+        nrHelper->SetGnbAntennaAttribute("AntennaElement",
+                                       PointerValue(CreateObject<ThreeGppAntennaModel>()));
+        
+        // Configure beamforming
+        Ptr<IdealBeamformingHelper> idealBeamformingHelper = CreateObject<IdealBeamformingHelper>();
+        idealBeamformingHelper->SetAttribute("BeamformingMethod",
+                                           TypeIdValue(DirectPathBeamforming::GetTypeId()));
+        nrHelper->SetBeamformingHelper(idealBeamformingHelper);
+        
+        // Configure channel update period
+        Config::SetDefault("ns3::ThreeGppChannelModel::UpdatePeriod", TimeValue(MilliSeconds(0)));
+        
+        // Disable shadowing for deterministic results
+        nrHelper->SetPathlossAttribute("ShadowingEnabled", BooleanValue(false));
+        
+        // Configure error models
+        nrHelper->SetUlErrorModel("ns3::NrEesmIrT1");
+        nrHelper->SetDlErrorModel("ns3::NrEesmIrT1");
+        
+        // Configure AMC models
+        nrHelper->SetGnbDlAmcAttribute("AmcModel", EnumValue(NrAmc::ErrorModel));
+        nrHelper->SetGnbUlAmcAttribute("AmcModel", EnumValue(NrAmc::ErrorModel));
+        
+        //-------------------------------------------------------------------------
+        // Set up the EPC (core network)
+        //-------------------------------------------------------------------------
+        epcHelper = CreateObject<NrPointToPointEpcHelper>();
+        nrHelper->SetEpcHelper(epcHelper);
+        
+        // Set S1-U link delay (core network latency)
+        epcHelper->SetAttribute("S1uLinkDelay", TimeValue(MilliSeconds(2)));
+        
+        // Configure bearer-to-BWP mapping
+        uint32_t bwpIdForBearer = 0;
+        nrHelper->SetGnbBwpManagerAlgorithmAttribute("GBR_CONV_VOICE", UintegerValue(bwpIdForBearer));
+        
+        // Initialize the NR helper
+        nrHelper->Initialize();
     }
     
-    // Set RLC buffer size
-    Config::SetDefault("ns3::LteRlcUm::MaxTxBufferSize", UintegerValue(999999999));
-    
-    // Configure UE antennas (1x1 SISO)
-    nrHelper->SetUeAntennaAttribute("NumRows", UintegerValue(1));
-    nrHelper->SetUeAntennaAttribute("NumColumns", UintegerValue(1));
-    nrHelper->SetUeAntennaAttribute("AntennaElement",
-                                  PointerValue(CreateObject<IsotropicAntennaModel>()));
-    
-    // Configure gNB antennas (8x8 MIMO)
-    nrHelper->SetGnbAntennaAttribute("NumRows", UintegerValue(8));
-    nrHelper->SetGnbAntennaAttribute("NumColumns", UintegerValue(8));
-    nrHelper->SetGnbAntennaAttribute("AntennaElement",
-                                   PointerValue(CreateObject<ThreeGppAntennaModel>()));
-    
-    // Configure beamforming
-    Ptr<IdealBeamformingHelper> idealBeamformingHelper = CreateObject<IdealBeamformingHelper>();
-    idealBeamformingHelper->SetAttribute("BeamformingMethod",
-                                       TypeIdValue(DirectPathBeamforming::GetTypeId()));
-    nrHelper->SetBeamformingHelper(idealBeamformingHelper);
-    
-    // Configure channel update period
-    Config::SetDefault("ns3::ThreeGppChannelModel::UpdatePeriod", TimeValue(MilliSeconds(0)));
-    
-    // Disable shadowing for deterministic results
-    nrHelper->SetPathlossAttribute("ShadowingEnabled", BooleanValue(false));
-    
-    // Configure error models
-    nrHelper->SetUlErrorModel("ns3::NrEesmIrT1");
-    nrHelper->SetDlErrorModel("ns3::NrEesmIrT1");
-    
-    // Configure AMC models
-    nrHelper->SetGnbDlAmcAttribute("AmcModel", EnumValue(NrAmc::ErrorModel));
-    nrHelper->SetGnbUlAmcAttribute("AmcModel", EnumValue(NrAmc::ErrorModel));
-    
-    //-------------------------------------------------------------------------
-    // Set up the EPC (core network)
-    //-------------------------------------------------------------------------
-    Ptr<NrPointToPointEpcHelper> epcHelper = CreateObject<NrPointToPointEpcHelper>();
-    nrHelper->SetEpcHelper(epcHelper);
-    
-    // Set S1-U link delay (core network latency)
-    epcHelper->SetAttribute("S1uLinkDelay", TimeValue(MilliSeconds(2)));
-    
-    // Configure bearer-to-BWP mapping
-    uint32_t bwpIdForBearer = 0;
-    nrHelper->SetGnbBwpManagerAlgorithmAttribute("GBR_CONV_VOICE", UintegerValue(bwpIdForBearer));
-    
-    // Initialize the NR helper
-    nrHelper->Initialize();
-    
     //-------------------------------------------------------------------------
     // Create and position nodes
     //-------------------------------------------------------------------------
@@ -287,45 +508,59 @@ int main(int argc, char* argv[])
     //-------------------------------------------------------------------------
     // Install network devices
     //-------------------------------------------------------------------------
-    
-    // Install gNB devices
-    NetDeviceContainer gNbNetDev = nrHelper->InstallGnbDevice(gNbNodes, allBwps);
-    
-    // Install UE devices for pedestrians and vehicles
-    NetDeviceContainer pedNetDev = nrHelper->InstallUeDevice(pedestrianNodes, allBwps);
-    NetDeviceContainer carNetDev = nrHelper->InstallUeDevice(carNodes, allBwps);
-    
-    // Assign random number streams for reproducibility
+    NetDeviceContainer gNbNetDev;
+    NetDeviceContainer pedNetDev;
+    NetDeviceContainer carNetDev;
     int64_t randomStream = 1;
-    randomStream += nrHelper->AssignStreams(gNbNetDev, randomStream);
-    randomStream += nrHelper->AssignStreams(pedNetDev, randomStream);
-    randomStream += nrHelper->AssignStreams(carNetDev, randomStream);
-    
-    // Update configuration for all devices
-    for (auto it = gNbNetDev.Begin(); it != gNbNetDev.End(); ++it) {
-        DynamicCast<NrGnbNetDevice>(*it)->UpdateConfig();
-    }
     
-    for (auto it = pedNetDev.Begin(); it != pedNetDev.End(); ++it) {
-        DynamicCast<NrUeNetDevice>(*it)->UpdateConfig();
-    }
-    
-    for (auto it = carNetDev.Begin(); it != carNetDev.End(); ++it) {
-        DynamicCast<NrUeNetDevice>(*it)->UpdateConfig();
+    if (!abstractRadio) {
+        // Install gNB devices
+        gNbNetDev = nrHelper->InstallGnbDevice(gNbNodes, allBwps);
+        
+        // Install UE devices for pedestrians and vehicles
+        pedNetDev = nrHelper->InstallUeDevice(pedestrianNodes, allBwps);
+        carNetDev = nrHelper->InstallUeDevice(carNodes, allBwps);
+        
+        // Assign random number streams for reproducibility
+        randomStream += nrHelper->AssignStreams(gNbNetDev, randomStream);
+        randomStream += nrHelper->AssignStreams(pedNetDev, randomStream);
+        randomStream += nrHelper->AssignStreams(carNetDev, randomStream);
+        
+        // Update configuration for all devices
+        for (auto it = gNbNetDev.Begin(); it != gNbNetDev.End(); ++it) {
+            DynamicCast<NrGnbNetDevice>(*it)->UpdateConfig();
+        }
+        
+        for (auto it = pedNetDev.Begin(); it != pedNetDev.End(); ++it) {
+            DynamicCast<NrUeNetDevice>(*it)->UpdateConfig();
+        }
+        
+        for (auto it = carNetDev.Begin(); it != carNetDev.End(); ++it) {
+            DynamicCast<NrUeNetDevice>(*it)->UpdateConfig();
+        }
     }
     
     //-------------------------------------------------------------------------
     // Set up the internet and IP connectivity
     //-------------------------------------------------------------------------
+    InternetStackHelper internet;
     
-    // Get SGW/PGW and create a remote host (cloud)
-    Ptr<Node> pgw = epcHelper->GetPgwNode();
+    // Get SGW/PGW, or use the gNB node itself with the abstract radio: it then
+    // forwards between the UEs and the cloud and hosts the edge application
+    Ptr<Node> pgw;
+    if (!abstractRadio) {
+        pgw = epcHelper->GetPgwNode();
+    } else {
+        internet.Install(gNbNodes);
+        pgw = gNbNodes.Get(0);
+    }
+    
+    // Create a remote host (cloud)
     NodeContainer remoteHostContainer;
     remoteHostContainer.Create(1);
     Ptr<Node> remoteHost = remoteHostContainer.Get(0);
     
     // Install internet stack on remote host
-    InternetStackHelper internet;
     internet.Install(remoteHostContainer);
     
     // Connect remote host to PGW with a point-to-point link
@@ -352,30 +587,51 @@ int main(int argc, char* argv[])
     internet.Install(carNodes);
     
     // Assign IP addresses to UEs
-    Ipv4InterfaceContainer ueIpIface = epcHelper->AssignUeIpv4Address(NetDeviceContainer(pedNetDev));
-    Ipv4InterfaceContainer ueCarIpIface = epcHelper->AssignUeIpv4Address(NetDeviceContainer(carNetDev));
+    Ipv4InterfaceContainer ueIpIface;
+    Ipv4InterfaceContainer ueCarIpIface;
+    std::unique_ptr<AbstractRadioHelper> abstractRadioHelper;
+    if (!abstractRadio) {
+        ueIpIface = epcHelper->AssignUeIpv4Address(NetDeviceContainer(pedNetDev));
+        ueCarIpIface = epcHelper->AssignUeIpv4Address(NetDeviceContainer(carNetDev));
+    } else {
+        // One calibrated link per UE, which also sets the UE default route
+        abstractRadioHelper.reset(new AbstractRadioHelper(radioTable, fixedMcs,
+                                                          MilliSeconds(radioLoadWindow)));
+        ueIpIface = abstractRadioHelper->Install(pgw, pedestrianNodes);
+        ueCarIpIface = abstractRadioHelper->Install(pgw, carNodes);
+        randomStream += abstractRadioHelper->AssignStreams(randomStream);
+    }
     
     // Enable packet printing
     Packet::EnablePrinting();
     
-    // Set default gateway for pedestrian UEs
-    for (uint32_t j = 0; j < pedestrianNodes.GetN(); ++j) {
-        Ptr<Ipv4StaticRouting> ueStaticRouting =
-            ipv4RoutingHelper.GetStaticRouting(pedestrianNodes.Get(j)->GetObject<Ipv4>());
-        ueStaticRouting->SetDefaultRoute(epcHelper->GetUeDefaultGatewayAddress(), 1);
+    if (!abstractRadio) {
+        // Set default gateway for pedestrian UEs
+        for (uint32_t j = 0; j < pedestrianNodes.GetN(); ++j) {
+            Ptr<Ipv4StaticRouting> ueStaticRouting =
+                ipv4RoutingHelper.GetStaticRouting(pedestrianNodes.Get(j)->GetObject<Ipv4>());
+            ueStaticRouting->SetDefaultRoute(epcHelper->GetUeDefaultGatewayAddress(), 1);
+        }
+        
+        // Set default gateway for vehicle UEs
+        for (uint32_t j = 0; j < carNodes.GetN(); ++j) {
+            Ptr<Ipv4StaticRouting> ueStaticRouting =
+                ipv4RoutingHelper.GetStaticRouting(carNodes.Get(j)->GetObject<Ipv4>());
+            ueStaticRouting->SetDefaultRoute(epcHelper->GetUeDefaultGatewayAddress(), 1);
+        }
+        
+        // Attach UEs to the closest gNB
+        nrHelper->AttachToClosestEnb(pedNetDev, gNbNetDev);
+        nrHelper->AttachToClosestEnb(carNetDev, gNbNetDev);
     }
     
-    // Set default gateway for vehicle UEs
-    for (uint32_t j = 0; j < carNodes.GetN(); ++j) {
-        Ptr<Ipv4StaticRouting> ueStaticRouting =
-            ipv4RoutingHelper.GetStaticRouting(carNodes.Get(j)->GetObject<Ipv4>());
-        ueStaticRouting->SetDefaultRoute(epcHelper->GetUeDefaultGatewayAddress(), 1);
+    // Radio calibration measurements, interface 1 of the PGW is the tunnel to the UEs
+    Ptr<RadioProbe> probe;
+    if (radioProbe) {
+        probe = Create<RadioProbe>(fixedMcs, MilliSeconds(radioLoadWindow), Seconds(1));
+        probe->Install(pgw, 1, gNbNodes.Get(0), NodeContainer(pedestrianNodes, carNodes));
     }
     
-    // Attach UEs to the closest gNB
-    nrHelper->AttachToClosestEnb(pedNetDev, gNbNetDev);
-    nrHelper->AttachToClosestEnb(carNetDev, gNbNetDev);
-    
     //-------------------------------------------------------------------------
     // Set up bearers and traffic flow templates
     //-------------------------------------------------------------------------
@@ -402,10 +658,10 @@ int main(int argc, char* argv[])
     Ptr<CloudApplication> udpCloud = CreateObject<CloudApplication>();
     
     // Set application start and stop times
-    udpEdge->SetStartTime(Seconds(0));
+    udpEdge->SetStartTime(Seconds(appStartTime));
     udpEdge->SetStopTime(Seconds(simTime));
     
-    udpCloud->SetStartTime(Seconds(0));
+    udpCloud->SetStartTime(Seconds(appStartTime));
     udpCloud->SetStopTime(Seconds(simTime));
     
     // Install applications on nodes
@@ -418,29 +674,38 @@ int main(int argc, char* argv[])
     cloud_ip = cloudIaddr.GetLocal();
     
     // Install applications on vehicles
+    std::vector<Ptr<CarApplication>> carApps;
     for (uint32_t i = 0; i < carNodes.GetN(); i++) {
         // Activate dedicated bearer for the vehicle
-        Ptr<NetDevice> ueCarDevice = carNetDev.Get(i);
-        nrHelper->ActivateDedicatedEpsBearer(ueCarDevice, bearer, tft);
+        if (!abstractRadio) {
+            Ptr<NetDevice> ueCarDevice = carNetDev.Get(i);
+            nrHelper->ActivateDedicatedEpsBearer(ueCarDevice, bearer, tft);
+        }
         
         // Create and install car application
         Ptr<CarApplication> app_i = CreateObject<CarApplication>();
-        app_i->SetStartTime(Seconds(0));
+        app_i->SetAttribute("Interval", TimeValue(MilliSeconds(beaconInterval)));
+        app_i->SetStartTime(Seconds(appStartTime));
         app_i->SetStopTime(Seconds(simTime));
         carNodes.Get(i)->AddApplication(app_i);
+        carApps.push_back(app_i);
     }
     
     // Install applications on pedestrians
+    std::vector<Ptr<PedApplication>> pedApps;
     for (uint32_t i = 0; i < pedestrianNodes.GetN(); ++i) {
         // Activate dedicated bearer for the pedestrian
-        Ptr<NetDevice> ueDevice = pedNetDev.Get(i);
-        nrHelper->ActivateDedicatedEpsBearer(ueDevice, bearer, tft);
+        if (!abstractRadio) {
+            Ptr<NetDevice> ueDevice = pedNetDev.Get(i);
+            nrHelper->ActivateDedicatedEpsBearer(ueDevice, bearer, tft);
+        }
         
         // Create and install pedestrian application
         Ptr<PedApplication> udpPed_i = CreateObject<PedApplication>();
-        udpPed_i->SetStartTime(Seconds(0));
+        udpPed_i->SetStartTime(Seconds(appStartTime));
         udpPed_i->SetStopTime(Seconds(simTime));
         pedestrianNodes.Get(i)->AddApplication(udpPed_i);
+        pedApps.push_back(udpPed_i);
         
         // Store gNB IP in global variable
         Ptr<Ipv4> gNbIpv4 = pgw->GetObject<Ipv4>();
@@ -448,16 +713,128 @@ int main(int argc, char* argv[])
         gNb_ip = gNbIaddr.GetLocal();
     }
     
+    // Long-lived random streams of the applications, numbered after the radio ones.
+    // The request generators (arrivals and per-request draws of the edge choices) use a
+    // dedicated block, so that runs with the same RngRun send the same requests whatever the
+    // strategy, the radio model or the number of vehicles (common random numbers).
+    auto assignApplicationStreams = [&]() {
+        randomStream += udpEdge->AssignStreams(randomStream);
+        for (Ptr<CarApplication> app : carApps) {
+            randomStream += app->AssignStreams(randomStream);
+        }
+        int64_t requestStream = REQUEST_STREAM_BASE;
+        for (Ptr<PedApplication> app : pedApps) {
+            requestStream += app->AssignStreams(requestStream);
+        }
+    };
+    assignApplicationStreams();
+    
     // Uncomment to enable application-level logging
     // LogComponentEnable("EdgeApplication", LOG_LEVEL_INFO);
     // LogComponentEnable("CloudApplication", LOG_LEVEL_INFO);
     // LogComponentEnable("PedApplication", LOG_LEVEL_INFO);
     // LogComponentEnable("CarApplication", LOG_LEVEL_INFO);
     
+    //-------------------------------------------------------------------------
+    // Outputs of a run (set up in each replication in replication server mode)
+    //-------------------------------------------------------------------------
+    auto setupOutputs = [&](const std::string& folder, const std::string& strategy) {
+        // Keep one buffered file per trace kind open for the whole run
+        TraceSinkRegistry::Open(folder, simType,
+                                traceFormat == "binary" ? TRACE_FORMAT_BINARY : TRACE_FORMAT_CSV);
+        if (traceAsync) {
+            TraceSinkRegistry::EnableAsync(traceRingSize, traceDropWhenFull ? TRACE_FULL_DROP : TRACE_FULL_BLOCK);
+        }
+        // One tasks_ row per request, written before the sinks are closed
+        Simulator::ScheduleDestroy(&TaskRegistry::Write);
+        Simulator::ScheduleDestroy(&TraceSinkRegistry::Close);
+        
+        // Streaming offloading latency histograms, mergeable across replications
+        if (latencyHistograms) {
+            LatencyHistograms::Enable(strategy, simType);
+            Simulator::ScheduleDestroy(&LatencyHistograms::Dump,
+                                       folder + "/latency_histograms_" + simType + ".hist");
+        }
+        
+        // Heap allocations once the packet pools are filled
+        if (allocationStats) {
+            Simulator::Schedule(Seconds(appStartTime + 1) - Now(), &AllocationCounter::Mark);
+            Simulator::ScheduleDestroy(&AllocationCounter::Dump,
+                                       folder + "/allocations_" + simType + ".csv");
+        }
+        
+        // Wall-clock profile of this run (a forked replication starts from zero)
+        if (profileEvents) {
+            EventProfiler::Reset();
+            Simulator::ScheduleDestroy(&EventProfiler::Dump,
+                                       folder + "/event_profile_" + simType, profileTop);
+        }
+        
+        // Sequential stopping: simTime is the upper bound of the run
+        if (stopPrecision > 0) {
+            ConvergenceController::Enable(stopPrecision, stopConfidence, stopBatchSize, stopMinBatches,
+                                          stopMinShare, Seconds(stopCheckInterval), Seconds(drainTime));
+            Simulator::ScheduleDestroy(&ConvergenceController::Dump,
+                                       folder + "/convergence_" + simType + ".csv");
+        }
+        
+        // Cost of the run, from here to the end of the outputs scheduled above
+        if (runStats) {
+            RunStats::Mark();
+            Simulator::ScheduleDestroy(&RunStats::Dump, folder + "/run_stats_" + simType + ".csv");
+        }
+        
+        // Edge worker and cloud instance statistics
+        Simulator::ScheduleDestroy(&EdgeApplication::DumpWorkerStats, udpEdge,
+                                   folder + "/edge_workers_" + simType + ".csv");
+        Simulator::ScheduleDestroy(&CloudApplication::DumpInstanceStats, udpCloud,
+                                   folder + "/cloud_instances_" + simType + ".csv");
+    };
+    
     //-------------------------------------------------------------------------
     // Run the simulation
     //-------------------------------------------------------------------------
-    Simulator::Stop(Seconds(simTime));
+    if (!forkMode) {
+        setupOutputs(outputDataCsv, chosenStrategy);
+        Simulator::Stop(Seconds(simTime));
+        Simulator::Run();
+        Simulator::Destroy();
+        return 0;
+    }
+    
+    // Replication server: build the scenario and attach the UEs once...
+    Simulator::Stop(Seconds(forkWarmup));
+    Simulator::Run();
+    
+    // ...then continue from this state in one child process per variant
+    std::vector<ReplicationVariant> variants = ParseReplicationVariants(forkVariants);
+    uint32_t failures = 0;
+    int variantIndex = ForkReplications(variants, forkJobs, failures);
+    if (variantIndex < 0) {
+        Simulator::Destroy();
+        return failures > 0 ? 1 : 0;
+    }
+    const ReplicationVariant& variant = variants[variantIndex];
+    
+    // Reseed: new streams use the variant run, and the radio and application streams are recreated with it
+    RngSeedManager::SetRun(variant.run);
+    randomStream = 1;
+    if (!abstractRadio) {
+        randomStream += nrHelper->AssignStreams(gNbNetDev, randomStream);
+        randomStream += nrHelper->AssignStreams(pedNetDev, randomStream);
+        randomStream += nrHelper->AssignStreams(carNetDev, randomStream);
+    } else {
+        randomStream += abstractRadioHelper->AssignStreams(randomStream);
+    }
+    assignApplicationStreams();
+    
+    chosen_strategy = variant.strategy;
+    std::string variantFolder = outputDataCsv + "/" + GetReplicationFolder(variant);
+    SystemPath::MakeDirectories(variantFolder);
+    output_data_csv = variantFolder;
+    setupOutputs(variantFolder, variant.strategy);
+    
+    Simulator::Stop(Seconds(simTime - forkWarmup));
     Simulator::Run();
     Simulator::Destroy();
     
@@ -0,0 +1,157 @@
+"""
+SUMO FCD to Binary Waypoint Trace
+
+Converts the SUMO floating car data output (sumo --fcd-output) into the
+binary per-vehicle waypoint trace read by WaypointTraceMobilityHelper
+(waypoint-trace.h), which CoE uses when --traceFile ends in .wpt.
+
+Vehicles are numbered in order of first appearance in the FCD file, as
+traceExporter.py numbers the node_(i) of the ns-2 trace, so the .wpt and the
+.tcl traces of the same FCD file describe the same vehicles. Each FCD sample
+becomes one waypoint (time, x, y).
+
+The FCD file is streamed, so memory grows with the number of waypoints
+(12 bytes each), not with the XML size.
+
+With --tolerance, runs of samples on a straight line at constant speed (e.g.
+the 100 ms SUMO steps along a Manhattan segment) are merged into a single
+waypoint-to-waypoint segment: a sample is dropped when the position
+interpolated at its time between the kept waypoints is within the tolerance
+of the sampled one. Since the mobility models interpolate linearly between
+waypoints, the reported maximum error is the largest position error at any
+time. An existing .wpt can be compressed the same way.
+
+Usage:
+    python fcd_to_waypoints.py trace.xml trace.wpt [--tolerance METERS]
+    python fcd_to_waypoints.py trace.wpt compressed.wpt --tolerance METERS
+"""
+import argparse
+import array
+import math
+import struct
+import sys
+import xml.etree.ElementTree as ET
+
+MAGIC = b'COEWPT1\0'
+HEADER = struct.Struct('<8sIIQ')        # WaypointTraceHeader
+VEHICLE = struct.Struct('<QII')         # WaypointTraceVehicle
+
+
+def read_fcd(fcd_file):
+    """Per-vehicle arrays of time, x, y in order of first appearance"""
+    vehicles = {}
+    for _, element in ET.iterparse(fcd_file, events=('end',)):
+        if element.tag != 'timestep':
+            continue
+        time = float(element.get('time'))
+        for vehicle in element.iter('vehicle'):
+            samples = vehicles.get(vehicle.get('id'))
+            if samples is None:
+                samples = vehicles[vehicle.get('id')] = array.array('f')
+            samples.extend((time, float(vehicle.get('x')), float(vehicle.get('y'))))
+        element.clear()
+    return list(vehicles.values())
+
+
+def read_waypoints(wpt_file):
+    with open(wpt_file, 'rb') as f:
+        magic, n_vehicles, _, n_waypoints = HEADER.unpack(f.read(HEADER.size))
+        if magic != MAGIC:
+            sys.exit(wpt_file + ' is not a waypoint trace')
+        index = [VEHICLE.unpack(f.read(VEHICLE.size)) for _ in range(n_vehicles)]
+        samples = array.array('f')
+        samples.fromfile(f, 3 * n_waypoints)
+    if sys.byteorder != 'little':
+        samples.byteswap()
+    return [samples[3 * first:3 * (first + count)] for first, count, _ in index]
+
+
+def interpolation_error(samples, start, end, i):
+    """Distance of sample i from the interpolation between samples start and end"""
+    t0, x0, y0 = samples[3 * start:3 * start + 3]
+    t1, x1, y1 = samples[3 * end:3 * end + 3]
+    t, x, y = samples[3 * i:3 * i + 3]
+    fraction = (t - t0) / (t1 - t0) if t1 > t0 else 0.0
+    return math.hypot(x0 + (x1 - x0) * fraction - x, y0 + (y1 - y0) * fraction - y)
+
+
+def segment_error(samples, start, end):
+    return max([0.0] + [interpolation_error(samples, start, end, i) for i in range(start + 1, end)])
+
+
+def compress(samples, tolerance):
+    """Keep the waypoints needed to stay within tolerance; returns (samples, max error)"""
+    n = len(samples) // 3
+    kept = [0]
+    max_error = 0.0
+    start = 0
+    while start < n - 1:
+        # Longest segment from start within tolerance: gallop, then bisect
+        good = start + 1
+        step = 1
+        bad = None
+        while bad is None:
+            candidate = min(good + step, n - 1)
+            if segment_error(samples, start, candidate) <= tolerance:
+                good = candidate
+                step *= 2
+                if good == n - 1:
+                    break
+            else:
+                bad = candidate
+        while bad is not None and bad - good > 1:
+            middle = (good + bad) // 2
+            if segment_error(samples, start, middle) <= tolerance:
+                good = middle
+            else:
+                bad = middle
+        max_error = max(max_error, segment_error(samples, start, good))
+        kept.append(good)
+        start = good
+
+    compressed = array.array('f')
+    for i in kept:
+        compressed.extend(samples[3 * i:3 * i + 3])
+    return compressed, max_error
+
+
+def write_waypoints(vehicles, output_file):
+    n_waypoints = sum(len(samples) // 3 for samples in vehicles)
+    with open(output_file, 'wb') as f:
+        f.write(HEADER.pack(MAGIC, len(vehicles), 0, n_waypoints))
+        first = 0
+        for samples in vehicles:
+            f.write(VEHICLE.pack(first, len(samples) // 3, 0))
+            first += len(samples) // 3
+        for samples in vehicles:
+            if sys.byteorder != 'little':
+                samples.byteswap()
+            samples.tofile(f)
+    return n_waypoints
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert SUMO FCD output to a binary waypoint trace')
+    parser.add_argument('input', help='SUMO FCD XML file, or .wpt file to compress')
+    parser.add_argument('output', help='waypoint trace to write (.wpt)')
+    parser.add_argument('--tolerance', type=float, default=None,
+                        help='merge constant-velocity segments within this position error (m)')
+    args = parser.parse_args()
+
+    vehicles = read_waypoints(args.input) if args.input.endswith('.wpt') else read_fcd(args.input)
+    if args.tolerance is not None:
+        before = sum(len(samples) // 3 for samples in vehicles)
+        max_error = 0.0
+        for v, samples in enumerate(vehicles):
+            vehicles[v], error = compress(samples, args.tolerance)
+            max_error = max(max_error, error)
+        after = sum(len(samples) // 3 for samples in vehicles)
+        print(f'{before - after} of {before} waypoints removed '
+              f'({100.0 * (before - after) / max(before, 1):.1f}% fewer course changes), '
+              f'max position error {max_error:.3f} m')
+    n_waypoints = write_waypoints(vehicles, args.output)
+    print(f'{len(vehicles)} vehicles, {n_waypoints} waypoints written to {args.output}')
+
+
+if __name__ == '__main__':
+    main()
@@ -3,6 +3,7 @@ export SUMO_HOME=/usr/share/sumo
 export HOME=$HOME:$SUMO_HOME
 ## Paths scripts
 PWD_TOOL=/usr/share/sumo/tools
+PWD_SCRIPTS=$(dirname "$(readlink -f "$0")")
 ## Variables
 NB_Cars=(10 20 40 60 80 100)
 NB_Runs=(0 1 2 3 4 5 6 7 8 9 10 11)
@@ -10,6 +11,7 @@ NB_grid=2 ### for value of x grids will be x-1
 ### carFM is the car following model
 carFM=Krauss ### Krauss, IDM, ACC
 Simulation_duration=120
+Waypoint_tolerance=0.1 ### max position error (m) when merging constant-velocity waypoints
 
 ##m/sec 
 declare -A speeds
@@ -47,6 +49,9 @@ do
 			echo "....... -> Generate tr file for configuration ${NB_Cars[$i]} cars / iteration $run"
 			ns2traceFile=$current_directory/manhattan_${carFM}_${NB_Cars[$i]}_$run.tcl
 			$PWD_TOOL/traceExporter.py --fcd-input $sumo_trace_file --ns2mobility-output $ns2traceFile 
+			echo "....... -> Generate binary waypoint file for configuration ${NB_Cars[$i]} cars / iteration $run"
+			waypointFile=$current_directory/manhattan_${carFM}_${NB_Cars[$i]}_$run.wpt
+			python3 $PWD_SCRIPTS/fcd_to_waypoints.py $sumo_trace_file $waypointFile --tolerance $Waypoint_tolerance
 		done
 	done
 done
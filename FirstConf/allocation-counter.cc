@@ -0,0 +1,123 @@
+/**
+ * Implementation of the allocation counter
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include "allocation-counter.h"
+#include "task-registry.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+namespace {
+
+// Off by default: runs that do not measure allocations do not pay the atomic increment
+std::atomic<bool> g_counting(false);
+
+// Also counts the allocations of the asynchronous trace writer thread
+std::atomic<uint64_t> g_allocations(0);
+
+void*
+CountedAllocate(std::size_t size)
+{
+  if (g_counting.load(std::memory_order_relaxed))
+  {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+} // namespace
+
+void*
+operator new(std::size_t size)
+{
+  return CountedAllocate(size);
+}
+
+void*
+operator new[](std::size_t size)
+{
+  return CountedAllocate(size);
+}
+
+void
+operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete[](void* p) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete[](void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("AllocationCounter");
+
+uint64_t AllocationCounter::s_mark = 0;
+uint32_t AllocationCounter::s_tasks = 0;
+double AllocationCounter::s_markTime = 0;
+
+void
+AllocationCounter::Enable()
+{
+  g_counting.store(true, std::memory_order_relaxed);
+}
+
+uint64_t
+AllocationCounter::Get()
+{
+  return g_allocations.load(std::memory_order_relaxed);
+}
+
+void
+AllocationCounter::Mark()
+{
+  s_mark = Get();
+  s_markTime = Simulator::Now().GetSeconds();
+  s_tasks = TaskRegistry::GetN();
+}
+
+void
+AllocationCounter::Dump(std::string filename)
+{
+  uint64_t allocations = Get() - s_mark;
+  uint32_t tasks = TaskRegistry::GetN() - s_tasks;
+
+  std::ofstream file(filename);
+  if (!file.is_open())
+  {
+    NS_LOG_ERROR("Cannot open allocation file " << filename);
+    return;
+  }
+  file << "from_s,to_s,allocations,requests,allocations_per_request\n";
+  file << s_markTime << "," << Simulator::Now().GetSeconds() << ","
+       << allocations << "," << tasks << ","
+       << (tasks > 0 ? static_cast<double>(allocations) / tasks : 0) << "\n";
+}
+
+} // namespace ns3
@@ -0,0 +1,58 @@
+/**
+ * AllocationCounter - Process-wide count of heap allocations
+ *
+ * allocation-counter.cc replaces the global operator new of the CoE
+ * executable with one that counts the allocations once Enable() was called
+ * (--allocationStats and --microbenchmark); otherwise it only tests a flag
+ * before malloc. Reading the counter around a part of the run tells how many
+ * allocations it made: the simulation reports the
+ * allocations per request after the warm-up (--allocationStats), which should
+ * only be those of the ns-3 stack (packets in flight, events, socket
+ * addresses), the applications reusing their random streams, error model and
+ * packets.
+ */
+
+#ifndef NS3_ALLOCATION_COUNTER_H
+#define NS3_ALLOCATION_COUNTER_H
+
+#include <cstdint>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \brief Counter of the operator new calls of the process
+ */
+class AllocationCounter
+{
+public:
+  /**
+   * \brief Start counting the heap allocations
+   */
+  static void Enable();
+
+  /**
+   * \return Number of heap allocations since Enable()
+   */
+  static uint64_t Get();
+
+  /**
+   * \brief Remember the current count as the start of the measurement
+   */
+  static void Mark();
+
+  /**
+   * \brief Write the allocations since Mark() and per registered request
+   * \param filename Output file, overwritten
+   */
+  static void Dump(std::string filename);
+
+private:
+  static uint64_t s_mark;   ///< Count at Mark()
+  static double s_markTime; ///< Simulation time of Mark(), s
+  static uint32_t s_tasks;  ///< Registered requests at Mark()
+};
+
+} // namespace ns3
+
+#endif // NS3_ALLOCATION_COUNTER_H
@@ -15,7 +15,10 @@
 #include "car-application.h"
 #include "car-data-tag.h"
 #include "packet-data-tag.h"
+#include "task-registry.h"
 #include "globals.h"
+#include "trace-sink.h"
+#include "event-profiler.h"
 
 // Terminal color codes for logging
 #define RED_CODE "\033[91m"
@@ -47,14 +50,22 @@ CarApplication::GetInstanceTypeId() const
 }
 
 CarApplication::CarApplication()
+  : m_beacon_offset(CreateObject<UniformRandomVariable>()),
+    m_error_model(CreateObject<RateErrorModel>()),
+    m_response_pool(4000),
+    m_beacon_pool(1000)
 {
     m_broadcast_time = MilliSeconds(100);  // Broadcast interval: every 100ms
     m_packetSize = 1000;                   // Default packet size: 1000 bytes
-    m_time_limit = Seconds(0.5);           // Time limit for neighbor list
+    m_time_limit = Seconds(neighbor_timeout); // Time limit for neighbor list
     m_port0 = 9999;                        // Port for communication with pedestrians
     m_port1 = 7777;                        // Port for receiving packets
     m_port_beacon = 8888;                  // Port for beacon broadcasts
     m_sync = true;                         // Enable synchronous beaconing by default
+    m_beacon_mode = BEACON_FIXED;
+    m_keep_alive = Seconds(neighbor_timeout / 2); // One beacon may be lost before the edge forgets the vehicle
+    m_last_beacon = Seconds(0);
+    m_last_queue_state = 0;
     
     // Set maximum queue size based on global configuration
     m_car_queue->SetMaxSize(QueueSize(std::to_string(vehicle_queue_length) + "p"));
@@ -65,25 +76,27 @@ CarApplication::~CarApplication()
     // No resources to clean up
 }
 
+int64_t
+CarApplication::AssignStreams(int64_t stream)
+{
+    m_beacon_offset->SetStream(stream);
+    return 1 + m_error_model->AssignStreams(stream + 1);
+}
+
 void 
 CarApplication::DlDataSinr(uint16_t cellId, uint16_t rnti, double avgSinr, uint16_t bwpId, uint8_t streamId)
 {
     // Log signal quality data to CSV file for analysis
-    std::ofstream logFile;
-    std::string filename = output_data_csv + "/total_data_SINR_received_from_edge_packets_" + sim_type + ".csv";
-    logFile.open(filename, std::ofstream::app);
-    
-    if (logFile.is_open()) {
-        logFile << m_nodeId << ","
-                << cellId << ","
-                << rnti << ","
-                << 10 * log10(avgSinr) << ","
-                << bwpId << ","
-                << "," // Extra comma in original code
-                << streamId << ","
-                << Now().GetSeconds() << "\n";
-        logFile.close();
-    }
+    TraceRecord record(TRACE_SINR);
+    record.AddUint(m_nodeId)
+          .AddUint(cellId)
+          .AddUint(rnti)
+          .AddDouble(10 * log10(avgSinr))
+          .AddUint(bwpId)
+          .AddText("") // Extra comma in original code
+          .AddUint(streamId)
+          .AddSeconds(Now());
+    TraceSinkRegistry::Write(record);
 }
 
 void 
@@ -108,76 +121,83 @@ CarApplication::StartApplication()
     SetupReceiveSocket(m_recv_socket1, m_port1);
     m_recv_socket1->SetRecvCallback(MakeCallback(&CarApplication::ReceivePacket, this));
     
-    // Set up SINR monitoring
+    // Set up SINR monitoring (there is no NR device with the abstract radio model)
     Ptr<NrUeNetDevice> ueNetDevice = DynamicCast<NrUeNetDevice>(GetNode()->GetDevice(0)); 
-    Ptr<NrUePhy> phy = ueNetDevice->GetPhy(0);
-    phy->TraceConnectWithoutContext("DlDataSinr", MakeCallback(&CarApplication::DlDataSinr, this));
+    if (ueNetDevice) {
+        Ptr<NrUePhy> phy = ueNetDevice->GetPhy(0);
+        phy->TraceConnectWithoutContext("DlDataSinr", MakeCallback(&CarApplication::DlDataSinr, this));
+    }
     
     // Create sending socket
     m_send_socket = Socket::CreateSocket(GetNode(), tid);
     
+    if (beacon_mode == "delta") {
+        m_beacon_mode = BEACON_DELTA;
+    } else if (beacon_mode == "adaptive") {
+        m_beacon_mode = BEACON_ADAPTIVE;
+    }
+    m_last_beacon = Now() - m_keep_alive;  // The first check always sends a beacon
+    
     // Schedule first beacon with randomized offset to avoid collisions
-    Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable>();
-    Time randomOffset = MicroSeconds(rand->GetValue(50, 200));
+    Time randomOffset = MicroSeconds(m_beacon_offset->GetValue(50, 200));
     Simulator::Schedule(m_broadcast_time + randomOffset, &CarApplication::BeaconInformation, this, m_sync);
 }
 
 void 
-CarApplication::HandleDequeue()
+CarApplication::StartTask()
 {
-    // Peek at the front packet in the queue without removing it
+    // The head of the queue stays queued (and advertised) until its elaboration ends
     Ptr<const Packet> queuedPacket = m_car_queue->Peek();
+    double elaborationTime = 0;
+    Ipv4Address destination;
     
     // Create a new packet for response
-    Ptr<Packet> responsePacket = Create<Packet>(4000);    
+    Ptr<Packet> responsePacket = m_response_pool.Acquire();
     
-    if (queuedPacket) {
-        double elaborationTime = 0;
-        Ipv4Address destination;
+    // Extract metadata from the queued packet
+    PacketDataTag tag;
+    if (queuedPacket->PeekPacketTag(tag)) {   
+        // Calculate processing time based on workload and computation capacity
+        uint32_t task = tag.GetTaskId();
+        elaborationTime = TaskRegistry::GetWorkload(task) / car_computation_capacity;
+        destination = TaskRegistry::GetSourcePedestrianIPv4Address(task);
         
-        // Extract metadata from the queued packet
-        PacketDataTag tag;
-        if (queuedPacket->PeekPacketTag(tag)) {   
-            // Calculate processing time based on workload and computation capacity
-            elaborationTime = tag.GetWorkload() / car_computation_capacity;
-            destination = tag.GetSourcePedestrianIPv4Address();
-            
-            // Update tag with processing information
-            tag.SetElaborationTime(Seconds(elaborationTime));
-            tag.SetQueueingTime(Seconds(Now().GetSeconds()));
-            tag.SetIsFromVCCToPed(1); // 1 indicates packet from vehicle to pedestrian
-            
-            // Attach tag to response packet
-            responsePacket->AddPacketTag(tag);
-            
-            NS_LOG_INFO("Car schedule send() message to pedestrian");
-            
-            // Schedule packet sending after processing
-            Simulator::Schedule(Seconds(elaborationTime), &CarApplication::SendPacket, 
-                               this, responsePacket, destination, m_port0);
-            
-            // Schedule dequeuing after processing
-            Simulator::Schedule(Seconds(elaborationTime), 
-                               &ns3::DropTailQueue<Packet>::Dequeue, m_car_queue);
-            
-            // Schedule async beacon to signal resources are free
-            Simulator::Schedule(Seconds(elaborationTime), 
-                               &CarApplication::BeaconInformation, this, false);
-            
-            // Continue processing queue after this packet is done
-            Simulator::Schedule(Seconds(elaborationTime), 
-                               &CarApplication::HandleDequeue, this);
-        } else {
-            NS_LOG_INFO("Problem with tag in a car in function HandleDequeue()");
-        }
+        // Record processing information
+        TaskRegistry::SetElaborationTime(task, Seconds(elaborationTime));
+        TaskRegistry::SetQueueingTime(task, Now());
+        TaskRegistry::SetIsFromVCCToPed(task, 1); // 1 indicates packet from vehicle to pedestrian
+        
+        // Attach task ID to response packet
+        responsePacket->AddPacketTag(tag);
     } else {
-        NS_LOG_INFO("No packet in a car in function HandleDequeue()");
-    } 
+        NS_LOG_INFO("Problem with tag in a car in function StartTask()");
+    }
+    
+    // One event per task: reply, dequeue, signal the free slot and start the next task
+    Simulator::Schedule(Seconds(elaborationTime), &CarApplication::FinishTask, 
+                        this, responsePacket, destination);
+}
+
+void 
+CarApplication::FinishTask(Ptr<Packet> responsePacket, Ipv4Address destination)
+{
+    EventProfiler::Scope profile("CarApplication::FinishTask");
+    NS_LOG_INFO("Car sends the response to the pedestrian");
+    SendPacket(responsePacket, destination, m_port0);
+    m_car_queue->Dequeue();
+    
+    // Async beacon to signal resources are free
+    BeaconInformation(false);
+    
+    if (!m_car_queue->IsEmpty()) {
+        StartTask();
+    }
 }
 
 void
 CarApplication::ReceivePacket(Ptr<Socket> socket)
 {  
+    EventProfiler::Scope profile("CarApplication::ReceivePacket");
     Ptr<Packet> packet;
     Address from;
     
@@ -186,44 +206,23 @@ CarApplication::ReceivePacket(Ptr<Socket> socket)
                    << " : Received a packet of Size:" << packet->GetSize());
         
         // Check packet integrity
-        Ptr<ErrorModel> rem = CreateObject<RateErrorModel>();
-        if (rem->IsCorrupt(packet) || !packet) {
+        if (m_error_model->IsCorrupt(packet) || !packet) {
             NS_LOG_INFO("Packet is corrupt in a car");
             continue;
         } 
         
-        // Create a new packet to avoid pointer issues
-        Ptr<Packet> packetCopy = Create<Packet>(packet->GetSize());
-        packetCopy->RemoveAllPacketTags();
-        
         // Process packet metadata
         PacketDataTag tag;
         if (packet->PeekPacketTag(tag)) {   
-            // Update tag with current time
-            tag.SetUplinkTime(Seconds(Now().GetSeconds()));
-            packetCopy->AddPacketTag(tag);
+            // Record the arrival time
+            TaskRegistry::SetUplinkTime(tag.GetTaskId(), Now());
             
-            // Log packet reception to CSV file for analysis
-            std::ofstream logFile;
-            std::string filename = output_data_csv + "/total_VCC_received_from_edge_packets_" + sim_type + ".csv";
-            logFile.open(filename, std::ofstream::app);
+            // The socket hands over its own copy: queue it with the task ID only
+            packet->RemoveAllPacketTags();
+            packet->AddPacketTag(tag);
             
-            if (logFile.is_open() && packetCopy->PeekPacketTag(tag)) {
-                logFile << tag.GetNodeId() << ","
-                       << packetCopy->GetSize() << ","
-                       << tag.GetInitialTime() << ","
-                       << Now().GetSeconds() << ","
-                       << tag.GetWhere() << ","
-                       << request_rate << ","
-                       << cars_number << ","
-                       << pedestrians_number << ","
-                       << edge_computation_capacity << ","
-                       << car_computation_capacity << ","
-                       << tag.GetWorkload() << ","
-                       << tag.GetCarsInVCC() << ","
-                       << vehicle_queue_length << "\n";
-                logFile.close();
-            }
+            // Log packet reception to CSV file for analysis
+            TraceReceivedPacket(TRACE_VCC_RECEIVED_PACKETS, packet, tag.GetTaskId());
         } else {
             NS_LOG_INFO("Problem with tag in a car in function ReceivePacket()");
             continue;
@@ -232,43 +231,42 @@ CarApplication::ReceivePacket(Ptr<Socket> socket)
         // Handle packet based on queue state
         if (m_car_queue->GetNPackets() == 0) {
             // Queue is empty - enqueue packet and process immediately
-            Simulator::ScheduleNow(&ns3::DropTailQueue<Packet>::Enqueue, m_car_queue, packetCopy);
-            Simulator::ScheduleNow(&CarApplication::HandleDequeue, this);
-        } else if (m_car_queue->GetNPackets() > 0 && 
-                  m_car_queue->GetNPackets() < m_car_queue->GetMaxSize().GetValue()) {
+            m_car_queue->Enqueue(packet);
+            StartTask();
+        } else if (m_car_queue->GetNPackets() < m_car_queue->GetMaxSize().GetValue()) {
             // Queue has room - enqueue packet and update status
-            Simulator::ScheduleNow(&ns3::DropTailQueue<Packet>::Enqueue, m_car_queue, packetCopy);
+            m_car_queue->Enqueue(packet);
             Simulator::Schedule(MilliSeconds(5), &CarApplication::BeaconInformation, this, false);
         } else {
             // Queue is full - log dropped packet
             NS_LOG_INFO("A packet is sent with the full queue and it is deleted");
             
-            std::ofstream logFile;
-            std::string filename = output_data_csv + "/total_VCC_rejected_packets_cause_full_queue_" + sim_type + ".csv";
-            logFile.open(filename, std::ofstream::app);
-            
-            if (logFile.is_open() && packetCopy->PeekPacketTag(tag)) {
-                logFile << tag.GetNodeId() << ","
-                       << packetCopy->GetSize() << ","
-                       << tag.GetInitialTime() << ","
-                       << Now().GetSeconds() << ","
-                       << tag.GetWhere() << ","
-                       << request_rate << ","
-                       << cars_number << ","
-                       << pedestrians_number << ","
-                       << edge_computation_capacity << ","
-                       << car_computation_capacity << ","
-                       << tag.GetWorkload() << ","
-                       << tag.GetCarsInVCC() << ","
-                       << vehicle_queue_length << "\n";
-                logFile.close();
-            } else {
-                NS_LOG_INFO("ERROR: in function ReceivePacket() in tag");
-            }
+            TaskRegistry::SetStatus(tag.GetTaskId(), TASK_REJECTED);
+            TraceReceivedPacket(TRACE_VCC_REJECTED_PACKETS, packet, tag.GetTaskId());
         }
     }
 }
 
+void 
+CarApplication::TraceReceivedPacket(TraceKind kind, Ptr<const Packet> packet, uint32_t task)
+{
+    TraceRecord record(kind);
+    record.AddUint(TaskRegistry::GetNodeId(task))
+          .AddUint(packet->GetSize())
+          .AddTime(TaskRegistry::GetInitialTime(task))
+          .AddSeconds(Now())
+          .AddUint(TaskRegistry::GetWhere(task))
+          .AddDouble(request_rate)
+          .AddUint(cars_number)
+          .AddUint(pedestrians_number)
+          .AddDouble(edge_computation_capacity)
+          .AddDouble(car_computation_capacity)
+          .AddDouble(TaskRegistry::GetWorkload(task))
+          .AddUint(TaskRegistry::GetCarsInVCC(task))
+          .AddUint(vehicle_queue_length);
+    TraceSinkRegistry::Write(record);
+}
+
 void 
 CarApplication::SendPacket(Ptr<Packet> packet, Ipv4Address destination, uint16_t port)
 {
@@ -277,20 +275,56 @@ CarApplication::SendPacket(Ptr<Packet> packet, Ipv4Address destination, uint16_t
     m_send_socket->Send(packet);
 }
 
+bool
+CarApplication::BeaconChanged(Vector position) const
+{
+    // Anything the edge would not know without a new beacon
+    return m_car_queue->GetNPackets() != m_last_queue_state
+           || CalculateDistance(position, m_last_position) >= beacon_drift
+           || Now() - m_last_beacon >= m_keep_alive;
+}
+
+Time
+CarApplication::NextBeaconCheck(Vector position) const
+{
+    if (m_beacon_mode != BEACON_ADAPTIVE) {
+        return m_broadcast_time;
+    }
+    
+    // Time to cover the drift left since the last beacon at the current
+    // speed, between the fixed interval and the next keep-alive
+    Time keepAlive = Max(m_last_beacon + m_keep_alive - Now(), m_broadcast_time);
+    double remaining = beacon_drift - CalculateDistance(position, m_last_position);
+    double speed = GetNode()->GetObject<MobilityModel>()->GetVelocity().GetLength();
+    if (remaining <= 0) {
+        // Drift already reached, e.g. the beacon was withheld by a full queue
+        return m_broadcast_time;
+    }
+    if (speed <= 0 || speed * keepAlive.GetSeconds() <= remaining) {
+        return keepAlive;
+    }
+    return Max(Seconds(remaining / speed), m_broadcast_time);
+}
+
 void
 CarApplication::BeaconInformation(bool sync) 
 {
+    EventProfiler::Scope profile("CarApplication::BeaconInformation");
     NS_LOG_FUNCTION(this);
     
-    // Only send beacon if vehicle has available resources
-    if (m_car_queue->GetNPackets() < m_car_queue->GetMaxSize().GetValue()) {
+    // Only send beacon if vehicle has available resources; in the delta and adaptive
+    // modes, periodic beacons are skipped while the edge information is still valid
+    // (beacons triggered by the queue are always sent)
+    Vector position = GetNode()->GetObject<MobilityModel>()->GetPosition();
+    bool needed = m_beacon_mode == BEACON_FIXED || !sync || BeaconChanged(position);
+    if (needed && m_car_queue->GetNPackets() < m_car_queue->GetMaxSize().GetValue()) {
         // Create beacon packet
-        Ptr<Packet> packet = Create<Packet>(m_packetSize);
+        Ptr<Packet> packet = m_beacon_pool.Acquire();
         
         // Populate car data tag with vehicle status
         CarDataTag tag;
         tag.SetNodeId(GetNode()->GetId());
-        tag.SetPosition(GetNode()->GetObject<MobilityModel>()->GetPosition());
+        tag.SetPosition(position);
         tag.SetQueueState(m_car_queue->GetNPackets());
         tag.SetQueueMaxPackets(m_car_queue->GetMaxSize().GetValue());
         // Note: timestamp is set in the CarDataTag constructor
@@ -298,34 +332,33 @@ CarApplication::BeaconInformation(bool sync)
         // Attach tag to packet
         packet->AddPacketTag(tag);
         
-        // Log beacon information
-        std::ofstream logFile;
-        std::string filename = output_data_csv + "/total_VCC_beacons_" + sim_type + ".csv";
-        logFile.open(filename, std::ofstream::app);
+        m_last_beacon = Now();
+        m_last_position = position;
+        m_last_queue_state = tag.GetQueueState();
         
-        if (logFile.is_open()) {
-            logFile << tag.GetNodeId() << ","
-                   << packet->GetSize() << ","
-                   << tag.GetPosition() << ","
-                   << Now().GetSeconds() << ","
-                   << tag.GetQueueState() << ","
-                   << request_rate << ","
-                   << cars_number << ","
-                   << pedestrians_number << ","
-                   << edge_computation_capacity << ","
-                   << car_computation_capacity << ","
-                   << tag.GetQueueMaxPackets() << ","
-                   << vehicle_queue_length << "\n";
-            logFile.close();
-        }
+        // Log beacon information
+        TraceRecord record(TRACE_VCC_BEACONS);
+        record.AddUint(tag.GetNodeId())
+              .AddUint(packet->GetSize())
+              .AddPosition(tag.GetPosition())
+              .AddSeconds(Now())
+              .AddUint(tag.GetQueueState())
+              .AddDouble(request_rate)
+              .AddUint(cars_number)
+              .AddUint(pedestrians_number)
+              .AddDouble(edge_computation_capacity)
+              .AddDouble(car_computation_capacity)
+              .AddUint(tag.GetQueueMaxPackets())
+              .AddUint(vehicle_queue_length);
+        TraceSinkRegistry::Write(record);
         
         // Send beacon packet
-        Simulator::ScheduleNow(&CarApplication::SendPacket, this, packet, gNb_ip, m_port_beacon);
+        SendPacket(packet, gNb_ip, m_port_beacon);
     }
     
     // Schedule next periodic beacon if in synchronous mode
     if (sync) {
-        Simulator::Schedule(m_broadcast_time, &CarApplication::BeaconInformation, this, sync);
+        Simulator::Schedule(NextBeaconCheck(position), &CarApplication::BeaconInformation, this, sync);
     }
 }
 
@@ -4,11 +4,26 @@
 #include "ns3/application.h"
 #include "ns3/udp-socket.h"
 #include "ns3/drop-tail-queue.h"
+#include "ns3/vector.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/error-model.h"
 #include "packet-data-tag.h"
+#include "packet-pool.h"
+#include "trace-sink.h"
 #include <vector>
 
 namespace ns3 {
 
+/**
+ * \brief When the vehicles send their periodic beacons (global beacon_mode)
+ */
+enum BeaconMode
+{
+  BEACON_FIXED,     ///< Every Interval ("fixed")
+  BEACON_DELTA,     ///< Checked every Interval, sent on queue change, drift or keep-alive ("delta")
+  BEACON_ADAPTIVE   ///< As delta, checked at the time left to drift at the current speed ("adaptive")
+};
+
 /**
  * \brief Application for vehicle-to-vehicle and vehicle-to-infrastructure communication
  * 
@@ -24,8 +39,10 @@ public:
   virtual ~CarApplication();
   
   // Public methods
+  int64_t AssignStreams(int64_t stream);
   void BeaconInformation(bool sync);
-  void HandleDequeue();
+  void StartTask();
+  void FinishTask(Ptr<Packet> responsePacket, Ipv4Address destination);
   void ReceivePacket(Ptr<Socket> socket);
   void SendPacket(Ptr<Packet> packet, Ipv4Address destination, uint16_t port);
   void SetBroadcastInterval(Time interval);
@@ -40,6 +57,9 @@ private:
   // Private methods
   virtual void StartApplication();
   void SetupReceiveSocket(Ptr<Socket> socket, uint16_t port);
+  void TraceReceivedPacket(TraceKind kind, Ptr<const Packet> packet, uint32_t task);
+  bool BeaconChanged(Vector position) const;
+  Time NextBeaconCheck(Vector position) const;
   
   // Private members
   uint16_t m_port0;
@@ -51,6 +71,15 @@ private:
   uint32_t m_packetSize;       ///< Packet size in bytes
   Time m_time_limit;           ///< Time limit to keep neighbors in list
   bool m_sync;
+  BeaconMode m_beacon_mode;    ///< Beaconing mode, from the global beacon_mode
+  Time m_keep_alive;           ///< Longest time between two beacons in the delta and adaptive modes
+  Time m_last_beacon;          ///< Time of the last beacon sent
+  Vector m_last_position;      ///< Position advertised in the last beacon
+  uint32_t m_last_queue_state; ///< Queue state advertised in the last beacon
+  Ptr<UniformRandomVariable> m_beacon_offset; ///< Offset of the first beacon
+  Ptr<RateErrorModel> m_error_model;          ///< Integrity check of the received tasks
+  PacketPool m_response_pool;  ///< Responses of the tasks elaborated by the vehicle
+  PacketPool m_beacon_pool;    ///< Beacons, of m_packetSize bytes
 };
 
 } // namespace ns3
@@ -2,7 +2,8 @@
  * CloudApplication - Implementation of cloud server application for task offloading
  *
  * This class implements a cloud computing application that receives packets from
- * pedestrian nodes via edge servers, processes them based on computation capacity,
+ * pedestrian nodes via edge servers, processes them on a pool of server instances
+ * (one task at a time per instance, shared FIFO queue, optional autoscaling),
  * and returns results directly to the pedestrian nodes.
  */
 
@@ -15,9 +16,13 @@
 #include "ns3/ipv4-header.h"
 #include "ns3/udp-header.h"
 
+#include <fstream>
+
 #include "cloud-application.h"
 #include "globals.h"
 #include "packet-data-tag.h"
+#include "task-registry.h"
+#include "event-profiler.h"
 
 // Terminal color codes for logging
 #define PURPLE_CODE "\033[95m"
@@ -53,7 +58,10 @@ CloudApplication::GetInstanceTypeId() const
 
 CloudApplication::CloudApplication()
   : m_port1(7777),
-    m_port_sending(9999)
+    m_port_sending(9999),
+    m_active(0),
+    m_pending(0),
+    m_dropped(0)
 {
   // Nothing else to initialize
 }
@@ -84,11 +92,34 @@ CloudApplication::StartApplication()
   
   // Create sending socket
   m_send_socket = Socket::CreateSocket(GetNode(), tid);
+  
+  // Start the initial instances behind the shared queue
+  NS_ABORT_MSG_IF(cloud_instances == 0, "The cloud needs at least one instance");
+  m_queue = CreateObject<DropTailQueue<Packet>>();
+  m_queue->SetMaxSize(QueueSize(QueueSizeUnit::PACKETS, cloud_queue_size));
+  for (uint32_t i = 0; i < cloud_instances; i++)
+  {
+    AddInstance();
+  }
+  
+  // Autoscaling is enabled by allowing more instances than the initial ones
+  if (cloud_max_instances > cloud_instances)
+  {
+    m_scale_event = Simulator::Schedule(Seconds(cloud_scale_interval), 
+                                        &CloudApplication::EvaluateScaling, this);
+  }
+}
+
+void 
+CloudApplication::StopApplication()
+{
+  m_scale_event.Cancel();
 }
 
 void 
 CloudApplication::HandleReadOne(Ptr<Socket> socket)
 {
+  EventProfiler::Scope profile("CloudApplication::HandleReadOne");
   NS_LOG_FUNCTION(this << socket);
   Ptr<Packet> packet;
   Address from;
@@ -101,36 +132,218 @@ CloudApplication::HandleReadOne(Ptr<Socket> socket)
                 << Now().GetSeconds() << END_CODE);
     NS_LOG_INFO(packet->ToString());
     
-    // Extract destination address from packet tag
-    Ipv4Address pedestrianAddress;
-    
-    // Process packet metadata
+    // Record the arrival; queueing and elaboration are set when an instance starts the task
     PacketDataTag tag;
-    if (packet->RemovePacketTag(tag))
+    packet->PeekPacketTag(tag);
+    TaskRegistry::SetUplinkTime(tag.GetTaskId(), Now());
+    
+    // Start on an idle instance, or wait in the shared queue
+    uint32_t instance;
+    if (m_queue->IsEmpty() && GetIdleInstance(instance))
+    {
+      StartTask(instance, packet);
+    }
+    else if (!m_queue->Enqueue(packet))
     {
-      // Update tag with processing information
-      tag.SetUplinkTime(Seconds(Now().GetSeconds()));
-      tag.SetElaborationTime(Seconds(tag.GetWorkload() / cloud_computation_capacity));
-      tag.SetQueueingTime(Seconds(Now().GetSeconds()));
-      
-      // Get pedestrian address for return packet
-      pedestrianAddress = tag.GetSourcePedestrianIPv4Address();
-      
-      // Reattach the updated tag
-      packet->AddPacketTag(tag);
+      m_dropped++;
+      TaskRegistry::SetStatus(tag.GetTaskId(), TASK_DROPPED);
+      NS_LOG_INFO(RED_CODE << "Cloud queue full, task dropped at time " << Now().GetSeconds() << END_CODE);
     }
+  }
+}
+
+void 
+CloudApplication::StartTask(uint32_t instance, Ptr<Packet> packet)
+{
+  Ipv4Address pedestrianAddress;
+  double elaborationTime = 0;
+  
+  // Elaboration depends on the task workload, not on the packet size
+  PacketDataTag tag;
+  if (packet->PeekPacketTag(tag))
+  {
+    uint32_t task = tag.GetTaskId();
+    elaborationTime = TaskRegistry::GetWorkload(task) / cloud_computation_capacity;
+    TaskRegistry::SetElaborationTime(task, Seconds(elaborationTime));
+    TaskRegistry::SetQueueingTime(task, Now());
     
-    // Create a copy of the packet for sending
-    Ptr<Packet> packetCopy = packet->Copy();
+    // Get pedestrian address for return packet
+    pedestrianAddress = TaskRegistry::GetSourcePedestrianIPv4Address(task);
+  }
+  else
+  {
+    NS_LOG_INFO("ERROR with TAG in Cloud StartTask()");
+  }
+  
+  Instance& server = m_instances[instance];
+  server.busy = true;
+  server.busySince = Now();
+  server.tasks++;
+  
+  // One event per task: the response leaves when the instance completes it
+  Simulator::Schedule(Seconds(elaborationTime), &CloudApplication::FinishTask, 
+                      this, instance, packet, pedestrianAddress);
+}
+
+void 
+CloudApplication::FinishTask(uint32_t instance, Ptr<Packet> packet, Ipv4Address destination)
+{
+  EventProfiler::Scope profile("CloudApplication::FinishTask");
+  SendPacket(packet, destination, m_port_sending);
+  
+  Instance& server = m_instances[instance];
+  server.busy = false;
+  server.busyTime += Now() - server.busySince;
+  
+  // A retiring instance leaves; otherwise it takes the head of the shared queue
+  if (server.retiring)
+  {
+    RetireInstance(instance);
+  }
+  else if (!m_queue->IsEmpty())
+  {
+    StartTask(instance, m_queue->Dequeue());
+  }
+}
+
+bool 
+CloudApplication::GetIdleInstance(uint32_t& instance) const
+{
+  for (uint32_t i = 0; i < m_instances.size(); i++)
+  {
+    if (m_instances[i].active && !m_instances[i].busy)
+    {
+      instance = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+void 
+CloudApplication::AddInstance()
+{
+  Instance server;
+  server.active = true;
+  server.busy = false;
+  server.retiring = false;
+  server.started = Now();
+  server.tasks = 0;
+  m_instances.push_back(server);
+  m_active++;
+  
+  NS_LOG_INFO(GREEN_CODE << "Cloud instance " << m_instances.size() - 1 << " in service at time " 
+              << Now().GetSeconds() << " (" << m_active << " active)" << END_CODE);
+  
+  if (!m_queue->IsEmpty())
+  {
+    StartTask(static_cast<uint32_t>(m_instances.size() - 1), m_queue->Dequeue());
+  }
+}
+
+void 
+CloudApplication::CompleteScaleOut()
+{
+  m_pending--;
+  AddInstance();
+}
+
+void 
+CloudApplication::RetireInstance(uint32_t instance)
+{
+  Instance& server = m_instances[instance];
+  server.active = false;
+  server.retiring = false;
+  server.stopped = Now();
+  
+  NS_LOG_INFO(RED_CODE << "Cloud instance " << instance << " retired at time " 
+              << Now().GetSeconds() << END_CODE);
+}
+
+Time 
+CloudApplication::GetTotalBusyTime(Time now) const
+{
+  Time busy = Seconds(0);
+  for (const Instance& server : m_instances)
+  {
+    busy += server.busyTime;
+    if (server.busy)
+    {
+      busy += now - server.busySince;
+    }
+  }
+  return busy;
+}
+
+void 
+CloudApplication::EvaluateScaling()
+{
+  // Utilization of the active instances over the last interval
+  Time busy = GetTotalBusyTime(Now());
+  double utilization = (busy - m_busy_checkpoint).GetSeconds() / (cloud_scale_interval * m_active);
+  m_busy_checkpoint = busy;
+  uint32_t queued = m_queue->GetNPackets();
+  
+  if (queued > cloud_scale_out_queue * (m_active + m_pending) && 
+      m_active + m_pending < cloud_max_instances)
+  {
+    // Scale out: the new instance serves tasks after the start-up delay
+    m_pending++;
+    NS_LOG_INFO(YELLOW_CODE << "Cloud scale-out at time " << Now().GetSeconds() 
+                << " with " << queued << " queued tasks" << END_CODE);
+    Simulator::Schedule(Seconds(cloud_scale_out_delay), &CloudApplication::CompleteScaleOut, this);
+  }
+  else if (utilization < cloud_scale_in_utilization && queued == 0 && 
+           m_pending == 0 && m_active > cloud_instances)
+  {
+    // Scale in: retire the most recent instance, after its current task if busy
+    for (uint32_t i = static_cast<uint32_t>(m_instances.size()); i-- > 0;)
+    {
+      Instance& server = m_instances[i];
+      if (server.active && !server.retiring)
+      {
+        m_active--;
+        if (server.busy)
+        {
+          server.retiring = true;
+        }
+        else
+        {
+          RetireInstance(i);
+        }
+        break;
+      }
+    }
+  }
+  
+  m_scale_event = Simulator::Schedule(Seconds(cloud_scale_interval), 
+                                      &CloudApplication::EvaluateScaling, this);
+}
+
+void 
+CloudApplication::DumpInstanceStats(std::string filename)
+{
+  std::ofstream file(filename);
+  if (!file.is_open())
+  {
+    NS_LOG_ERROR("Cannot open cloud instance file " << filename);
+    return;
+  }
+  
+  // Instance-seconds are the cost of the pool; dropped tasks are those refused by a full queue
+  file << "# dropped_tasks=" << m_dropped << "\n";
+  file << "instance,capacity_mips,started_s,stopped_s,instance_seconds,tasks,busy_time_s,utilization\n";
+  for (uint32_t i = 0; i < m_instances.size(); i++)
+  {
+    const Instance& server = m_instances[i];
+    Time stopped = server.active || server.retiring ? Now() : server.stopped;
+    Time lifetime = stopped - server.started;
+    Time busy = server.busyTime + (server.busy ? Now() - server.busySince : Seconds(0));
+    double utilization = lifetime.IsStrictlyPositive() ? busy.GetSeconds() / lifetime.GetSeconds() : 0;
     
-    // Schedule packet transmission after processing delay
-    double processingDelay = packet->GetSize() / cloud_computation_capacity;
-    Simulator::Schedule(Seconds(processingDelay), 
-                       &CloudApplication::SendPacket, 
-                       this, 
-                       packetCopy, 
-                       pedestrianAddress, 
-                       m_port_sending);
+    file << i << "," << cloud_computation_capacity << "," << server.started.GetSeconds() << ","
+         << stopped.GetSeconds() << "," << lifetime.GetSeconds() << "," << server.tasks << ","
+         << busy.GetSeconds() << "," << utilization << "\n";
   }
 }
 
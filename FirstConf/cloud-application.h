@@ -2,8 +2,16 @@
  * CloudApplication - A cloud server application for task offloading in ns-3
  *
  * This class implements a cloud computing application that receives packets from
- * edge servers, processes them based on cloud computation capacity, and returns
+ * edge servers, processes them on a pool of server instances, and returns
  * results to the pedestrian nodes.
+ *
+ * Each instance elaborates one task at a time at cloud_computation_capacity;
+ * tasks wait in a shared FIFO queue when every instance is busy. With
+ * cloud_max_instances above cloud_instances the pool autoscales: every
+ * cloud_scale_interval it starts one instance (ready after
+ * cloud_scale_out_delay) if the queue exceeds cloud_scale_out_queue tasks per
+ * instance, or retires one if the utilization over the interval fell below
+ * cloud_scale_in_utilization.
  */
 
 #ifndef CLOUD_APPLICATION_H
@@ -12,14 +20,21 @@
 #include "ns3/socket.h"
 #include "ns3/application.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+
+#include <string>
+#include <vector>
 
 namespace ns3 {
 
 /**
  * \brief Implementation of a cloud computing application
  *
- * This class handles packet reception, processing with simulated computation delay,
- * and response delivery for cloud-based task offloading.
+ * This class handles packet reception, queueing and processing on a pool of
+ * (optionally autoscaled) instances, and response delivery for cloud-based
+ * task offloading.
  */
 class CloudApplication : public Application 
 {
@@ -69,7 +84,80 @@ public:
    */
   void SendPacket(Ptr<Packet> packet, Ipv4Address destination, uint16_t port);
   
+  /**
+   * \brief Start the elaboration of a task on an idle instance
+   *
+   * \param instance Index of the instance
+   * \param packet The task packet
+   */
+  void StartTask(uint32_t instance, Ptr<Packet> packet);
+  
+  /**
+   * \brief Send the response of a task and serve the next queued task on the same instance
+   *
+   * \param instance Index of the instance
+   * \param packet The response to send
+   * \param destination IPv4 address of the pedestrian
+   */
+  void FinishTask(uint32_t instance, Ptr<Packet> packet, Ipv4Address destination);
+  
+  /**
+   * \brief Bring a new instance into service
+   */
+  void AddInstance();
+  
+  /**
+   * \brief Bring an instance started by EvaluateScaling() into service
+   */
+  void CompleteScaleOut();
+  
+  /**
+   * \brief Periodic autoscaling decision
+   */
+  void EvaluateScaling();
+  
+  /**
+   * \brief Write one CSV line per instance (lifetime, tasks, utilization) and the dropped tasks
+   *
+   * \param filename Output CSV file, overwritten
+   */
+  void DumpInstanceStats(std::string filename);
+  
 private:
+  /**
+   * \brief State and statistics of one server instance
+   */
+  struct Instance
+  {
+    bool active;          ///< In service (false once retired)
+    bool busy;            ///< Elaborating a task
+    bool retiring;        ///< Retire at the end of the current task
+    Time started;         ///< Time the instance entered service
+    Time stopped;         ///< Time the instance was retired
+    Time busySince;       ///< Start of the current task
+    Time busyTime;        ///< Total time spent on completed tasks
+    uint64_t tasks;       ///< Tasks started
+  };
+  
+  /**
+   * \brief Find an idle instance in service
+   * \param instance Receives the instance index
+   * \return false if every instance is busy
+   */
+  bool GetIdleInstance(uint32_t& instance) const;
+  
+  /**
+   * \param now Current time
+   * \return Total busy time of all the instances, including the current tasks
+   */
+  Time GetTotalBusyTime(Time now) const;
+  
+  /**
+   * \brief Take a retired or retiring instance out of service
+   * \param instance Index of the instance
+   */
+  void RetireInstance(uint32_t instance);
+
   /**
    * \brief Set up a receiving socket on the specified port
    *
@@ -85,11 +173,23 @@ private:
    */
   virtual void StartApplication();
   
-  Ptr<Socket> m_recv_socket1;  ///< Socket for receiving packets on port m_port1
-  Ptr<Socket> m_recv_socket2;  ///< Socket for receiving packets on a different port (unused)
-  uint16_t m_port1;            ///< Port for receiving packets (7777)
-  uint16_t m_port_sending;     ///< Port for sending processed packets (9999)
-  Ptr<Socket> m_send_socket;   ///< Socket for sending processed packets
+  /**
+   * \brief Stop the autoscaling policy
+   */
+  virtual void StopApplication();
+  
+  Ptr<Socket> m_recv_socket1;          ///< Socket for receiving packets on port m_port1
+  Ptr<Socket> m_recv_socket2;          ///< Socket for receiving packets on a different port (unused)
+  uint16_t m_port1;                    ///< Port for receiving packets (7777)
+  uint16_t m_port_sending;             ///< Port for sending processed packets (9999)
+  Ptr<Socket> m_send_socket;           ///< Socket for sending processed packets
+  std::vector<Instance> m_instances;   ///< Every instance started, indexed by creation order
+  Ptr<DropTailQueue<Packet>> m_queue;  ///< Tasks waiting for an instance
+  uint32_t m_active;                   ///< Instances in service and not retiring
+  uint32_t m_pending;                  ///< Instances being started
+  uint64_t m_dropped;                  ///< Tasks dropped because the queue was full
+  EventId m_scale_event;               ///< Next EvaluateScaling()
+  Time m_busy_checkpoint;              ///< Total busy time at the last evaluation
 };
 
 } // namespace ns3
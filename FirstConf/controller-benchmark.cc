@@ -0,0 +1,322 @@
+/**
+ * Implementation of the offloading controller microbenchmarks
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/system-path.h"
+#include "ns3/tag-buffer.h"
+
+#include "controller-benchmark.h"
+#include "allocation-counter.h"
+#include "car-data-tag.h"
+#include "edge-application.h"
+#include "globals.h"
+#include "neighbor-table.h"
+#include "packet-data-tag.h"
+#include "trace-sink.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("ControllerBenchmark");
+
+namespace {
+
+/// Period at which every vehicle beacons in the neighbor table benchmarks
+const int64_t BEACON_PERIOD_NS = 100000000;
+
+/// Address of the i-th synthetic vehicle, in 10.0.0.0/8
+Ipv4Address
+GetVehicleAddress(uint32_t i)
+{
+  return Ipv4Address(0x0a000001 + i);
+}
+
+/**
+ * The expiry event of the edge (EdgeApplication::RemoveOldNeighbors): armed
+ * at the next deadline when a beacon finds it idle, and re-armed by each run
+ */
+struct ExpiryEvent
+{
+  bool armed = false;                       ///< A run is pending
+  Time when;                                ///< Time of the pending run
+  std::vector<NeighborInformation> expired; ///< Scratch list of the expired neighbors
+
+  /// Arm the event if no run is pending, as EdgeApplication::UpdateNeighbor
+  void Arm(NeighborTable& table)
+  {
+    if (!armed)
+    {
+      armed = table.GetNextExpiry(when);
+    }
+  }
+
+  /// Do the runs due by now, returns their number
+  uint64_t RunUntil(NeighborTable& table, Time now)
+  {
+    uint64_t runs = 0;
+    while (armed && when <= now)
+    {
+      table.PopExpired(when, expired);
+      expired.clear();
+      armed = table.GetNextExpiry(when);
+      runs++;
+    }
+    return runs;
+  }
+};
+
+} // namespace
+
+double ControllerBenchmark::s_minTime = 0;
+uint64_t ControllerBenchmark::s_checksum = 0;
+uint64_t ControllerBenchmark::s_expiryEvents = 0;
+std::vector<ControllerBenchmark::Result> ControllerBenchmark::s_results;
+
+void
+ControllerBenchmark::Run(std::string filename, double minTime)
+{
+  s_minTime = minTime;
+  s_checksum = 0;
+  s_results.clear();
+
+  // Neighbor arrivals write dwell-time rows, as in a simulation, to a scratch
+  // folder so that they do not mix with the simulation results
+  std::string traceFolder = SystemPath::MakeTemporaryDirectoryName();
+  SystemPath::MakeDirectories(traceFolder);
+  TraceSinkRegistry::Open(traceFolder, "microbenchmark");
+
+  std::cout << std::setw(32) << std::left << "benchmark" << std::right << std::setw(8) << "n"
+            << std::setw(14) << "ns/op" << std::setw(14) << "allocs/op" << std::setw(14) << "expiries/op"
+            << std::endl;
+  for (uint32_t n : {10, 100, 1000, 10000})
+  {
+    BenchmarkNeighborTable(n);
+  }
+  for (uint32_t n : {0, 10, 100, 1000, 10000})
+  {
+    BenchmarkStrategies(n);
+  }
+  BenchmarkTags();
+  BenchmarkTraceRecords();
+
+  TraceSinkRegistry::Close();
+  for (const std::string& file : SystemPath::ReadFiles(traceFolder))
+  {
+    std::remove(SystemPath::Append(traceFolder, file).c_str());
+  }
+  rmdir(traceFolder.c_str());
+  Simulator::Destroy();
+  Write(filename);
+}
+
+template <typename Op>
+void
+ControllerBenchmark::Measure(const char* name, uint32_t n, Op op)
+{
+  // The shorter passes warm up the caches, the allocators and the tables;
+  // only the first pass that lasts long enough is reported
+  uint64_t iterations = 1;
+  while (true)
+  {
+    uint64_t allocations = AllocationCounter::Get();
+    uint64_t expiryEvents = s_expiryEvents;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+      s_checksum += op(i);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    allocations = AllocationCounter::Get() - allocations;
+    expiryEvents = s_expiryEvents - expiryEvents;
+
+    if (elapsed >= s_minTime || iterations >= (1ULL << 32))
+    {
+      Result result{name, n, iterations, elapsed * 1e9 / iterations,
+                    static_cast<double>(allocations) / iterations,
+                    static_cast<double>(expiryEvents) / iterations};
+      s_results.push_back(result);
+      std::cout << std::setw(32) << std::left << name << std::right << std::setw(8) << n
+                << std::fixed << std::setprecision(2) << std::setw(14) << result.nsPerOp
+                << std::setprecision(4) << std::setw(14) << result.allocsPerOp
+                << std::setw(14) << result.expiryEventsPerOp << std::endl;
+      return;
+    }
+    iterations *= 2;
+  }
+}
+
+void
+ControllerBenchmark::BenchmarkNeighborTable(uint32_t n)
+{
+  Time timeout = Seconds(neighbor_timeout);
+
+  // Steady beaconing: every vehicle beacons once per period, the expiry
+  // event runs at its deadlines as in the edge
+  {
+    NeighborTable table(timeout);
+    ExpiryEvent expiry;
+    int64_t step = BEACON_PERIOD_NS / n;
+    int64_t now = 0;
+    Measure("neighbor_beacon_update", n, [&](uint64_t i) {
+      now += step;
+      uint32_t vehicle = i % n;
+      s_expiryEvents += expiry.RunUntil(table, NanoSeconds(now));
+      bool added = table.Update(GetVehicleAddress(vehicle), vehicle, i & 7, NanoSeconds(now));
+      expiry.Arm(table);
+      return static_cast<uint64_t>(added);
+    });
+  }
+
+  // Churn: the n vehicles join at once and expire together, per vehicle
+  {
+    NeighborTable table(timeout);
+    ExpiryEvent expiry;
+    int64_t now = 0;
+    Measure("neighbor_join_expire", n, [&](uint64_t i) {
+      uint32_t vehicle = i % n;
+      s_expiryEvents += expiry.RunUntil(table, NanoSeconds(now));
+      table.Update(GetVehicleAddress(vehicle), vehicle, 0, NanoSeconds(now));
+      expiry.Arm(table);
+      if (vehicle == n - 1)
+      {
+        now += timeout.GetNanoSeconds();
+      }
+      return static_cast<uint64_t>(table.GetN());
+    });
+  }
+
+  // Uniform random selection, as in the Random and prioritized strategies
+  {
+    NeighborTable table(timeout);
+    for (uint32_t vehicle = 0; vehicle < n; vehicle++)
+    {
+      table.Update(GetVehicleAddress(vehicle), vehicle, 0, Seconds(0));
+    }
+    Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable>();
+    Measure("neighbor_select", n, [&](uint64_t) {
+      uint32_t index = rand->GetInteger(0, table.GetN() - 1);
+      return static_cast<uint64_t>(table.Get(index).neighbor_ip.Get());
+    });
+  }
+}
+
+void
+ControllerBenchmark::BenchmarkStrategies(uint32_t n)
+{
+  // An edge that is never started: empty queue, idle workers, n neighbors
+  // with queues of 0 to vehicle_queue_length - 1 tasks
+  Ptr<EdgeApplication> edge = CreateObject<EdgeApplication>();
+  edge->ConfigureResources();
+  edge->AssignStreams(0);
+  for (uint32_t vehicle = 0; vehicle < n; vehicle++)
+  {
+    uint32_t queueState = vehicle_queue_length > 0 ? vehicle % vehicle_queue_length : 0;
+    edge->UpdateNeighbor(GetVehicleAddress(vehicle), vehicle, queueState, Vector(vehicle, 0, 0));
+  }
+
+  // Draws of the requests, as made by the pedestrians
+  Ptr<UniformRandomVariable> draws = CreateObject<UniformRandomVariable>();
+  Measure("decide_random", n, [&](uint64_t) {
+    double tierDraw = draws->GetValue();
+    OffloadingDecision decision = edge->DecideRandom(tierDraw, draws->GetValue());
+    return static_cast<uint64_t>(decision.where) + decision.vehicle.Get();
+  });
+  Measure("decide_first_vcc", n, [&](uint64_t) {
+    OffloadingDecision decision = edge->DecideFirstVCC(draws->GetValue(), true, true, true);
+    return static_cast<uint64_t>(decision.where) + decision.vehicle.Get();
+  });
+  Measure("decide_min_completion_time", n, [&](uint64_t) {
+    OffloadingDecision decision = edge->DecideMinCompletionTime(task_workload);
+    return static_cast<uint64_t>(decision.where) + decision.vehicle.Get();
+  });
+}
+
+void
+ControllerBenchmark::BenchmarkTags()
+{
+  uint8_t data[64];
+
+  PacketDataTag packetTag(12345);
+  NS_ABORT_MSG_IF(packetTag.GetSerializedSize() > sizeof(data), "PacketDataTag too large");
+  Measure("packet_data_tag_serialize", 0, [&](uint64_t i) {
+    packetTag.SetTaskId(static_cast<uint32_t>(i));
+    packetTag.Serialize(TagBuffer(data, data + sizeof(data)));
+    return static_cast<uint64_t>(data[0]);
+  });
+  Measure("packet_data_tag_deserialize", 0, [&](uint64_t) {
+    PacketDataTag tag;
+    tag.Deserialize(TagBuffer(data, data + sizeof(data)));
+    return static_cast<uint64_t>(tag.GetTaskId());
+  });
+
+  CarDataTag carTag(42);
+  carTag.SetPosition(Vector(120.5, 80.25, 1.5));
+  carTag.SetQueueMaxPackets(vehicle_queue_length);
+  NS_ABORT_MSG_IF(carTag.GetSerializedSize() > sizeof(data), "CarDataTag too large");
+  Measure("car_data_tag_serialize", 0, [&](uint64_t i) {
+    carTag.SetQueueState(i & 7);
+    carTag.Serialize(TagBuffer(data, data + sizeof(data)));
+    return static_cast<uint64_t>(data[0]);
+  });
+  Measure("car_data_tag_deserialize", 0, [&](uint64_t) {
+    CarDataTag tag;
+    tag.Deserialize(TagBuffer(data, data + sizeof(data)));
+    return static_cast<uint64_t>(tag.GetQueueState());
+  });
+}
+
+void
+ControllerBenchmark::BenchmarkTraceRecords()
+{
+  // A dwell-time row, the most frequent one with beaconing vehicles
+  char row[TraceSink::MAX_ROW_SIZE];
+  Vector position(1234.56, 789.012, 1.5);
+  Measure("trace_record_format", 0, [&](uint64_t i) {
+    TraceRecord record(TRACE_DWELL_TIME);
+    record.AddUint(i)
+          .AddUint(cars_number)
+          .AddAddress(GetVehicleAddress(i & 1023))
+          .AddTime(NanoSeconds(i * 1000))
+          .AddText("IN")
+          .AddText("range")
+          .AddPosition(position);
+    return static_cast<uint64_t>(TraceSink::FormatRow(record, row));
+  });
+}
+
+void
+ControllerBenchmark::Write(std::string filename)
+{
+  std::ofstream file(filename);
+  if (!file.is_open())
+  {
+    NS_LOG_ERROR("Cannot open microbenchmark file " << filename);
+    return;
+  }
+
+  file << "{\n  \"suite\": \"controller\",\n  \"min_time_s\": " << s_minTime
+       << ",\n  \"checksum\": " << s_checksum << ",\n  \"results\": [";
+  for (uint32_t k = 0; k < s_results.size(); k++)
+  {
+    const Result& result = s_results[k];
+    file << (k == 0 ? "\n" : ",\n")
+         << "    {\"name\": \"" << result.name << "\", \"n\": " << result.n
+         << ", \"iterations\": " << result.iterations
+         << ", \"ns_per_op\": " << std::setprecision(6) << result.nsPerOp
+         << ", \"allocs_per_op\": " << result.allocsPerOp
+         << ", \"expiry_events_per_op\": " << result.expiryEventsPerOp << "}";
+  }
+  file << "\n  ]\n}\n";
+}
+
+} // namespace ns3
@@ -0,0 +1,87 @@
+/**
+ * ControllerBenchmark - Microbenchmarks of the offloading controller hot paths
+ *
+ * Run instead of the simulation with --microbenchmark=<file.json>. Each
+ * benchmark repeats one operation, doubling the number of repetitions until a
+ * pass lasts at least --microbenchmarkTime, and reports the wall-clock time
+ * and the heap allocations (AllocationCounter) per operation of that last
+ * pass, and for the neighbor table the runs of the expiry event:
+ *
+ * - neighbor table beacon update, join and expiry, and random selection with
+ *   10 to 10,000 vehicles
+ * - the decisions of the Random, prioritized (VCCFirst, EC_and_CC,
+ *   VCC_and_CC) and MinCompletionTime strategies on an edge application with
+ *   synthetic neighbors, configured from the command line like a simulated one
+ * - PacketDataTag and CarDataTag serialization and deserialization
+ * - trace record building and CSV formatting
+ *
+ * The results are written as JSON, one object per benchmark and table size,
+ * so that they can be compared across versions.
+ */
+
+#ifndef NS3_CONTROLLER_BENCHMARK_H
+#define NS3_CONTROLLER_BENCHMARK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Microbenchmark suite of the offloading controller
+ */
+class ControllerBenchmark
+{
+public:
+  /**
+   * \brief Run every benchmark and write the results
+   *
+   * \param filename JSON output file, overwritten
+   * \param minTime Minimum duration of the measured pass of each benchmark (s)
+   */
+  static void Run(std::string filename, double minTime);
+
+private:
+  /// Measurement of one benchmark at one size
+  struct Result
+  {
+    std::string name;       ///< Benchmark name
+    uint32_t n;             ///< Vehicles in the neighbor table, 0 if not applicable
+    uint64_t iterations;    ///< Operations of the measured pass
+    double nsPerOp;         ///< Wall-clock time per operation (ns)
+    double allocsPerOp;     ///< Heap allocations per operation
+    double expiryEventsPerOp; ///< Runs of the neighbor expiry event per operation
+  };
+
+  /**
+   * \brief Time an operation
+   *
+   * \param name Benchmark name
+   * \param n Vehicles in the neighbor table, 0 if not applicable
+   * \param op Operation, called with the iteration index; returns a value
+   *           folded into a checksum so that it cannot be optimized out
+   */
+  template <typename Op>
+  static void Measure(const char* name, uint32_t n, Op op);
+
+  static void BenchmarkNeighborTable(uint32_t n);
+  static void BenchmarkStrategies(uint32_t n);
+  static void BenchmarkTags();
+  static void BenchmarkTraceRecords();
+
+  /**
+   * \brief Write the results as JSON
+   * \param filename Output file
+   */
+  static void Write(std::string filename);
+
+  static double s_minTime;              ///< Minimum duration of a measured pass (s)
+  static uint64_t s_checksum;           ///< Fold of the operation results
+  static uint64_t s_expiryEvents;       ///< Runs of the neighbor expiry event so far
+  static std::vector<Result> s_results; ///< Results in execution order
+};
+
+} // namespace ns3
+
+#endif // NS3_CONTROLLER_BENCHMARK_H
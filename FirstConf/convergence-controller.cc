@@ -0,0 +1,301 @@
+/**
+ * Implementation of the sequential stopping rule
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+
+#include "convergence-controller.h"
+#include "globals.h"
+#include "latency-histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("ConvergenceController");
+
+namespace {
+
+/**
+ * Quantile z of the standard normal distribution such that P(|Z| < z) = confidence,
+ * by bisection on erf
+ */
+double
+GetNormalQuantile(double confidence)
+{
+  double low = 0;
+  double high = 10;
+  for (int k = 0; k < 60; k++)
+  {
+    double z = (low + high) / 2;
+    if (std::erf(z / std::sqrt(2.0)) < confidence)
+    {
+      low = z;
+    }
+    else
+    {
+      high = z;
+    }
+  }
+  return (low + high) / 2;
+}
+
+/**
+ * Two-sided Student t quantile from the normal one z, Cornish-Fisher
+ * expansion (as in scripts/steady_state.py)
+ */
+double
+GetStudentQuantile(double z, uint32_t df)
+{
+  double z3 = z * z * z;
+  double z5 = z3 * z * z;
+  double z7 = z5 * z * z;
+  double n = df;
+  return z + (z3 + z) / (4 * n) + (5 * z5 + 16 * z3 + 3 * z) / (96 * n * n)
+         + (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * n * n * n);
+}
+
+/**
+ * Leading group means to discard: MSER over the first half of the groups,
+ * with suffix sums giving the variance of every tail
+ */
+uint32_t
+GetMserTruncation(const std::vector<double>& groups)
+{
+  uint32_t n = groups.size();
+  if (n < 4)
+  {
+    return 0;
+  }
+  std::vector<double> suffixSum(n + 1, 0.0);
+  std::vector<double> suffixSquares(n + 1, 0.0);
+  for (uint32_t i = n; i-- > 0;)
+  {
+    suffixSum[i] = suffixSum[i + 1] + groups[i];
+    suffixSquares[i] = suffixSquares[i + 1] + groups[i] * groups[i];
+  }
+
+  double best = std::numeric_limits<double>::infinity();
+  uint32_t bestD = 0;
+  for (uint32_t d = 0; d <= n / 2; d++)
+  {
+    double m = n - d;
+    double squaredDeviations = suffixSquares[d] - suffixSum[d] * suffixSum[d] / m;
+    double statistic = squaredDeviations / (m * m);
+    if (statistic < best)
+    {
+      best = statistic;
+      bestD = d;
+    }
+  }
+  return bestD;
+}
+
+} // namespace
+
+bool ConvergenceController::s_enabled = false;
+double ConvergenceController::s_precision = 0;
+double ConvergenceController::s_confidence = 0;
+double ConvergenceController::s_quantile = 0;
+uint32_t ConvergenceController::s_batchGroups = 0;
+uint32_t ConvergenceController::s_minBatches = 0;
+double ConvergenceController::s_minShare = 0;
+Time ConvergenceController::s_checkInterval;
+Time ConvergenceController::s_drainTime;
+bool ConvergenceController::s_converged = false;
+Time ConvergenceController::s_stopTime;
+ConvergenceController::TierStats ConvergenceController::s_tiers[TIER_COUNT];
+
+void
+ConvergenceController::Enable(double precision, double confidence, uint32_t batchSize, uint32_t minBatches,
+                              double minShare, Time checkInterval, Time drainTime)
+{
+  NS_ABORT_MSG_IF(precision <= 0, "The stopping precision must be positive");
+  NS_ABORT_MSG_IF(confidence <= 0 || confidence >= 1, "The stopping confidence must be in (0, 1)");
+  NS_ABORT_MSG_IF(batchSize == 0 || batchSize % MSER_GROUP != 0,
+                  "The stopping batch size must be a positive multiple of " << MSER_GROUP);
+  // The t quantile expansion is accurate from 4 degrees of freedom
+  NS_ABORT_MSG_IF(minBatches < 5, "The stopping rule needs at least 5 batches per tier");
+  NS_ABORT_MSG_IF(minShare < 0 || minShare >= 1, "The stopping minimum share must be in [0, 1)");
+  NS_ABORT_MSG_IF(!checkInterval.IsStrictlyPositive(), "The stopping check interval must be positive");
+  NS_ABORT_MSG_IF(drainTime.IsStrictlyNegative(), "The drain time must not be negative");
+
+  s_enabled = true;
+  s_precision = precision;
+  s_confidence = confidence;
+  s_quantile = GetNormalQuantile(confidence);
+  s_batchGroups = batchSize / MSER_GROUP;
+  s_minBatches = minBatches;
+  s_minShare = minShare;
+  s_checkInterval = checkInterval;
+  s_drainTime = drainTime;
+  s_converged = false;
+  s_stopTime = Time();
+  for (TierStats& tier : s_tiers)
+  {
+    tier = TierStats{0, 0, 0, {}};
+  }
+  Simulator::Schedule(s_checkInterval, &ConvergenceController::Check);
+}
+
+bool
+ConvergenceController::IsEnabled()
+{
+  return s_enabled;
+}
+
+void
+ConvergenceController::Record(uint32_t tier, Time value)
+{
+  if (!s_enabled || tier >= TIER_COUNT)
+  {
+    return;
+  }
+  TierStats& stats = s_tiers[tier];
+  stats.count++;
+  stats.groupSum += value.GetSeconds();
+  if (++stats.groupCount == MSER_GROUP)
+  {
+    stats.groups.push_back(stats.groupSum / MSER_GROUP);
+    stats.groupSum = 0;
+    stats.groupCount = 0;
+  }
+}
+
+ConvergenceController::Estimate
+ConvergenceController::GetEstimate(uint32_t tier)
+{
+  const std::vector<double>& groups = s_tiers[tier].groups;
+  uint32_t truncation = GetMserTruncation(groups);
+  uint32_t batches = (groups.size() - truncation) / s_batchGroups;
+
+  Estimate estimate{static_cast<uint64_t>(truncation) * MSER_GROUP,
+                    static_cast<uint64_t>(batches) * s_batchGroups * MSER_GROUP, batches, 0,
+                    std::numeric_limits<double>::infinity(), 0};
+  if (batches == 0)
+  {
+    return estimate;
+  }
+
+  // The groups after the last complete batch wait for the next checks
+  std::vector<double> means(batches, 0.0);
+  for (uint32_t b = 0; b < batches; b++)
+  {
+    for (uint32_t g = 0; g < s_batchGroups; g++)
+    {
+      means[b] += groups[truncation + b * s_batchGroups + g];
+    }
+    means[b] /= s_batchGroups;
+    estimate.mean += means[b];
+  }
+  estimate.mean /= batches;
+  if (batches < 2)
+  {
+    return estimate;
+  }
+
+  double squares = 0;
+  double lagged = 0;
+  for (uint32_t b = 0; b < batches; b++)
+  {
+    double deviation = means[b] - estimate.mean;
+    squares += deviation * deviation;
+    if (b + 1 < batches)
+    {
+      lagged += deviation * (means[b + 1] - estimate.mean);
+    }
+  }
+  double variance = squares / (batches - 1);
+  estimate.halfWidth = GetStudentQuantile(s_quantile, batches - 1) * std::sqrt(variance / batches);
+  estimate.autocorrelation = squares > 0 ? lagged / squares : 0;
+  return estimate;
+}
+
+bool
+ConvergenceController::IsConverged(const Estimate& estimate)
+{
+  // Correlated batch means are too short for the queues: the half-width would be optimistic
+  return estimate.batches >= s_minBatches && estimate.halfWidth <= s_precision * estimate.mean
+         && estimate.autocorrelation <= 2 / std::sqrt(static_cast<double>(estimate.batches));
+}
+
+bool
+ConvergenceController::IsIgnored(uint32_t tier)
+{
+  uint64_t total = 0;
+  for (const TierStats& stats : s_tiers)
+  {
+    total += stats.count;
+  }
+  return s_tiers[tier].count == 0 || s_tiers[tier].count < s_minShare * total;
+}
+
+void
+ConvergenceController::Check()
+{
+  // Tiers that the strategy never or seldom used do not hold the run
+  bool anyTier = false;
+  bool converged = true;
+  for (uint32_t tier = 0; tier < TIER_COUNT; tier++)
+  {
+    if (!IsIgnored(tier))
+    {
+      anyTier = true;
+      converged = converged && IsConverged(GetEstimate(tier));
+    }
+  }
+
+  if (anyTier && converged)
+  {
+    NS_LOG_INFO("Offloading times converged at " << Now().GetSeconds() << " s, stopping");
+    s_converged = true;
+    s_stopTime = Now();
+    // The requests in flight complete instead of being left pending in the tasks_ trace
+    requests_end_time = std::min(requests_end_time, Now().GetSeconds());
+    Simulator::Stop(s_drainTime);
+    return;
+  }
+  Simulator::Schedule(s_checkInterval, &ConvergenceController::Check);
+}
+
+void
+ConvergenceController::Dump(std::string filename)
+{
+  if (!s_enabled)
+  {
+    return;
+  }
+  std::ofstream file(filename);
+  if (!file.is_open())
+  {
+    NS_LOG_ERROR("Cannot open convergence file " << filename);
+    return;
+  }
+
+  // Requests of the runs that did not converge end drainTime before simTime, the upper bound
+  Time end = s_converged ? s_stopTime : Min(Now(), Seconds(requests_end_time));
+  file << "tier,requests,warmup_requests,kept_requests,batches,batch_size,mean_s,half_width_s,"
+          "relative_half_width,lag1_autocorrelation,converged,ignored,precision,confidence,"
+          "stop_time_s,stopped_by_rule\n";
+  for (uint32_t tier = 0; tier < TIER_COUNT; tier++)
+  {
+    if (s_tiers[tier].count == 0)
+    {
+      continue;
+    }
+    Estimate estimate = GetEstimate(tier);
+    file << LatencyHistograms::GetTierName(tier) << "," << s_tiers[tier].count << ","
+         << estimate.warmup << "," << estimate.kept << "," << estimate.batches << ","
+         << s_batchGroups * MSER_GROUP << "," << estimate.mean << "," << estimate.halfWidth << ","
+         << (estimate.mean > 0 ? estimate.halfWidth / estimate.mean : 0) << ","
+         << estimate.autocorrelation << "," << IsConverged(estimate) << "," << IsIgnored(tier) << ","
+         << s_precision << "," << s_confidence << "," << end.GetSeconds() << "," << s_converged << "\n";
+  }
+}
+
+} // namespace ns3
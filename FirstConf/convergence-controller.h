@@ -0,0 +1,143 @@
+/**
+ * ConvergenceController - Sequential stopping rule on the offloading time
+ *
+ * With --stopPrecision, the offloading times of every tier (fed as the
+ * pedestrians receive their responses) are checked every --stopCheckInterval
+ * with the estimators of scripts/steady_state.py, online:
+ *
+ * - warm-up: the offloading times are averaged in groups of 5 and the
+ *   leading groups of the start-up transient are discarded by MSER-5,
+ *   recomputed at every check over the first half of the groups
+ * - batch means: the remaining times are split into consecutive batches of
+ *   --stopBatchSize requests, whose means are treated as independent; the
+ *   half-width of the mean is t * s / sqrt(batches), with the Student t
+ *   quantile on batches - 1 degrees of freedom
+ *
+ * A tier converged once it has at least --stopMinBatches batches, a
+ * half-width within the relative precision, and batch means that are not
+ * correlated (lag-1 autocorrelation within 2 / sqrt(batches)). The run stops
+ * as soon as every tier converged, except the tiers that received less than
+ * --stopMinShare of the completed requests, which do not hold the run;
+ * otherwise it ends at simTime, the upper bound. Stopping ends the requests
+ * and leaves --drainTime to the ones in flight before the simulation ends.
+ * The statistics and the stopping time are written to
+ * convergence_<simType>.csv.
+ */
+
+#ifndef NS3_CONVERGENCE_CONTROLLER_H
+#define NS3_CONVERGENCE_CONTROLLER_H
+
+#include "ns3/nstime.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Stops the simulation once the mean offloading time of every tier is precise enough
+ */
+class ConvergenceController
+{
+public:
+  /// Number of offloading tiers (0=Edge, 1=Cloud, 2=VCC)
+  static const uint32_t TIER_COUNT = 3;
+
+  /// Offloading times averaged together by the MSER warm-up detection
+  static const uint32_t MSER_GROUP = 5;
+
+  /**
+   * \brief Start checking the stopping rule
+   *
+   * \param precision Target confidence interval half-width, relative to the mean
+   * \param confidence Confidence level of the interval, in (0, 1)
+   * \param batchSize Completed requests per batch, a multiple of MSER_GROUP
+   * \param minBatches Batches needed in a tier before it can converge
+   * \param minShare Share of the completed requests below which a tier does not hold the run
+   * \param checkInterval Time between two checks
+   * \param drainTime Time left to the requests in flight once the rule stops the requests
+   */
+  static void Enable(double precision, double confidence, uint32_t batchSize, uint32_t minBatches,
+                     double minShare, Time checkInterval, Time drainTime);
+
+  /**
+   * \return true if Enable() was called
+   */
+  static bool IsEnabled();
+
+  /**
+   * \brief Add the offloading time of a completed request
+   *
+   * \param tier Offloading tier (0=Edge, 1=Cloud, 2=VCC)
+   * \param value Offloading time
+   */
+  static void Record(uint32_t tier, Time value);
+
+  /**
+   * \brief Write the statistics of every tier and the stopping time
+   * \param filename Output file, overwritten
+   */
+  static void Dump(std::string filename);
+
+private:
+  /// Offloading times of one tier
+  struct TierStats
+  {
+    uint64_t count;             ///< Completed requests
+    double groupSum;            ///< Sum of the offloading times of the current group (s)
+    uint32_t groupCount;        ///< Offloading times in the current group
+    std::vector<double> groups; ///< Means of the completed groups (s)
+  };
+
+  /// Batch-means estimate of one tier
+  struct Estimate
+  {
+    uint64_t warmup;            ///< Requests discarded as warm-up
+    uint64_t kept;              ///< Requests in the batches
+    uint32_t batches;           ///< Complete batches
+    double mean;                ///< Mean of the batch means (s)
+    double halfWidth;           ///< Confidence interval half-width (s), infinite below two batches
+    double autocorrelation;     ///< Lag-1 autocorrelation of the batch means
+  };
+
+  /**
+   * \brief Stop the requests and end the simulation after the drain time if
+   *        every tier converged, else check again later
+   */
+  static void Check();
+
+  /**
+   * \param tier Offloading tier
+   * \return Warm-up truncation and batch-means estimate of the tier
+   */
+  static Estimate GetEstimate(uint32_t tier);
+
+  /**
+   * \param estimate Estimate of a tier
+   * \return true if the tier has enough batches, a precise enough mean and uncorrelated batches
+   */
+  static bool IsConverged(const Estimate& estimate);
+
+  /**
+   * \param tier Offloading tier
+   * \return true if the tier received too few of the completed requests to hold the run
+   */
+  static bool IsIgnored(uint32_t tier);
+
+  static bool s_enabled;                    ///< Stopping rule enabled
+  static double s_precision;                ///< Relative half-width target
+  static double s_confidence;               ///< Confidence level
+  static double s_quantile;                 ///< Standard normal quantile of the confidence level
+  static uint32_t s_batchGroups;            ///< MSER groups per batch
+  static uint32_t s_minBatches;             ///< Batches needed per tier
+  static double s_minShare;                 ///< Share of the requests needed to hold the run
+  static Time s_checkInterval;              ///< Time between checks
+  static Time s_drainTime;                  ///< Time between the stop of the requests and the end
+  static bool s_converged;                  ///< The rule stopped the run
+  static Time s_stopTime;                   ///< Time at which the rule stopped the requests
+  static TierStats s_tiers[TIER_COUNT];     ///< Offloading times per tier
+};
+
+} // namespace ns3
+
+#endif // NS3_CONVERGENCE_CONTROLLER_H
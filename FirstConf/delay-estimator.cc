@@ -0,0 +1,52 @@
+/**
+ * Implementation of the delay estimator
+ */
+
+#include "ns3/abort.h"
+
+#include "delay-estimator.h"
+
+namespace ns3 {
+
+DelayEstimator::DelayEstimator(Time prior, double alpha)
+  : m_alpha(alpha),
+    m_estimate(prior),
+    m_samples(0)
+{
+  NS_ABORT_MSG_IF(alpha <= 0 || alpha > 1, "EWMA weight must be in (0, 1]");
+}
+
+void
+DelayEstimator::Update(Time sample)
+{
+  if (sample.IsNegative())
+  {
+    return;
+  }
+
+  // The first sample replaces the prior
+  if (m_samples == 0)
+  {
+    m_estimate = sample;
+  }
+  else
+  {
+    m_estimate = NanoSeconds(static_cast<int64_t>(m_alpha * sample.GetNanoSeconds() +
+                                                  (1 - m_alpha) * m_estimate.GetNanoSeconds()));
+  }
+  ++m_samples;
+}
+
+Time
+DelayEstimator::Get() const
+{
+  return m_estimate;
+}
+
+uint64_t
+DelayEstimator::GetNSamples() const
+{
+  return m_samples;
+}
+
+} // namespace ns3
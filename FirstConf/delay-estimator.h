@@ -0,0 +1,56 @@
+/**
+ * DelayEstimator - Exponentially weighted moving average of a measured delay
+ *
+ * Used by the edge to track the recent one-way delays of the network legs
+ * (UE uplink, UE downlink, edge-cloud backhaul) from the timestamps carried in
+ * PacketDataTag. Until the first sample arrives the estimator returns a prior,
+ * so that decisions at the start of the run are not biased towards a tier
+ * whose delay has simply not been measured yet.
+ */
+
+#ifndef NS3_DELAY_ESTIMATOR_H
+#define NS3_DELAY_ESTIMATOR_H
+
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \brief EWMA of a delay with a prior used before the first sample
+ */
+class DelayEstimator
+{
+public:
+  /**
+   * \brief Create an estimator
+   *
+   * \param prior Value returned until the first sample
+   * \param alpha Weight of a new sample, in (0, 1]
+   */
+  DelayEstimator(Time prior, double alpha);
+
+  /**
+   * \brief Add a measured delay
+   * \param sample The delay; negative samples (clock artefacts) are ignored
+   */
+  void Update(Time sample);
+
+  /**
+   * \return The current estimate
+   */
+  Time Get() const;
+
+  /**
+   * \return The number of samples received
+   */
+  uint64_t GetNSamples() const;
+
+private:
+  double m_alpha;           ///< Weight of a new sample
+  Time m_estimate;          ///< Current estimate (the prior until the first sample)
+  uint64_t m_samples;       ///< Number of samples received
+};
+
+} // namespace ns3
+
+#endif // NS3_DELAY_ESTIMATOR_H
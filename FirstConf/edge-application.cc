@@ -20,8 +20,12 @@
 #include "edge-application.h"
 #include "car-data-tag.h"
 #include "packet-data-tag.h"
+#include "task-registry.h"
 #include "globals.h"
+#include "trace-sink.h"
+#include "event-profiler.h"
 
+#include <algorithm>
 #include <vector>
 #include <time.h>
 
@@ -42,6 +46,17 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE("EdgeApplication");
 NS_OBJECT_ENSURE_REGISTERED(EdgeApplication);
 
+namespace {
+
+/// Index in [0, count) of a uniform draw in [0, 1)
+uint32_t
+PickIndex(double draw, uint32_t count)
+{
+  return std::min(static_cast<uint32_t>(draw * count), count - 1);
+}
+
+} // namespace
+
 TypeId
 EdgeApplication::GetTypeId()
 {
@@ -59,11 +74,25 @@ EdgeApplication::GetInstanceTypeId() const
 
 EdgeApplication::EdgeApplication()
   : m_port1(7777),
-    m_port2(8888)
+    m_port2(8888),
+    m_neighbors(Seconds(neighbor_timeout)),
+    m_ue_uplink(MilliSeconds(3), 0.1),      // Prior: S1-U delay plus one NR slot
+    m_ue_downlink(MilliSeconds(3), 0.1),
+    m_cloud_backhaul(MilliSeconds(35), 0.1), // Prior: point-to-point delay to the remote host
+    m_cloud_queueing(Seconds(0), 0.1),
+    m_tie_break(CreateObject<UniformRandomVariable>()),
+    m_response_pool(4000)
 {
   // Nothing else to initialize
 }
 
+int64_t
+EdgeApplication::AssignStreams(int64_t stream)
+{
+  m_tie_break->SetStream(stream);
+  return 1;
+}
+
 EdgeApplication::~EdgeApplication()
 {
   // Nothing to clean up
@@ -101,15 +130,25 @@ EdgeApplication::StartApplication()
   // Create sending socket
   m_send_socket = Socket::CreateSocket(GetNode(), tid);
   
+  ConfigureResources();
+  
   NS_LOG_FUNCTION(this);
   
-  // Schedule periodic check to remove old neighbors (every 0.1 seconds)
-  Simulator::Schedule(Seconds(0.1), &EdgeApplication::RemoveOldNeighbors, this);
+  // Neighbors expire through RemoveOldNeighbors(), scheduled at their deadlines
+}
+
+void
+EdgeApplication::ConfigureResources()
+{
+  // Split the edge capacity among the workers behind the shared queue
+  m_workers.Configure(edge_computation_capacity, edge_workers, edge_worker_shares);
+  m_edge_queue->SetMaxSize(QueueSize(QueueSizeUnit::PACKETS, edge_queue_size));
 }
 
 void 
 EdgeApplication::HandleReadOne(Ptr<Socket> socket)
 {
+  EventProfiler::Scope profile("EdgeApplication::HandleReadOne");
   NS_LOG_FUNCTION(this << socket);
   Ptr<Packet> packet;
   Address from;
@@ -125,13 +164,14 @@ EdgeApplication::HandleReadOne(Ptr<Socket> socket)
     InetSocketAddress fromAddr = InetSocketAddress::ConvertFrom(from);
     Ipv4Address destIp = fromAddr.GetIpv4();
 
-    // Update packet tag with source address and VCC information
+    // Record the source address and VCC information of the task
     PacketDataTag tag;
-    if (packet->RemovePacketTag(tag))
+    if (packet->PeekPacketTag(tag))
     {
-      tag.SetSourcePedestrianIPv4Address(destIp);
-      tag.SetCarsInVCC(m_neighbors.size());
-      packet->AddPacketTag(tag);
+      uint32_t task = tag.GetTaskId();
+      m_ue_uplink.Update(Now() - TaskRegistry::GetInitialTime(task));
+      TaskRegistry::SetSourcePedestrianIPv4Address(task, destIp);
+      TaskRegistry::SetCarsInVCC(task, m_neighbors.GetN());
     }
 
     // Apply the selected offloading strategy
@@ -156,41 +196,55 @@ EdgeApplication::HandleReadOne(Ptr<Socket> socket)
       bool cloudActive = true;
       this->FirstVCCStrategy(packet, destIp, vccActive, edgeActive, cloudActive);
     }
+    else if (chosen_strategy == "MinCompletionTime") {
+      this->MinCompletionTimeStrategy(packet);
+    }
   }
 }
 
 void 
 EdgeApplication::HandleResponseFromVehicle(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
 {
+  EventProfiler::Scope profile("EdgeApplication::HandleResponseFromVehicle");
   // Process packet responses from vehicles passing through the edge server
   PacketDataTag tag;
   if (packet->PeekPacketTag(tag))
   {
-    if (tag.GetIsFromVCCToPed() == 1) {
+    uint32_t task = tag.GetTaskId();
+    Time uplinkTime = TaskRegistry::GetUplinkTime(task);
+    Time queueingTime = TaskRegistry::GetQueueingTime(task);
+    
+    // Measure the network legs for MinCompletionTime from the response timestamps
+    Time elaborationEnd = queueingTime + TaskRegistry::GetElaborationTime(task);
+    if (TaskRegistry::GetIsFromVCCToPed(task) == 1) {
+      m_ue_downlink.Update(uplinkTime - TaskRegistry::GetDispatchTime(task));
+      m_ue_uplink.Update(Now() - elaborationEnd);
+    }
+    else if (TaskRegistry::GetWhere(task) == 1) {
+      m_cloud_backhaul.Update(Now() - elaborationEnd);
+      m_cloud_queueing.Update(queueingTime - uplinkTime);
+    }
+
+    if (TaskRegistry::GetIsFromVCCToPed(task) == 1) {
       // Log response data to CSV file
-      std::ofstream logFile;
-      std::string filename = output_data_csv + "/response_offloading_passing_in_gNB_" + sim_type + ".csv";
-      logFile.open(filename, std::ofstream::app);
-      
-      if (logFile.is_open()) {
-        logFile << tag.GetNodeId() << ","
-                << packet->GetSize() << ","
-                << tag.GetInitialTime() << ","
-                << Now().GetSeconds() << ","
-                << tag.GetWhere() << ","
-                << request_rate << ","
-                << cars_number << ","
-                << pedestrians_number << ","
-                << tag.GetUplinkTime() << ","
-                << tag.GetElaborationTime() << ","
-                << edge_computation_capacity << ","
-                << car_computation_capacity << ","
-                << tag.GetQueueingTime() << ","
-                << tag.GetWorkload() << ","
-                << tag.GetCarsInVCC() << ","
-                << vehicle_queue_length << "\n";
-        logFile.close();
-      }
+      TraceRecord record(TRACE_RESPONSE_PASSING_IN_GNB);
+      record.AddUint(TaskRegistry::GetNodeId(task))
+            .AddUint(packet->GetSize())
+            .AddTime(TaskRegistry::GetInitialTime(task))
+            .AddSeconds(Now())
+            .AddUint(TaskRegistry::GetWhere(task))
+            .AddDouble(request_rate)
+            .AddUint(cars_number)
+            .AddUint(pedestrians_number)
+            .AddTime(uplinkTime)
+            .AddTime(TaskRegistry::GetElaborationTime(task))
+            .AddDouble(edge_computation_capacity)
+            .AddDouble(car_computation_capacity)
+            .AddTime(queueingTime)
+            .AddDouble(TaskRegistry::GetWorkload(task))
+            .AddUint(TaskRegistry::GetCarsInVCC(task))
+            .AddUint(vehicle_queue_length);
+      TraceSinkRegistry::Write(record);
     }
   }
   else {
@@ -201,6 +255,7 @@ EdgeApplication::HandleResponseFromVehicle(Ptr<const Packet> packet, Ptr<Ipv4> i
 void 
 EdgeApplication::HandleNeighbor(Ptr<Socket> socket)
 {
+  EventProfiler::Scope profile("EdgeApplication::HandleNeighbor");
   Ptr<Packet> packet;
   Address from;
   
@@ -217,36 +272,26 @@ EdgeApplication::HandleNeighbor(Ptr<Socket> socket)
 
       if (queueState < tag.GetQueueMaxPackets() && queueState >= 0) {
         // Update neighbor list if vehicle has capacity
-        UpdateNeighbor(source, tag.GetNodeId(), tag.GetPosition());
+        UpdateNeighbor(source, tag.GetNodeId(), queueState, tag.GetPosition());
       }
       else if (queueState >= tag.GetQueueMaxPackets()) {
         // Remove from neighbor list if vehicle has no available resources
-        for (std::vector<NeighborInformation>::iterator it = m_neighbors.begin(); it != m_neighbors.end(); it++)
+        NeighborInformation removed;
+        if (m_neighbors.Remove(source, &removed))
         {
-          if (it->neighbor_ip == source)
-          {
-            NS_LOG_INFO(RED_CODE << Now() << " Node " << GetNode()->GetId() 
-                        << " resourceless neighbor " << it->neighbor_ip << END_CODE);
-
-            // Log vehicle departure due to resource exhaustion
-            std::ofstream logFile;
-            std::string filename = output_data_csv + "/dwell_time_" + sim_type + ".csv";
-            logFile.open(filename, std::ofstream::app);
-            
-            if (logFile.is_open()) {
-              logFile << tag.GetNodeId() << ","
-                      << cars_number << ","
-                      << it->neighbor_ip << ","
-                      << Now() << ","
-                      << "OUT" << ","
-                      << "resourceless" << ","
-                      << tag.GetPosition() << "\n";
-              logFile.close();
-            }
-
-            m_neighbors.erase(it);
-            break;
-          }
+          NS_LOG_INFO(RED_CODE << Now() << " Node " << GetNode()->GetId() 
+                      << " resourceless neighbor " << removed.neighbor_ip << END_CODE);
+
+          // Log vehicle departure due to resource exhaustion
+          TraceRecord record(TRACE_DWELL_TIME);
+          record.AddUint(tag.GetNodeId())
+                .AddUint(cars_number)
+                .AddAddress(removed.neighbor_ip)
+                .AddTime(Now())
+                .AddText("OUT")
+                .AddText("resourceless")
+                .AddPosition(tag.GetPosition());
+          TraceSinkRegistry::Write(record);
         }
       }
     }
@@ -254,48 +299,28 @@ EdgeApplication::HandleNeighbor(Ptr<Socket> socket)
 }
 
 void 
-EdgeApplication::UpdateNeighbor(Ipv4Address addr, uint32_t nodeId, Vector position)
+EdgeApplication::UpdateNeighbor(Ipv4Address addr, uint32_t nodeId, uint32_t queueState, Vector position)
 {
-  bool found = false;
-  
-  // Check if neighbor already exists in the list
-  for (std::vector<NeighborInformation>::iterator it = m_neighbors.begin(); it != m_neighbors.end(); it++)
-  {
-    if (it->neighbor_ip == addr)
-    {
-      // Update last beacon time
-      it->last_beacon = Now();
-      found = true;
-      break;
-    }
-  }
-  
-  if (!found) {
-    // Add new neighbor to the list
+  // Refresh the last beacon time and queue state, or add the neighbor if it is new
+  if (m_neighbors.Update(addr, nodeId, queueState, Now())) {
     NS_LOG_INFO(GREEN_CODE << Now() << " : Node " << GetNode()->GetId() 
                 << " is adding a neighbor with IP=" << addr << END_CODE);
-    
-    NeighborInformation newNeighbor;
-    newNeighbor.node_ID = nodeId;
-    newNeighbor.neighbor_ip = addr;
-    newNeighbor.last_beacon = Now();
-    m_neighbors.push_back(newNeighbor);
 
     // Log vehicle arrival
-    std::ofstream logFile;
-    std::string filename = output_data_csv + "/dwell_time_" + sim_type + ".csv";
-    logFile.open(filename, std::ofstream::app);
-    
-    if (logFile.is_open()) {
-      logFile << nodeId << ","
-              << cars_number << ","
-              << addr << ","
-              << Now() << ","
-              << "IN" << ","
-              << "range" << ","
-              << position << "\n";
-      logFile.close();
-    }
+    TraceRecord record(TRACE_DWELL_TIME);
+    record.AddUint(nodeId)
+          .AddUint(cars_number)
+          .AddAddress(addr)
+          .AddTime(Now())
+          .AddText("IN")
+          .AddText("range")
+          .AddPosition(position);
+    TraceSinkRegistry::Write(record);
+  }
+
+  // Arm the expiry event if no deadline was pending
+  if (!m_expiry_event.IsRunning()) {
+    ScheduleNeighborExpiry();
   }
 }
 
@@ -303,31 +328,21 @@ void
 EdgeApplication::RemoveNeighbor(Ipv4Address addr)
 {
   // Find and remove neighbor with specified address
-  for (std::vector<NeighborInformation>::iterator it = m_neighbors.begin(); it != m_neighbors.end(); it++)
+  NeighborInformation removed;
+  if (m_neighbors.Remove(addr, &removed))
   {
-    if (it->neighbor_ip == addr)
-    {
-      NS_LOG_INFO(RED_CODE << Now() << " Node " << GetNode()->GetId()
-                  << " is removing old neighbor because it is used " << it->neighbor_ip << END_CODE);
-
-      // Log vehicle departure due to being used for computation
-      std::ofstream logFile;
-      std::string filename = output_data_csv + "/dwell_time_" + sim_type + ".csv";
-      logFile.open(filename, std::ofstream::app);
-      
-      if (logFile.is_open()) {
-        logFile << it->node_ID << ","
-                << cars_number << ","
-                << it->neighbor_ip << ","
-                << Now() << ","
-                << "OUT" << ","
-                << "used" << "\n";
-        logFile.close();
-      }
-
-      m_neighbors.erase(it);
-      break;
-    }
+    NS_LOG_INFO(RED_CODE << Now() << " Node " << GetNode()->GetId()
+                << " is removing old neighbor because it is used " << removed.neighbor_ip << END_CODE);
+
+    // Log vehicle departure due to being used for computation
+    TraceRecord record(TRACE_DWELL_TIME);
+    record.AddUint(removed.node_ID)
+          .AddUint(cars_number)
+          .AddAddress(removed.neighbor_ip)
+          .AddTime(Now())
+          .AddText("OUT")
+          .AddText("used");
+    TraceSinkRegistry::Write(record);
   }
 }
 
@@ -335,90 +350,105 @@ void
 EdgeApplication::PrintNeighbors()
 {
   std::cout << "Neighbor Info for Node: " << GetNode()->GetId() << std::endl;
-  for (std::vector<NeighborInformation>::iterator it = m_neighbors.begin(); it != m_neighbors.end(); it++)
+  for (uint32_t i = 0; i < m_neighbors.GetN(); i++)
   {
-    std::cout << "\tMAC: " << it->neighbor_ip 
-              << "\tLast Contact: " << it->last_beacon << std::endl;
+    const NeighborInformation& neighbor = m_neighbors.Get(i);
+    std::cout << "\tMAC: " << neighbor.neighbor_ip 
+              << "\tLast Contact: " << neighbor.last_beacon << std::endl;
   }
 }
 
 void 
 EdgeApplication::RemoveOldNeighbors()
 {
-  // Remove neighbors that haven't been heard from for 0.5 seconds
-  for (std::vector<NeighborInformation>::iterator it = m_neighbors.begin(); it != m_neighbors.end(); it++)
+  EventProfiler::Scope profile("EdgeApplication::RemoveOldNeighbors");
+  // Remove every neighbor whose last beacon is older than the timeout (--neighborTimeout, 0.5 s by default)
+  std::vector<NeighborInformation> expired;
+  m_neighbors.PopExpired(Now(), expired);
+
+  for (const NeighborInformation& neighbor : expired)
   {
-    Time lastContact = Now() - it->last_beacon;
+    NS_LOG_INFO(RED_CODE << Now() << " Node " << GetNode()->GetId()
+                << " is removing old neighbor " << neighbor.neighbor_ip << END_CODE);
+
+    // Log vehicle departure due to being out of range
+    TraceRecord record(TRACE_DWELL_TIME);
+    record.AddUint(neighbor.node_ID)
+          .AddUint(cars_number)
+          .AddAddress(neighbor.neighbor_ip)
+          .AddTime(Now())
+          .AddText("OUT")
+          .AddText("range");
+    TraceSinkRegistry::Write(record);
+  }
 
-    if (lastContact >= Seconds(0.5))
-    {
-      NS_LOG_INFO(RED_CODE << Now() << " Node " << GetNode()->GetId()
-                  << " is removing old neighbor " << it->neighbor_ip << END_CODE);
-
-      // Log vehicle departure due to being out of range
-      std::ofstream logFile;
-      std::string filename = output_data_csv + "/dwell_time_" + sim_type + ".csv";
-      logFile.open(filename, std::ofstream::app);
-      
-      if (logFile.is_open()) {
-        logFile << it->node_ID << ","
-                << cars_number << ","
-                << it->neighbor_ip << ","
-                << Now() << ","
-                << "OUT" << ","
-                << "range" << "\n";
-        logFile.close();
-      }
+  // Wait for the next deadline instead of polling
+  ScheduleNeighborExpiry();
+}
 
-      m_neighbors.erase(it);
-      break;
-    }
+void 
+EdgeApplication::ScheduleNeighborExpiry()
+{
+  Time deadline;
+  if (m_neighbors.GetNextExpiry(deadline)) {
+    m_expiry_event = Simulator::Schedule(deadline - Now(), &EdgeApplication::RemoveOldNeighbors, this);
   }
-  
-  // Schedule next check after 0.1 seconds
-  Simulator::Schedule(Seconds(0.1), &EdgeApplication::RemoveOldNeighbors, this);
 }
 
 void 
-EdgeApplication::HandleDequeue()
+EdgeApplication::StartEdgeTask(uint32_t worker, Ptr<Packet> packet)
 {
-  // Process next packet in edge server queue
-  Ptr<const Packet> queuedPacket = m_edge_queue->Peek();
-  Ptr<Packet> responsePacket = Create<Packet>(4000);
-
-  if (queuedPacket) {
-    Ipv4Address destination;
-    double elaborationTime = 0;
+  Ptr<Packet> responsePacket = m_response_pool.Acquire();
+  Ipv4Address destination;
+  double elaborationTime = 0;
+  Time queueingDelay = Seconds(0);
 
-    PacketDataTag tag;
-    if (queuedPacket->PeekPacketTag(tag))
-    {
-      elaborationTime = tag.GetWorkload() / edge_computation_capacity;
-      tag.SetElaborationTime(Seconds(elaborationTime));
-      tag.SetQueueingTime(Seconds(Now().GetSeconds()));
-      
-      destination = tag.GetSourcePedestrianIPv4Address();
-      responsePacket->AddPacketTag(tag);
-    }
-    else {
-      NS_LOG_INFO("ERROR with TAG in Edge HandleDequeue()");
-    }
-
-    NS_LOG_INFO(YELLOW_CODE << "Packet elaboration time: " << Seconds(elaborationTime) << END_CODE);
-    
-    uint16_t pedestrianPort = 9999;
+  PacketDataTag tag;
+  if (packet->PeekPacketTag(tag))
+  {
+    // The uplink time is the arrival at the edge
+    uint32_t task = tag.GetTaskId();
+    queueingDelay = Now() - TaskRegistry::GetUplinkTime(task);
+    elaborationTime = TaskRegistry::GetWorkload(task) / m_workers.GetCapacity(worker);
+    TaskRegistry::SetElaborationTime(task, Seconds(elaborationTime));
+    TaskRegistry::SetQueueingTime(task, Now());
     
-    // Schedule sending, dequeuing, and recursive call after computation time
-    Simulator::Schedule(Seconds(elaborationTime), &EdgeApplication::SendPacket, 
-                       this, responsePacket, destination, pedestrianPort);
-    Simulator::Schedule(Seconds(elaborationTime), &ns3::DropTailQueue<Packet>::Dequeue, m_edge_queue);
-    Simulator::Schedule(Seconds(elaborationTime), &EdgeApplication::HandleDequeue, this);
+    destination = TaskRegistry::GetSourcePedestrianIPv4Address(task);
+    responsePacket->AddPacketTag(tag);
   }
   else {
-    NS_LOG_INFO("NO PACKET in Edge queue HandleDequeue()");
+    NS_LOG_INFO("ERROR with TAG in Edge StartEdgeTask()");
+  }
+
+  NS_LOG_INFO(YELLOW_CODE << "Edge worker " << worker << " elaboration time: " 
+              << Seconds(elaborationTime) << END_CODE);
+  
+  // One event per task: the response leaves when the worker completes it
+  m_workers.Start(worker, Now(), queueingDelay);
+  Simulator::Schedule(Seconds(elaborationTime), &EdgeApplication::FinishEdgeTask, 
+                      this, worker, responsePacket, destination);
+}
+
+void 
+EdgeApplication::FinishEdgeTask(uint32_t worker, Ptr<Packet> responsePacket, Ipv4Address destination)
+{
+  EventProfiler::Scope profile("EdgeApplication::FinishEdgeTask");
+  uint16_t pedestrianPort = 9999;
+  SendPacket(responsePacket, destination, pedestrianPort);
+  m_workers.Finish(worker, Now());
+
+  // The worker takes the head of the shared queue
+  if (!m_edge_queue->IsEmpty()) {
+    StartEdgeTask(worker, m_edge_queue->Dequeue());
   }
 }
 
+void 
+EdgeApplication::DumpWorkerStats(std::string filename)
+{
+  m_workers.Dump(filename, Now());
+}
+
 void 
 EdgeApplication::SendPacket(Ptr<Packet> packet, Ipv4Address destination, uint16_t port)
 {
@@ -431,277 +461,245 @@ EdgeApplication::SendPacket(Ptr<Packet> packet, Ipv4Address destination, uint16_
 }
 
 void 
-EdgeApplication::RandomStrategy(Ptr<Packet> packet, Ipv4Address destIp)
+EdgeApplication::TraceSentPacket(TraceKind kind, Ptr<const Packet> packet, uint32_t task)
 {
-  // Determine valid destination range based on available resources
-  uint16_t maxNum = 2;  // 0=Edge, 1=Cloud, 2=VCC
-  uint16_t minNum = 0;
+  TraceRecord record(kind);
+  record.AddUint(TaskRegistry::GetNodeId(task))
+        .AddUint(packet->GetSize())
+        .AddTime(TaskRegistry::GetInitialTime(task))
+        .AddSeconds(Now())
+        .AddUint(TaskRegistry::GetWhere(task))
+        .AddDouble(request_rate)
+        .AddUint(cars_number)
+        .AddUint(pedestrians_number)
+        .AddDouble(edge_computation_capacity)
+        .AddDouble(car_computation_capacity)
+        .AddDouble(TaskRegistry::GetWorkload(task))
+        .AddUint(TaskRegistry::GetCarsInVCC(task))
+        .AddUint(vehicle_queue_length);
+  TraceSinkRegistry::Write(record);
+}
+
+
+void 
+EdgeApplication::OffloadToEdge(Ptr<Packet> packet)
+{
+  NS_LOG_INFO(YELLOW_CODE << "Edge packets in queue " << m_edge_queue->GetNPackets() << END_CODE);
+  NS_LOG_INFO(YELLOW_CODE << "Edge Offloading " << Now().GetSeconds() << END_CODE);
   
-  if (m_edge_queue->GetNPackets() == 100) {
-    // Edge queue full, can only use VCC or Cloud
-    minNum = 1;
+  // Record the arrival and the tier
+  PacketDataTag tag;
+  packet->PeekPacketTag(tag);
+  uint32_t task = tag.GetTaskId();
+  TaskRegistry::SetUplinkTime(task, Now());
+  TaskRegistry::SetWhere(task, 0);  // 0 = Edge
+  
+  // Start on an idle worker, or wait in the shared queue
+  uint32_t worker;
+  if (m_edge_queue->IsEmpty() && m_workers.GetIdleWorker(worker)) {
+    StartEdgeTask(worker, packet);
   }
-  else if (m_neighbors.size() <= 0) {
-    // No vehicles available, can only use Edge or Cloud
-    maxNum = 1;
-  }
-  else if (m_edge_queue->GetNPackets() == 100 && m_neighbors.size() <= 0) {
-    // Only Cloud is available
-    minNum = 1;
-    maxNum = minNum;
+  else if (!m_edge_queue->Enqueue(packet)) {
+    // Dropped by the full queue: recorded in the tasks_ trace only, and takes no worker time
+    TaskRegistry::SetStatus(task, TASK_DROPPED);
+    return;
   }
   
-  // Random selection within valid range
-  Ptr<UniformRandomVariable> randomVar = CreateObject<UniformRandomVariable>();
-  int choice = randomVar->GetInteger(minNum, maxNum);
+  // Only the accepted tasks delay the completions predicted by MinCompletionTime
+  m_workers.Reserve(TaskRegistry::GetWorkload(task), Now());
   
-  // Update packet tag with destination choice
+  // Log edge offloading decision
+  TraceSentPacket(TRACE_EDGE_SENT_PACKETS, packet, task);
+}
+
+void 
+EdgeApplication::OffloadToCloud(Ptr<Packet> packet)
+{
+  NS_LOG_INFO(YELLOW_CODE << "From Edge to Cloud at time " << Now().GetSeconds() << END_CODE);
+  
+  // Record the tier
   PacketDataTag tag;
-  if (packet->RemovePacketTag(tag)) {
-    tag.SetWhere(choice);
-    packet->AddPacketTag(tag);
-  }
+  packet->PeekPacketTag(tag);
+  TaskRegistry::SetWhere(tag.GetTaskId(), 1);  // 1 = Cloud
   
-  switch (choice) {
-    case 0: {  // Edge offloading
-      NS_LOG_INFO(YELLOW_CODE << "Edge Offloading " << Now().GetSeconds() << END_CODE);
-      NS_LOG_INFO(YELLOW_CODE << "Edge packets in queue " << m_edge_queue->GetNPackets() << END_CODE);
-      
-      // Update packet tag and handle queue operations
-      if (packet->RemovePacketTag(tag)) {
-        tag.SetUplinkTime(Seconds(Now().GetSeconds()));
-        packet->AddPacketTag(tag);
-      }
-      
-      if (m_edge_queue->GetNPackets() == 0) {
-        Simulator::ScheduleNow(&ns3::DropTailQueue<Packet>::Enqueue, m_edge_queue, packet);
-        Simulator::ScheduleNow(&EdgeApplication::HandleDequeue, this);
-      }
-      else if (m_edge_queue->GetNPackets() > 0) {
-        Simulator::ScheduleNow(&ns3::DropTailQueue<Packet>::Enqueue, m_edge_queue, packet);
-      }
-      
-      // Log edge offloading decision
-      std::ofstream logFile;
-      std::string filename = output_data_csv + "/total_EDGE_sent_packets_" + sim_type + ".csv";
-      logFile.open(filename, std::ofstream::app);
-      
-      if (logFile.is_open()) {
-        logFile << tag.GetNodeId() << ","
-                << packet->GetSize() << ","
-                << tag.GetInitialTime() << ","
-                << Now().GetSeconds() << ","
-                << tag.GetWhere() << ","
-                << request_rate << ","
-                << cars_number << ","
-                << pedestrians_number << ","
-                << edge_computation_capacity << ","
-                << car_computation_capacity << ","
-                << tag.GetWorkload() << ","
-                << tag.GetCarsInVCC() << ","
-                << vehicle_queue_length << "\n";
-        logFile.close();
-      }
-      
+  // Log cloud offloading decision
+  TraceSentPacket(TRACE_CLOUD_SENT_PACKETS, packet, tag.GetTaskId());
+  
+  // Send packet to cloud
+  SendPacket(packet, cloud_ip, m_port1);
+}
+
+void 
+EdgeApplication::OffloadToVehicle(Ptr<Packet> packet, Ipv4Address vehicleAddress)
+{
+  NS_LOG_INFO(YELLOW_CODE << "From Edge to VC at time " << Now().GetSeconds() << END_CODE);
+  
+  // Record the tier
+  PacketDataTag tag;
+  packet->PeekPacketTag(tag);
+  TaskRegistry::SetWhere(tag.GetTaskId(), 2);  // 2 = VCC
+  
+  // Remember the dispatch time to measure the edge to UE delay
+  TaskRegistry::SetDispatchTime(tag.GetTaskId(), Now());
+  
+  // Log VCC offloading decision
+  TraceSentPacket(TRACE_VCC_SENT_PACKETS, packet, tag.GetTaskId());
+  
+  // Send packet to selected vehicle and remove it from available list right away,
+  // so that a request received at the same instant cannot pick it again
+  SendPacket(packet, vehicleAddress, m_port1);
+  RemoveNeighbor(vehicleAddress);
+}
+
+void 
+EdgeApplication::Offload(Ptr<Packet> packet, const OffloadingDecision& decision)
+{
+  switch (decision.where) {
+    case 0:
+      OffloadToEdge(packet);
       break;
-    }
-    
-    case 1: {  // Cloud offloading
-      NS_LOG_INFO(YELLOW_CODE << "From Edge to Cloud at time " << Now().GetSeconds() << END_CODE);
-      
-      // Send packet to cloud
-      Simulator::ScheduleNow(&EdgeApplication::SendPacket, this, packet, cloud_ip, m_port1);
-      
-      // Log cloud offloading decision
-      std::ofstream logFile;
-      std::string filename = output_data_csv + "/total_CLOUD_sent_packets_" + sim_type + ".csv";
-      logFile.open(filename, std::ofstream::app);
-      
-      if (logFile.is_open() && packet->PeekPacketTag(tag)) {
-        logFile << tag.GetNodeId() << ","
-                << packet->GetSize() << ","
-                << tag.GetInitialTime() << ","
-                << Now().GetSeconds() << ","
-                << tag.GetWhere() << ","
-                << request_rate << ","
-                << cars_number << ","
-                << pedestrians_number << ","
-                << edge_computation_capacity << ","
-                << car_computation_capacity << ","
-                << tag.GetWorkload() << ","
-                << tag.GetCarsInVCC() << ","
-                << vehicle_queue_length << "\n";
-        logFile.close();
-      }
-      
+    case 1:
+      OffloadToCloud(packet);
       break;
-    }
-    
-    case 2: {  // VCC (Vehicle Cloud Computing) offloading
-      NS_LOG_INFO(YELLOW_CODE << "From Edge to VC at time " << Now().GetSeconds() << END_CODE);
-      
-      // Select a random vehicle from neighbors
-      Ptr<UniformRandomVariable> randomVar = CreateObject<UniformRandomVariable>();
-      int idx = randomVar->GetInteger(0, m_neighbors.size() - 1);
-      Ipv4Address vehicleAddress = m_neighbors[idx].neighbor_ip;
-      
-      // Send packet to selected vehicle and remove it from available list
-      Simulator::ScheduleNow(&EdgeApplication::SendPacket, this, packet, vehicleAddress, m_port1);
-      Simulator::ScheduleNow(&EdgeApplication::RemoveNeighbor, this, vehicleAddress);
-      
-      // Log VCC offloading decision
-      std::ofstream logFile;
-      std::string filename = output_data_csv + "/total_VCC_sent_packets_" + sim_type + ".csv";
-      logFile.open(filename, std::ofstream::app);
-      
-      if (logFile.is_open() && packet->PeekPacketTag(tag)) {
-        logFile << tag.GetNodeId() << ","
-                << packet->GetSize() << ","
-                << tag.GetInitialTime() << ","
-                << Now().GetSeconds() << ","
-                << tag.GetWhere() << ","
-                << request_rate << ","
-                << cars_number << ","
-                << pedestrians_number << ","
-                << edge_computation_capacity << ","
-                << car_computation_capacity << ","
-                << tag.GetWorkload() << ","
-                << tag.GetCarsInVCC() << ","
-                << vehicle_queue_length << "\n";
-        logFile.close();
-      }
-      
+    case 2:
+      OffloadToVehicle(packet, decision.vehicle);
       break;
-    }
   }
 }
 
+void 
+EdgeApplication::RandomStrategy(Ptr<Packet> packet, Ipv4Address destIp)
+{
+  PacketDataTag tag;
+  packet->PeekPacketTag(tag);
+  uint32_t task = tag.GetTaskId();
+  Offload(packet, DecideRandom(TaskRegistry::GetTierDraw(task), TaskRegistry::GetVehicleDraw(task)));
+}
+
 void 
 EdgeApplication::FirstVCCStrategy(Ptr<Packet> packet, Ipv4Address destIp, 
                                   bool vccActive, bool edgeActive, bool cloudActive)
 {
+  PacketDataTag tag;
+  packet->PeekPacketTag(tag);
+  Offload(packet, DecideFirstVCC(TaskRegistry::GetVehicleDraw(tag.GetTaskId()),
+                                 vccActive, edgeActive, cloudActive));
+}
+
+void 
+EdgeApplication::MinCompletionTimeStrategy(Ptr<Packet> packet)
+{
+  PacketDataTag tag;
+  packet->PeekPacketTag(tag);
+  Offload(packet, DecideMinCompletionTime(TaskRegistry::GetWorkload(tag.GetTaskId())));
+}
+
+OffloadingDecision
+EdgeApplication::DecideRandom(double tierDraw, double vehicleDraw)
+{
+  // Determine valid destination range based on available resources
+  uint16_t maxNum = 2;  // 0=Edge, 1=Cloud, 2=VCC
+  uint16_t minNum = 0;
+  
+  bool edgeFull = m_edge_queue->GetNPackets() >= m_edge_queue->GetMaxSize().GetValue();
+  
+  if (edgeFull && m_neighbors.GetN() == 0) {
+    // Only Cloud is available
+    minNum = 1;
+    maxNum = minNum;
+  }
+  else if (edgeFull) {
+    // Edge queue full, can only use VCC or Cloud
+    minNum = 1;
+  }
+  else if (m_neighbors.GetN() == 0) {
+    // No vehicles available, can only use Edge or Cloud
+    maxNum = 1;
+  }
+  
+  // Random selection within valid range
+  OffloadingDecision decision;
+  decision.where = minNum + PickIndex(tierDraw, maxNum - minNum + 1);
+  if (decision.where == 2) {
+    // Select a random vehicle from neighbors
+    uint32_t idx = PickIndex(vehicleDraw, m_neighbors.GetN());
+    decision.vehicle = m_neighbors.Get(idx).neighbor_ip;
+  }
+  return decision;
+}
+
+OffloadingDecision
+EdgeApplication::DecideFirstVCC(double vehicleDraw, bool vccActive, bool edgeActive, bool cloudActive)
+{
+  OffloadingDecision decision;
   // VCC offloading (first priority if active and vehicles available)
-  if (m_neighbors.size() > 0 && vccActive) {
-    NS_LOG_INFO(YELLOW_CODE << "From Edge to VC at time " << Now().GetSeconds() << END_CODE);
-    
+  if (m_neighbors.GetN() > 0 && vccActive) {
     // Select a random vehicle from neighbors
-    Ptr<UniformRandomVariable> randomVar = CreateObject<UniformRandomVariable>();
-    int idx = randomVar->GetInteger(0, m_neighbors.size() - 1);
-    Ipv4Address vehicleAddress = m_neighbors[idx].neighbor_ip;
-    
-    // Update packet tag
-    PacketDataTag tag;
-    if (packet->RemovePacketTag(tag)) {
-      tag.SetWhere(2);  // 2 = VCC
-      packet->AddPacketTag(tag);
-    }
-    
-    // Send packet to selected vehicle and remove it from available list
-    Simulator::ScheduleNow(&EdgeApplication::SendPacket, this, packet, vehicleAddress, m_port1);
-    Simulator::ScheduleNow(&EdgeApplication::RemoveNeighbor, this, vehicleAddress);
-
-    // Log VCC offloading decision
-    std::ofstream logFile;
-    std::string filename = output_data_csv + "/total_VCC_sent_packets_" + sim_type + ".csv";
-    logFile.open(filename, std::ofstream::app);
-    
-    if (logFile.is_open() && packet->PeekPacketTag(tag)) {
-      logFile << tag.GetNodeId() << ","
-              << packet->GetSize() << ","
-              << tag.GetInitialTime() << ","
-              << Now().GetSeconds() << ","
-              << tag.GetWhere() << ","
-              << request_rate << ","
-              << cars_number << ","
-              << pedestrians_number << ","
-              << edge_computation_capacity << ","
-              << car_computation_capacity << ","
-              << tag.GetWorkload() << ","
-              << tag.GetCarsInVCC() << ","
-              << vehicle_queue_length << "\n";
-      logFile.close();
-    }
+    uint32_t idx = PickIndex(vehicleDraw, m_neighbors.GetN());
+    decision.where = 2;
+    decision.vehicle = m_neighbors.Get(idx).neighbor_ip;
   }
   // Edge offloading (second priority if active and queue not full)
   else if (m_edge_queue->GetNPackets() < m_edge_queue->GetMaxSize().GetValue() && edgeActive) {
-    NS_LOG_INFO(YELLOW_CODE << "Edge packets in queue " << m_edge_queue->GetNPackets() << END_CODE);
-    NS_LOG_INFO(YELLOW_CODE << "Edge Offloading " << Now().GetSeconds() << END_CODE);
-    
-    // Update packet tag
-    PacketDataTag tag;
-    if (packet->RemovePacketTag(tag)) {
-      tag.SetUplinkTime(Seconds(Now().GetSeconds()));
-      tag.SetWhere(0);  // 0 = Edge
-      packet->AddPacketTag(tag);
-    }
-    
-    // Handle queue operations
-    if (m_edge_queue->GetNPackets() == 0) {
-      Simulator::ScheduleNow(&ns3::DropTailQueue<Packet>::Enqueue, m_edge_queue, packet);
-      Simulator::ScheduleNow(&EdgeApplication::HandleDequeue, this);
-    }
-    else if (m_edge_queue->GetNPackets() > 0) {
-      Simulator::ScheduleNow(&ns3::DropTailQueue<Packet>::Enqueue, m_edge_queue, packet);
-    }
-    
-    // Log edge offloading decision
-    std::ofstream logFile;
-    std::string filename = output_data_csv + "/total_EDGE_sent_packets_" + sim_type + ".csv";
-    logFile.open(filename, std::ofstream::app);
-    
-    if (logFile.is_open()) {
-      logFile << tag.GetNodeId() << ","
-              << packet->GetSize() << ","
-              << tag.GetInitialTime() << ","
-              << Now().GetSeconds() << ","
-              << tag.GetWhere() << ","
-              << request_rate << ","
-              << cars_number << ","
-              << pedestrians_number << ","
-              << edge_computation_capacity << ","
-              << car_computation_capacity << ","
-              << tag.GetWorkload() << ","
-              << tag.GetCarsInVCC() << ","
-              << vehicle_queue_length << "\n";
-      logFile.close();
-    }
+    decision.where = 0;
   }
   // Cloud offloading (last priority if active)
   else if (cloudActive) {
-    NS_LOG_INFO(YELLOW_CODE << "From Edge to Cloud at time " << Now().GetSeconds() << END_CODE);
-    
-    // Update packet tag
-    PacketDataTag tag;
-    if (packet->RemovePacketTag(tag)) {
-      tag.SetWhere(1);  // 1 = Cloud
-      packet->AddPacketTag(tag);
+    decision.where = 1;
+  }
+  return decision;
+}
+
+OffloadingDecision
+EdgeApplication::DecideMinCompletionTime(double workload)
+{
+  // Every response ends with an edge to pedestrian downlink
+  Time uplink = m_ue_uplink.Get();
+  Time downlink = m_ue_downlink.Get();
+  
+  // Cloud: backhaul both ways and the recently measured wait for an instance
+  int choice = 1;  // 0=Edge, 1=Cloud, 2=VCC
+  Time best = m_cloud_backhaul.Get() + m_cloud_queueing.Get() 
+              + Seconds(workload / cloud_computation_capacity) + m_cloud_backhaul.Get() + downlink;
+  Time cloudTime = best;
+  
+  // Edge: wait for the work already assigned to the workers, unless the queue is full
+  Time edgeTime = m_workers.PredictCompletion(workload, Now()) - Now() + downlink;
+  if (m_edge_queue->GetNPackets() < m_edge_queue->GetMaxSize().GetValue() && edgeTime < best) {
+    choice = 0;
+    best = edgeTime;
+  }
+  
+  // Vehicles: request downlink, advertised queue and elaboration, response uplink and downlink.
+  // Only the queue differs between vehicles, so ties are broken uniformly at random.
+  uint32_t vehicle = 0;
+  uint32_t ties = 0;
+  for (uint32_t i = 0; i < m_neighbors.GetN(); i++)
+  {
+    const NeighborInformation& neighbor = m_neighbors.Get(i);
+    Time vehicleTime = downlink
+                       + Seconds((neighbor.queue_state + 1) * workload / car_computation_capacity)
+                       + uplink + downlink;
+    if (vehicleTime < best) {
+      choice = 2;
+      best = vehicleTime;
+      vehicle = i;
+      ties = 1;
     }
-    
-    // Send packet to cloud
-    Simulator::ScheduleNow(&EdgeApplication::SendPacket, this, packet, cloud_ip, m_port1);
-    
-    // Log cloud offloading decision
-    std::ofstream logFile;
-    std::string filename = output_data_csv + "/total_CLOUD_sent_packets_" + sim_type + ".csv";
-    logFile.open(filename, std::ofstream::app);
-    
-    if (logFile.is_open() && packet->PeekPacketTag(tag)) {
-      logFile << tag.GetNodeId() << ","
-              << packet->GetSize() << ","
-              << tag.GetInitialTime() << ","
-              << Now().GetSeconds() << ","
-              << tag.GetWhere() << ","
-              << request_rate << ","
-              << cars_number << ","
-              << pedestrians_number << ","
-              << edge_computation_capacity << ","
-              << car_computation_capacity << ","
-              << tag.GetWorkload() << ","
-              << tag.GetCarsInVCC() << ","
-              << vehicle_queue_length << "\n";
-      logFile.close();
+    else if (choice == 2 && vehicleTime == best && m_tie_break->GetInteger(0, ties++) == 0) {
+      vehicle = i;
     }
   }
+  
+  NS_LOG_INFO(CYAN_CODE << "Predicted completion: cloud " << cloudTime << " edge " << edgeTime
+              << " best " << best << " -> " << choice << END_CODE);
+  
+  OffloadingDecision decision;
+  decision.where = choice;
+  if (choice == 2) {
+    decision.vehicle = m_neighbors.Get(vehicle).neighbor_ip;
+  }
+  return decision;
 }
 
 } // namespace ns3
@@ -21,24 +21,30 @@
 #include "ns3/ssid.h"
 #include "ns3/vector.h"
 
-#include "edge-application.h"
+#include "packet-data-tag.h"
+#include "neighbor-table.h"
+#include "delay-estimator.h"
+#include "edge-worker-pool.h"
+#include "packet-pool.h"
+#include "trace-sink.h"
 
 namespace ns3 {
 
 /**
- * \brief Structure to store information about neighbor vehicles
+ * \brief Where a strategy offloads a task
  */
-typedef struct {
-  uint32_t node_ID;       ///< Node identifier
-  Ipv4Address neighbor_ip; ///< IP address of neighbor
-  Time last_beacon;       ///< Time of last received beacon
-} NeighborInformation;
+struct OffloadingDecision
+{
+  int where = -1;           ///< 0=Edge, 1=Cloud, 2=VCC, -1 if no active tier can take the task
+  Ipv4Address vehicle;      ///< Selected vehicle, when where is 2
+};
 
 /**
  * \brief Implementation of an edge computing application for task offloading
  *
  * This class handles packet reception from pedestrians, processing with simulated 
- * computation delay, and implements different offloading strategies (Random, VCCFirst, etc.)
+ * computation delay on a pool of parallel workers behind a shared queue, and
+ * implements different offloading strategies (Random, VCCFirst, MinCompletionTime, etc.)
  */
 class EdgeApplication : public Application 
 {
@@ -67,6 +73,22 @@ public:
    */
   virtual TypeId GetInstanceTypeId() const;
   
+  /**
+   * \brief Assign the stream of the MinCompletionTime tie break
+   *
+   * \param stream First stream index to use
+   * \return The number of streams assigned
+   */
+  int64_t AssignStreams(int64_t stream);
+  
+  /**
+   * \brief Create the edge workers and size the edge queue from the global configuration
+   *
+   * Called when the application starts; the microbenchmarks call it on an
+   * application that is never started.
+   */
+  void ConfigureResources();
+  
   /**
    * \brief Handle incoming packets on port 7777
    *
@@ -84,9 +106,28 @@ public:
   void HandleResponseFromVehicle(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
   
   /**
-   * \brief Process the next packet in the edge server queue
+   * \brief Start the elaboration of a task on an idle edge worker
+   *
+   * \param worker Index of the worker
+   * \param packet The task packet
+   */
+  void StartEdgeTask(uint32_t worker, Ptr<Packet> packet);
+  
+  /**
+   * \brief Send the response of a task and serve the next queued task on the same worker
+   *
+   * \param worker Index of the worker
+   * \param responsePacket The response to send
+   * \param destination IPv4 address of the pedestrian
+   */
+  void FinishEdgeTask(uint32_t worker, Ptr<Packet> responsePacket, Ipv4Address destination);
+  
+  /**
+   * \brief Write the utilization and queueing delay statistics of the edge workers
+   *
+   * \param filename Output CSV file, overwritten
    */
-  void HandleDequeue();
+  void DumpWorkerStats(std::string filename);
   
   /**
    * \brief Send a packet to the specified destination
@@ -116,9 +157,10 @@ public:
    *
    * \param addr IPv4 address of the neighbor
    * \param nodeId Node ID of the neighbor
+   * \param queueState Tasks queued in the neighbor, as advertised in its beacon
    * \param position Current position of the neighbor
    */
-  void UpdateNeighbor(Ipv4Address addr, uint32_t nodeId, Vector position);
+  void UpdateNeighbor(Ipv4Address addr, uint32_t nodeId, uint32_t queueState, Vector position);
   
   /**
    * \brief Print a list of neighbors for debugging
@@ -127,6 +169,8 @@ public:
   
   /**
    * \brief Remove neighbors that haven't been heard from after some time
+   *
+   * Runs at the earliest neighbor deadline and re-arms itself for the next one.
    */
   void RemoveOldNeighbors();
   
@@ -150,6 +194,69 @@ public:
   void FirstVCCStrategy(Ptr<Packet> packet, Ipv4Address destIp, 
                         bool vccActive, bool edgeActive, bool cloudActive);
   
+  /**
+   * \brief Minimum predicted completion time strategy for task offloading decision
+   *
+   * Predicts the time from now to the response reaching the pedestrian for the
+   * cloud, the edge queue and every available vehicle, from the queued work,
+   * the computation capacities, the task workload and the recently measured
+   * network delays, and offloads to the candidate with the smallest prediction.
+   *
+   * \param packet The packet to offload
+   */
+  void MinCompletionTimeStrategy(Ptr<Packet> packet);
+  
+  /**
+   * \brief Decision of the Random strategy in the current state
+   *
+   * The decision functions only read the edge state (queue, workers, neighbors,
+   * delay estimates); their random choices use the draws of the task
+   * (TaskRegistry::SetDraws), so that every strategy makes them with the same
+   * numbers. They are used by the strategies above and by the controller
+   * microbenchmarks.
+   *
+   * \param tierDraw Uniform draw in [0, 1) of the tier
+   * \param vehicleDraw Uniform draw in [0, 1) of the vehicle
+   * \return Random tier among those that can take the task, and a random vehicle for VCC
+   */
+  OffloadingDecision DecideRandom(double tierDraw, double vehicleDraw);
+  
+  /**
+   * \brief Decision of the prioritized strategies (VCCFirst, EC_and_CC, VCC_and_CC)
+   *
+   * \param vehicleDraw Uniform draw in [0, 1) of the vehicle
+   * \param vccActive Whether VCC offloading is enabled
+   * \param edgeActive Whether edge processing is enabled
+   * \param cloudActive Whether cloud offloading is enabled
+   * \return The first active tier that can take the task
+   */
+  OffloadingDecision DecideFirstVCC(double vehicleDraw, bool vccActive, bool edgeActive, bool cloudActive);
+  
+  /**
+   * \brief Decision of the MinCompletionTime strategy
+   *
+   * \param workload Task workload in millions of instructions
+   * \return The tier, and the vehicle, with the smallest predicted completion time
+   */
+  OffloadingDecision DecideMinCompletionTime(double workload);
+  
+  /**
+   * \brief Offload a task as decided
+   *
+   * \param packet The packet to offload
+   * \param decision Tier and vehicle; the task is dropped if no tier was chosen
+   */
+  void Offload(Ptr<Packet> packet, const OffloadingDecision& decision);
+  
+  /**
+   * \brief Log an offloading decision to the trace of the chosen paradigm
+   *
+   * \param kind Trace of the paradigm (EDGE, CLOUD or VCC sent packets)
+   * \param packet The offloaded packet
+   * \param task The task of the offloaded packet
+   */
+  void TraceSentPacket(TraceKind kind, Ptr<const Packet> packet, uint32_t task);
+  
   // Public members
   Ptr<DropTailQueue<Packet>> m_edge_queue = CreateObject<DropTailQueue<Packet>>();
   double finalElaborationInstant;
@@ -170,13 +277,46 @@ private:
    */
   virtual void StartApplication();
 
+  /**
+   * \brief Schedule RemoveOldNeighbors() at the earliest pending neighbor deadline
+   */
+  void ScheduleNeighborExpiry();
+
+  /**
+   * \brief Queue a task for elaboration at the edge
+   * \param packet The packet to process
+   */
+  void OffloadToEdge(Ptr<Packet> packet);
+
+  /**
+   * \brief Forward a task to the cloud
+   * \param packet The packet to forward
+   */
+  void OffloadToCloud(Ptr<Packet> packet);
+
+  /**
+   * \brief Forward a task to a vehicle and remove the vehicle from the available ones
+   *
+   * \param packet The packet to forward
+   * \param vehicleAddress IPv4 address of the vehicle
+   */
+  void OffloadToVehicle(Ptr<Packet> packet, Ipv4Address vehicleAddress);
+
   // Private members
-  Ptr<Socket> m_recv_socket1;  ///< Socket for receiving data packets
-  Ptr<Socket> m_recv_socket2;  ///< Socket for receiving beacon packets
-  uint16_t m_port1;            ///< Port for receiving data packets (7777)
-  uint16_t m_port2;            ///< Port for receiving beacon packets (8888)
-  Ptr<Socket> m_send_socket;   ///< Socket for sending packets
-  std::vector<NeighborInformation> m_neighbors;  ///< List of neighbor vehicles
+  Ptr<Socket> m_recv_socket1;      ///< Socket for receiving data packets
+  Ptr<Socket> m_recv_socket2;      ///< Socket for receiving beacon packets
+  uint16_t m_port1;                ///< Port for receiving data packets (7777)
+  uint16_t m_port2;                ///< Port for receiving beacon packets (8888)
+  Ptr<Socket> m_send_socket;       ///< Socket for sending packets
+  NeighborTable m_neighbors;       ///< Neighbor vehicles, indexed by address
+  EventId m_expiry_event;          ///< Pending RemoveOldNeighbors() event
+  EdgeWorkerPool m_workers;        ///< Parallel workers serving m_edge_queue
+  DelayEstimator m_ue_uplink;      ///< UE to edge delay (pedestrian requests, vehicle responses)
+  DelayEstimator m_ue_downlink;    ///< Edge to UE delay (requests offloaded to vehicles)
+  DelayEstimator m_cloud_backhaul; ///< One-way edge-cloud delay (cloud responses)
+  DelayEstimator m_cloud_queueing; ///< Wait for a cloud instance (cloud responses)
+  Ptr<UniformRandomVariable> m_tie_break; ///< Random choice among equally loaded vehicles
+  PacketPool m_response_pool;      ///< Responses of the tasks elaborated at the edge
 };
 
 } // namespace ns3
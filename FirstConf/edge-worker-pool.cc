@@ -0,0 +1,170 @@
+/**
+ * Implementation of the edge worker pool
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include "edge-worker-pool.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("EdgeWorkerPool");
+
+EdgeWorkerPool::EdgeWorkerPool()
+{
+  // Workers are created by Configure()
+}
+
+void
+EdgeWorkerPool::Configure(double totalCapacity, uint32_t workers, const std::string& shares)
+{
+  std::vector<double> weights;
+  if (shares.empty())
+  {
+    NS_ABORT_MSG_IF(workers == 0, "The edge needs at least one worker");
+    weights.assign(workers, 1.0);
+  }
+  else
+  {
+    std::stringstream ss(shares);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+      char* end = nullptr;
+      double weight = std::strtod(item.c_str(), &end);
+      NS_ABORT_MSG_IF(end == item.c_str() || *end != '\0' || weight <= 0,
+                      "Invalid edge worker share '" << item << "' in '" << shares << "'");
+      weights.push_back(weight);
+    }
+  }
+
+  double sum = 0;
+  for (double weight : weights)
+  {
+    sum += weight;
+  }
+
+  m_workers.clear();
+  for (double weight : weights)
+  {
+    Worker worker;
+    worker.capacity = totalCapacity * weight / sum;
+    worker.busy = false;
+    worker.tasks = 0;
+    m_workers.push_back(worker);
+  }
+}
+
+uint32_t
+EdgeWorkerPool::GetN() const
+{
+  return static_cast<uint32_t>(m_workers.size());
+}
+
+double
+EdgeWorkerPool::GetCapacity(uint32_t worker) const
+{
+  return m_workers[worker].capacity;
+}
+
+bool
+EdgeWorkerPool::GetIdleWorker(uint32_t& worker) const
+{
+  bool found = false;
+  for (uint32_t i = 0; i < m_workers.size(); i++)
+  {
+    if (!m_workers[i].busy && (!found || m_workers[i].capacity > m_workers[worker].capacity))
+    {
+      worker = i;
+      found = true;
+    }
+  }
+  return found;
+}
+
+void
+EdgeWorkerPool::Start(uint32_t worker, Time now, Time queueingDelay)
+{
+  Worker& w = m_workers[worker];
+  NS_ASSERT_MSG(!w.busy, "Edge worker " << worker << " is already busy");
+  w.busy = true;
+  w.busySince = now;
+  w.tasks++;
+  w.queueing.Record(queueingDelay);
+}
+
+void
+EdgeWorkerPool::Finish(uint32_t worker, Time now)
+{
+  Worker& w = m_workers[worker];
+  w.busy = false;
+  w.busyTime += now - w.busySince;
+}
+
+uint32_t
+EdgeWorkerPool::GetEarliestWorker(double workload, Time now, Time& completion) const
+{
+  uint32_t earliest = 0;
+  for (uint32_t i = 0; i < m_workers.size(); i++)
+  {
+    Time end = Max(m_workers[i].projectedFree, now) + Seconds(workload / m_workers[i].capacity);
+    if (i == 0 || end < completion)
+    {
+      earliest = i;
+      completion = end;
+    }
+  }
+  return earliest;
+}
+
+Time
+EdgeWorkerPool::PredictCompletion(double workload, Time now) const
+{
+  Time completion;
+  GetEarliestWorker(workload, now, completion);
+  return completion;
+}
+
+void
+EdgeWorkerPool::Reserve(double workload, Time now)
+{
+  Time completion;
+  uint32_t worker = GetEarliestWorker(workload, now, completion);
+  m_workers[worker].projectedFree = completion;
+}
+
+void
+EdgeWorkerPool::Dump(const std::string& filename, Time now) const
+{
+  std::ofstream file(filename);
+  if (!file.is_open())
+  {
+    NS_LOG_ERROR("Cannot open edge worker file " << filename);
+    return;
+  }
+
+  file << "worker,capacity_mips,tasks,busy_time_s,utilization,"
+       << "queueing_mean_ms,queueing_p50_ms,queueing_p95_ms,queueing_p99_ms,queueing_max_ms\n";
+  for (uint32_t i = 0; i < m_workers.size(); i++)
+  {
+    const Worker& w = m_workers[i];
+    Time busy = w.busyTime + (w.busy ? now - w.busySince : Seconds(0));
+    double utilization = now.IsStrictlyPositive() ? busy.GetSeconds() / now.GetSeconds() : 0;
+    uint64_t count = w.queueing.GetCount();
+    double mean = count ? w.queueing.GetSum() / 1e6 / count : 0;
+
+    file << i << "," << w.capacity << "," << w.tasks << "," << busy.GetSeconds() << ","
+         << utilization << "," << mean << ","
+         << w.queueing.GetPercentile(50) / 1e6 << ","
+         << w.queueing.GetPercentile(95) / 1e6 << ","
+         << w.queueing.GetPercentile(99) / 1e6 << ","
+         << w.queueing.GetMax() / 1e6 << "\n";
+  }
+}
+
+} // namespace ns3
@@ -0,0 +1,135 @@
+/**
+ * EdgeWorkerPool - Parallel workers of the MEC host behind the shared edge queue
+ *
+ * The edge computation capacity is split among N workers, each with its own
+ * MIPS share, that serve the shared edge queue in FIFO order: a task starts
+ * on the fastest idle worker, or waits in the queue until a worker finishes.
+ * The pool keeps per-worker statistics (tasks served, busy time, queueing
+ * delay histogram) and the projected time at which each worker completes the
+ * work already assigned to it, used by MinCompletionTime to predict the edge
+ * completion time of a new task.
+ */
+
+#ifndef NS3_EDGE_WORKER_POOL_H
+#define NS3_EDGE_WORKER_POOL_H
+
+#include "ns3/nstime.h"
+
+#include "latency-histogram.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Set of parallel edge workers with utilization and queueing statistics
+ */
+class EdgeWorkerPool
+{
+public:
+  EdgeWorkerPool();
+
+  /**
+   * \brief Split a total capacity among the workers
+   *
+   * \param totalCapacity Edge computation capacity (MIPS)
+   * \param workers Number of workers, used when shares is empty
+   * \param shares Comma-separated relative shares, e.g. "2,1,1"; empty for equal shares
+   */
+  void Configure(double totalCapacity, uint32_t workers, const std::string& shares);
+
+  /**
+   * \return The number of workers
+   */
+  uint32_t GetN() const;
+
+  /**
+   * \param worker Worker index
+   * \return The capacity of the worker (MIPS)
+   */
+  double GetCapacity(uint32_t worker) const;
+
+  /**
+   * \brief Find the fastest idle worker
+   * \param worker Receives the worker index
+   * \return false if every worker is busy
+   */
+  bool GetIdleWorker(uint32_t& worker) const;
+
+  /**
+   * \brief Mark a worker busy with a new task
+   *
+   * \param worker Worker index
+   * \param now Start of the elaboration
+   * \param queueingDelay Time the task waited in the edge queue
+   */
+  void Start(uint32_t worker, Time now, Time queueingDelay);
+
+  /**
+   * \brief Mark a worker idle at the end of its task
+   *
+   * \param worker Worker index
+   * \param now End of the elaboration
+   */
+  void Finish(uint32_t worker, Time now);
+
+  /**
+   * \brief Predict when a new task would complete
+   *
+   * List scheduling on the projected completion times: exact for equal
+   * shares, an estimate otherwise.
+   *
+   * \param workload Task workload (MI)
+   * \param now Current time
+   * \return The predicted completion time (absolute)
+   */
+  Time PredictCompletion(double workload, Time now) const;
+
+  /**
+   * \brief Account a new task in the projected completion times
+   *
+   * \param workload Task workload (MI)
+   * \param now Current time
+   */
+  void Reserve(double workload, Time now);
+
+  /**
+   * \brief Write one CSV line of statistics per worker
+   *
+   * \param filename Output file, overwritten
+   * \param now End of the measurement period
+   */
+  void Dump(const std::string& filename, Time now) const;
+
+private:
+  /**
+   * \brief State and statistics of one worker
+   */
+  struct Worker
+  {
+    double capacity;            ///< Computation capacity (MIPS)
+    bool busy;                  ///< Elaborating a task
+    Time busySince;             ///< Start of the current task
+    Time busyTime;              ///< Total time spent on completed tasks
+    Time projectedFree;         ///< Completion of the work assigned so far
+    uint64_t tasks;             ///< Tasks started
+    LatencyHistogram queueing;  ///< Queueing delay of the started tasks
+  };
+
+  /**
+   * \brief Worker with the earliest projected completion of a task
+   *
+   * \param workload Task workload (MI)
+   * \param now Current time
+   * \param completion Receives the completion time
+   * \return The worker index
+   */
+  uint32_t GetEarliestWorker(double workload, Time now, Time& completion) const;
+
+  std::vector<Worker> m_workers;  ///< The workers
+};
+
+} // namespace ns3
+
+#endif // NS3_EDGE_WORKER_POOL_H
@@ -0,0 +1,407 @@
+/**
+ * Implementation of the event profiler and of its scheduler
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/map-scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+
+#include "event-profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <typeindex>
+#include <unordered_map>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("EventProfiler");
+
+namespace {
+
+int64_t
+WallClock()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Readable name of an event type. The events of Simulator::Schedule are
+ * classes local to MakeEvent<F, ...>(): keep F, the member function pointer
+ * type or the lambda with its enclosing function, without the ns3:: prefixes.
+ */
+std::string
+GetEventName(const std::type_info& type)
+{
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+  std::string name = status == 0 ? demangled : type.name();
+  std::free(demangled);
+
+  std::string::size_type start = name.find("MakeEvent<");
+  if (start != std::string::npos)
+  {
+    start += 10;
+    std::string::size_type end = start;
+    int depth = 0;
+    for (; end < name.size(); end++)
+    {
+      char c = name[end];
+      if (c == '<' || c == '(' || c == '[' || c == '{')
+      {
+        depth++;
+      }
+      else if (c == '>' || c == ')' || c == ']' || c == '}')
+      {
+        if (depth-- == 0)
+        {
+          break;
+        }
+      }
+      else if (c == ',' && depth == 0)
+      {
+        break;
+      }
+    }
+    name = name.substr(start, end - start);
+  }
+
+  for (std::string::size_type p; (p = name.find("ns3::")) != std::string::npos;)
+  {
+    name.erase(p, 5);
+  }
+  if (name.compare(0, 5, "void ") == 0)
+  {
+    name.erase(0, 5);
+  }
+  std::replace(name.begin(), name.end(), ';', ':');   // ';' separates the folded frames
+  return name;
+}
+
+/**
+ * Event handed out by the profiling scheduler: times the wrapped event in
+ * the frame of its type. A single instance is reused for every event, so
+ * that profiling does not allocate per event.
+ */
+class ProfiledEvent : public EventImpl
+{
+public:
+  ProfiledEvent()
+    : m_event(nullptr)
+  {
+  }
+
+  ~ProfiledEvent() override
+  {
+    Release();
+  }
+
+  /**
+   * \param event Event taken from the scheduler, whose reference is adopted
+   */
+  void Wrap(EventImpl* event)
+  {
+    Release();
+    m_event = event;
+  }
+
+  /// Drop the reference to the wrapped event
+  void Release()
+  {
+    if (m_event != nullptr)
+    {
+      m_event->Unref();
+      m_event = nullptr;
+    }
+  }
+
+protected:
+  void Notify() override
+  {
+    // The frame is only looked up for the events that run
+    if (!m_event->IsCancelled())
+    {
+      EventProfiler::Push(EventProfiler::GetEventFrame(typeid(*m_event)));
+      m_event->Invoke();
+      EventProfiler::Pop();
+    }
+    Release();
+  }
+
+private:
+  EventImpl* m_event;     ///< Wrapped event
+};
+
+/// Frame of each event type, to avoid a scan of the root frames per event
+std::unordered_map<std::type_index, uint32_t> g_eventFrames;
+
+/// Type and frame of the last event, consecutive events often have the same type
+const std::type_info* g_lastEventType = nullptr;
+uint32_t g_lastEventFrame = 0;
+
+} // namespace
+
+/**
+ * \brief Map scheduler whose events are profiled when they are executed
+ *
+ * Pending events are kept unwrapped, so that cancellation and removal work
+ * as with the map scheduler; each event is handed out through the reused
+ * wrapper when it is taken out. Once the profile was written, e.g. when the
+ * simulator drains the events left at the end of the run, events are handed
+ * out unwrapped.
+ */
+class ProfilingScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId()
+  {
+    static TypeId tid = TypeId("ns3::ProfilingScheduler")
+                          .SetParent<Scheduler>()
+                          .AddConstructor<ProfilingScheduler>();
+    return tid;
+  }
+
+  ProfilingScheduler()
+    : m_events(CreateObject<MapScheduler>()),
+      m_wrapper(Create<ProfiledEvent>())
+  {
+  }
+
+  void Insert(const Event& ev) override
+  {
+    m_events->Insert(ev);
+  }
+
+  bool IsEmpty() const override
+  {
+    return m_events->IsEmpty();
+  }
+
+  Event PeekNext() const override
+  {
+    return m_events->PeekNext();
+  }
+
+  Event RemoveNext() override
+  {
+    Event ev = m_events->RemoveNext();
+    if (EventProfiler::IsEnabled())
+    {
+      // The simulator releases the reference after running the event
+      m_wrapper->Wrap(ev.impl);
+      m_wrapper->Ref();
+      ev.impl = PeekPointer(m_wrapper);
+    }
+    return ev;
+  }
+
+  void Remove(const Event& ev) override
+  {
+    m_events->Remove(ev);
+  }
+
+private:
+  Ptr<Scheduler> m_events;          ///< Pending events
+  Ptr<ProfiledEvent> m_wrapper;     ///< Wrapper of the event being run
+};
+
+NS_OBJECT_ENSURE_REGISTERED(ProfilingScheduler);
+
+bool EventProfiler::s_enabled = false;
+std::vector<EventProfiler::Frame> EventProfiler::s_frames;
+std::vector<EventProfiler::Active> EventProfiler::s_stack;
+int64_t EventProfiler::s_start = 0;
+
+EventProfiler::Scope::Scope(const char* name)
+  : m_active(s_enabled)
+{
+  if (m_active)
+  {
+    uint32_t parent = s_stack.empty() ? 0 : s_stack.back().frame;
+    Push(GetChild(parent, name, name));
+  }
+}
+
+EventProfiler::Scope::~Scope()
+{
+  if (m_active)
+  {
+    Pop();
+  }
+}
+
+void
+EventProfiler::Enable()
+{
+  s_frames.assign(1, Frame{"all", nullptr, 0, {}, 0, 0, 0});
+  s_stack.clear();
+  g_eventFrames.clear();
+  g_lastEventType = nullptr;
+  s_enabled = true;
+  s_start = WallClock();
+
+  ObjectFactory factory;
+  factory.SetTypeId(ProfilingScheduler::GetTypeId());
+  Simulator::SetScheduler(factory);
+}
+
+bool
+EventProfiler::IsEnabled()
+{
+  return s_enabled;
+}
+
+void
+EventProfiler::Reset()
+{
+  for (Frame& frame : s_frames)
+  {
+    frame.count = 0;
+    frame.total = 0;
+    frame.children_time = 0;
+  }
+  s_start = WallClock();
+}
+
+uint32_t
+EventProfiler::GetEventFrame(const std::type_info& type)
+{
+  if (&type == g_lastEventType)
+  {
+    return g_lastEventFrame;
+  }
+  auto it = g_eventFrames.find(std::type_index(type));
+  if (it == g_eventFrames.end())
+  {
+    it = g_eventFrames.emplace(std::type_index(type), GetChild(0, &type, GetEventName(type))).first;
+  }
+  g_lastEventType = &type;
+  g_lastEventFrame = it->second;
+  return it->second;
+}
+
+uint32_t
+EventProfiler::GetChild(uint32_t parent, const void* key, const std::string& name)
+{
+  for (uint32_t child : s_frames[parent].children)
+  {
+    if (s_frames[child].key == key)
+    {
+      return child;
+    }
+  }
+  uint32_t child = s_frames.size();
+  s_frames.push_back(Frame{name, key, parent, {}, 0, 0, 0});
+  s_frames[parent].children.push_back(child);
+  return child;
+}
+
+void
+EventProfiler::Push(uint32_t frame)
+{
+  s_stack.push_back(Active{frame, WallClock()});
+}
+
+void
+EventProfiler::Pop()
+{
+  Active active = s_stack.back();
+  s_stack.pop_back();
+  int64_t elapsed = WallClock() - active.start;
+
+  Frame& frame = s_frames[active.frame];
+  frame.count++;
+  frame.total += elapsed;
+  s_frames[frame.parent].children_time += elapsed;
+}
+
+std::string
+EventProfiler::GetPath(uint32_t frame)
+{
+  std::string path = s_frames[frame].name;
+  for (uint32_t f = s_frames[frame].parent; f != 0; f = s_frames[f].parent)
+  {
+    path = s_frames[f].name + ";" + path;
+  }
+  return path;
+}
+
+void
+EventProfiler::Dump(std::string prefix, uint32_t top)
+{
+  if (!s_enabled)
+  {
+    return;
+  }
+  int64_t wall = WallClock() - s_start;
+
+  // The teardown that follows (draining the pending events, disposing the
+  // nodes) is not part of the run
+  s_enabled = false;
+
+  // Folded stacks: one line per frame with its self time, in microseconds
+  std::ofstream folded(prefix + ".folded");
+  if (!folded.is_open())
+  {
+    NS_LOG_ERROR("Cannot open profile file " << prefix << ".folded");
+    return;
+  }
+  int64_t events = s_frames[0].children_time;
+  std::vector<uint32_t> order;
+  for (uint32_t f = 1; f < s_frames.size(); f++)
+  {
+    int64_t self = s_frames[f].total - s_frames[f].children_time;
+    if (s_frames[f].count > 0 && self / 1000 > 0)
+    {
+      folded << GetPath(f) << " " << self / 1000 << "\n";
+    }
+    if (s_frames[f].count > 0)
+    {
+      order.push_back(f);
+    }
+  }
+  // Time outside the events: event list, simulator and profiler
+  if ((wall - events) / 1000 > 0)
+  {
+    folded << "simulator " << (wall - events) / 1000 << "\n";
+  }
+
+  // Top-N table by self time
+  std::sort(order.begin(), order.end(), [](uint32_t a, uint32_t b) {
+    return s_frames[a].total - s_frames[a].children_time > s_frames[b].total - s_frames[b].children_time;
+  });
+  std::ostringstream table;
+  table << "# wall " << std::fixed << std::setprecision(3) << wall / 1e9 << " s, events "
+        << events / 1e9 << " s, simulator " << (wall - events) / 1e9 << " s\n";
+  table << std::setw(8) << "self %" << std::setw(12) << "self ms" << std::setw(12) << "total ms"
+        << std::setw(12) << "count" << std::setw(10) << "mean us" << "  frame\n";
+  for (uint32_t i = 0; i < order.size() && i < top; i++)
+  {
+    const Frame& frame = s_frames[order[i]];
+    int64_t self = frame.total - frame.children_time;
+    table << std::setw(7) << std::setprecision(2) << (wall > 0 ? 100.0 * self / wall : 0) << "%"
+          << std::setw(12) << std::setprecision(1) << self / 1e6
+          << std::setw(12) << frame.total / 1e6
+          << std::setw(12) << frame.count
+          << std::setw(10) << std::setprecision(2) << frame.total / 1e3 / frame.count
+          << "  " << GetPath(order[i]) << "\n";
+  }
+
+  std::ofstream file(prefix + ".txt");
+  file << table.str();
+  std::cout << table.str();
+  std::cout.flush();
+}
+
+} // namespace ns3
@@ -0,0 +1,137 @@
+/**
+ * EventProfiler - Wall-clock profile of the simulation events
+ *
+ * When enabled (--profileEvents), the simulator runs on a ProfilingScheduler
+ * that hands out every event through one reused wrapper, so that the
+ * wall-clock time and the count of each event that runs are attributed to
+ * the scheduled function (the type of the ns-3 event: the member function
+ * signature, or the lambda and its enclosing function for the NR and ns-3
+ * internals). The application handlers
+ * that are not events themselves (socket callbacks, trace sinks) open a
+ * Scope, which becomes a child frame of the event that called them.
+ *
+ * At the end of the run the profile is written in folded-stack form
+ * (event_profile_<simType>.folded, self time in microseconds, for
+ * flamegraph.pl or speedscope) and as a top-N table by self time.
+ */
+
+#ifndef NS3_EVENT_PROFILER_H
+#define NS3_EVENT_PROFILER_H
+
+#include <cstdint>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Simulation-wide profile of the events and of the application handlers
+ */
+class EventProfiler
+{
+public:
+  /**
+   * \brief Profile a handler, as a child of the running event, for the lifetime of the scope
+   *
+   * Costs one test when profiling is disabled.
+   */
+  class Scope
+  {
+  public:
+    /**
+     * \param name Frame name; must be a string literal (its address identifies the frame)
+     */
+    explicit Scope(const char* name);
+    ~Scope();
+
+  private:
+    bool m_active;          ///< Profiling was enabled at construction
+  };
+
+  /**
+   * \brief Run the simulator on the profiling scheduler
+   */
+  static void Enable();
+
+  /**
+   * \return True if the events are profiled
+   */
+  static bool IsEnabled();
+
+  /**
+   * \brief Zero the profile, e.g. at the start of a forked replication
+   */
+  static void Reset();
+
+  /**
+   * \brief Write the folded stacks and the top-N table, and print the table
+   *
+   * Profiling stops here, so that the teardown of the simulation is not counted.
+   *
+   * \param prefix Output path without extension (.folded and .txt are added)
+   * \param top Number of rows of the table
+   */
+  static void Dump(std::string prefix, uint32_t top);
+
+  /**
+   * \brief Open the frame of an event type (used by the profiling scheduler)
+   * \param type Type of the ns-3 event implementation
+   * \return Frame of the event type, below the root
+   */
+  static uint32_t GetEventFrame(const std::type_info& type);
+
+  /**
+   * \brief Enter a frame
+   * \param frame Frame to enter
+   */
+  static void Push(uint32_t frame);
+
+  /**
+   * \brief Leave the innermost frame and account its time
+   */
+  static void Pop();
+
+private:
+  /// One node of the call tree
+  struct Frame
+  {
+    std::string name;               ///< Frame name
+    const void* key;                ///< type_info or literal identifying the frame
+    uint32_t parent;                ///< Parent frame
+    std::vector<uint32_t> children; ///< Child frames
+    uint64_t count;                 ///< Calls
+    int64_t total;                  ///< Wall-clock time, including the children (ns)
+    int64_t children_time;          ///< Wall-clock time of the children (ns)
+  };
+
+  /// A frame being executed
+  struct Active
+  {
+    uint32_t frame;                 ///< Frame
+    int64_t start;                  ///< Wall clock at entry (ns)
+  };
+
+  /**
+   * \brief Find or create a child frame
+   * \param parent Parent frame
+   * \param key type_info or literal identifying the child
+   * \param name Name of the child, used if it is created
+   * \return The child frame
+   */
+  static uint32_t GetChild(uint32_t parent, const void* key, const std::string& name);
+
+  /**
+   * \return Names from the root to a frame, separated by ';'
+   */
+  static std::string GetPath(uint32_t frame);
+
+  static bool s_enabled;                ///< Profiling enabled
+  static std::vector<Frame> s_frames;   ///< Call tree, frame 0 is the root
+  static std::vector<Active> s_stack;   ///< Frames being executed
+  static int64_t s_start;               ///< Wall clock at Enable() or Reset() (ns)
+};
+
+} // namespace ns3
+
+#endif // NS3_EVENT_PROFILER_H
@@ -8,13 +8,15 @@
 
 #include "globals.h"
 
+#include <limits>
+
 namespace ns3 {
 
 //---------- Strategy and configuration ----------
 // Path for output CSV files
 std::string output_data_csv;
 
-// Selected offloading strategy ("Random", "VCCFirst", "EC_and_CC", "VCC_and_CC")
+// Selected offloading strategy ("Random", "VCCFirst", "EC_and_CC", "VCC_and_CC", "MinCompletionTime")
 std::string chosen_strategy;
 
 // Simulation scenario type identifier
@@ -39,6 +41,9 @@ uint32_t packet_size;
 // Workload for each task in millions of instructions
 double task_workload;
 
+// Time from which the pedestrians send no new requests, so that the last ones drain (seconds)
+double requests_end_time = std::numeric_limits<double>::infinity();
+
 //---------- Network addresses ----------
 // Cloud server IP address
 Ipv4Address cloud_ip = Ipv4Address("0.0.0.0");
@@ -47,7 +52,7 @@ Ipv4Address cloud_ip = Ipv4Address("0.0.0.0");
 Ipv4Address gNb_ip = Ipv4Address("0.0.0.0");
 
 //---------- Computation capacities ----------
-// Cloud server computation capacity (in MIPS)
+// Cloud server computation capacity, per instance (in MIPS)
 double cloud_computation_capacity = 80000;
 
 // Edge server computation capacity (in MIPS)
@@ -56,4 +61,45 @@ double edge_computation_capacity = 27650;
 // Vehicle computation capacity (in MIPS)
 double car_computation_capacity = 1925;
 
+// Number of parallel edge workers sharing the edge capacity
+uint32_t edge_workers = 1;
+
+// Comma-separated capacity shares of the edge workers (empty for equal shares)
+std::string edge_worker_shares;
+
+// Maximum number of tasks waiting for an edge worker
+uint32_t edge_queue_size = 100;
+
+//---------- Cloud server pool ----------
+// Instances in service at the start (and minimum when autoscaling)
+uint32_t cloud_instances = 1;
+
+// Maximum number of instances; autoscaling is enabled when above cloud_instances
+uint32_t cloud_max_instances = 1;
+
+// Maximum number of tasks waiting for a cloud instance
+uint32_t cloud_queue_size = 1000;
+
+// Time for a new instance to enter service (seconds)
+double cloud_scale_out_delay = 30;
+
+// Period of the autoscaling decision (seconds)
+double cloud_scale_interval = 1;
+
+// Queued tasks per instance above which the pool scales out
+double cloud_scale_out_queue = 2;
+
+// Utilization over the last period below which the pool scales in
+double cloud_scale_in_utilization = 0.3;
+
+//---------- Vehicle beaconing ----------
+// Beaconing mode of the vehicles ("fixed", "delta", "adaptive")
+std::string beacon_mode = "fixed";
+
+// Position drift that triggers a beacon in the delta and adaptive modes (meters)
+double beacon_drift = 10;
+
+// Time after its last beacon at which the edge forgets a vehicle (seconds)
+double neighbor_timeout = 0.5;
+
 } // namespace ns3
@@ -22,7 +22,7 @@ namespace ns3
  */
 // Path for output CSV files
 extern std::string output_data_csv;
-// Selected offloading strategy ("Random", "VCCFirst", "EC_and_CC", "VCC_and_CC")
+// Selected offloading strategy ("Random", "VCCFirst", "EC_and_CC", "VCC_and_CC", "MinCompletionTime")
 extern std::string chosen_strategy;
 // Simulation scenario type identifier
 extern std::string sim_type;
@@ -42,6 +42,8 @@ extern uint32_t vehicle_queue_length;
 extern uint32_t packet_size;
 // Task workload in millions of instructions
 extern double task_workload;
+// Time from which the pedestrians send no new requests, so that the last ones drain (seconds)
+extern double requests_end_time;
 
 /**
  * Network addresses
@@ -54,12 +56,46 @@ extern Ipv4Address gNb_ip;
 /**
  * Computation capacities (in MIPS - Million Instructions Per Second)
  */
-// Cloud server computation capacity
+// Cloud server computation capacity, per instance
 extern double cloud_computation_capacity;
 // Edge server computation capacity
 extern double edge_computation_capacity;
 // Vehicle computation capacity
 extern double car_computation_capacity;
+// Number of parallel edge workers sharing the edge capacity
+extern uint32_t edge_workers;
+// Comma-separated capacity shares of the edge workers (empty for equal shares)
+extern std::string edge_worker_shares;
+// Maximum number of tasks waiting for an edge worker
+extern uint32_t edge_queue_size;
+
+/**
+ * Cloud server pool
+ */
+// Instances in service at the start (and minimum when autoscaling)
+extern uint32_t cloud_instances;
+// Maximum number of instances; autoscaling is enabled when above cloud_instances
+extern uint32_t cloud_max_instances;
+// Maximum number of tasks waiting for a cloud instance
+extern uint32_t cloud_queue_size;
+// Time for a new instance to enter service (seconds)
+extern double cloud_scale_out_delay;
+// Period of the autoscaling decision (seconds)
+extern double cloud_scale_interval;
+// Queued tasks per instance above which the pool scales out
+extern double cloud_scale_out_queue;
+// Utilization over the last period below which the pool scales in
+extern double cloud_scale_in_utilization;
+
+/**
+ * Vehicle beaconing
+ */
+// Beaconing mode of the vehicles ("fixed", "delta", "adaptive")
+extern std::string beacon_mode;
+// Position drift that triggers a beacon in the delta and adaptive modes (meters)
+extern double beacon_drift;
+// Time after its last beacon at which the edge forgets a vehicle (seconds)
+extern double neighbor_timeout;
 
 } // namespace ns3
 
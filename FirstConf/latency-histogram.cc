@@ -0,0 +1,256 @@
+/**
+ * Implementation of the streaming latency histograms
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include "latency-histogram.h"
+
+#include <fstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("LatencyHistogram");
+
+namespace {
+
+const uint64_t SUB_BUCKET_COUNT = 1ULL << LatencyHistogram::SUB_BUCKET_BITS;
+
+uint32_t
+MostSignificantBit(uint64_t value)
+{
+  return 63 - __builtin_clzll(value);
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// LatencyHistogram
+//------------------------------------------------------------------------------
+
+LatencyHistogram::LatencyHistogram()
+  : m_count(0),
+    m_min(0),
+    m_max(0),
+    m_sum(0)
+{
+  // Buckets are allocated on the first Record()
+}
+
+uint32_t
+LatencyHistogram::GetBucketIndex(uint64_t value)
+{
+  // Values below 2 * SUB_BUCKET_COUNT have their own bucket
+  if (value < 2 * SUB_BUCKET_COUNT)
+  {
+    return static_cast<uint32_t>(value);
+  }
+  uint32_t shift = MostSignificantBit(value) - SUB_BUCKET_BITS;
+  return static_cast<uint32_t>(shift * SUB_BUCKET_COUNT + (value >> shift));
+}
+
+uint64_t
+LatencyHistogram::GetBucketLowerBound(uint32_t index)
+{
+  if (index < 2 * SUB_BUCKET_COUNT)
+  {
+    return index;
+  }
+  uint32_t shift = static_cast<uint32_t>(index / SUB_BUCKET_COUNT - 1);
+  return (index - shift * SUB_BUCKET_COUNT) << shift;
+}
+
+void
+LatencyHistogram::Record(Time value)
+{
+  int64_t ns = value.GetNanoSeconds();
+  uint64_t v = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+
+  uint32_t index = GetBucketIndex(v);
+  if (index >= m_counts.size())
+  {
+    m_counts.resize(index + 1, 0);
+  }
+  ++m_counts[index];
+
+  if (m_count == 0 || v < m_min)
+  {
+    m_min = v;
+  }
+  if (v > m_max)
+  {
+    m_max = v;
+  }
+  m_sum += v;
+  ++m_count;
+}
+
+void
+LatencyHistogram::Merge(const LatencyHistogram& other)
+{
+  if (other.m_count == 0)
+  {
+    return;
+  }
+  if (other.m_counts.size() > m_counts.size())
+  {
+    m_counts.resize(other.m_counts.size(), 0);
+  }
+  for (size_t i = 0; i < other.m_counts.size(); ++i)
+  {
+    m_counts[i] += other.m_counts[i];
+  }
+  m_min = (m_count == 0 || other.m_min < m_min) ? other.m_min : m_min;
+  m_max = other.m_max > m_max ? other.m_max : m_max;
+  m_sum += other.m_sum;
+  m_count += other.m_count;
+}
+
+uint64_t
+LatencyHistogram::GetCount() const
+{
+  return m_count;
+}
+
+uint64_t
+LatencyHistogram::GetSum() const
+{
+  return m_sum;
+}
+
+uint64_t
+LatencyHistogram::GetMax() const
+{
+  return m_max;
+}
+
+uint64_t
+LatencyHistogram::GetPercentile(double percentile) const
+{
+  if (m_count == 0)
+  {
+    return 0;
+  }
+  // Rank of the requested value, 1-based (nearest-rank definition)
+  uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * m_count + 0.5);
+  rank = rank < 1 ? 1 : (rank > m_count ? m_count : rank);
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < m_counts.size(); ++i)
+  {
+    seen += m_counts[i];
+    if (seen >= rank)
+    {
+      return GetBucketLowerBound(static_cast<uint32_t>(i));
+    }
+  }
+  return GetBucketLowerBound(static_cast<uint32_t>(m_counts.size() - 1));
+}
+
+void
+LatencyHistogram::Serialize(std::ostream& os) const
+{
+  os << m_count << "," << m_min << "," << m_max << "," << m_sum << ",";
+  bool first = true;
+  for (size_t i = 0; i < m_counts.size(); ++i)
+  {
+    if (m_counts[i] != 0)
+    {
+      os << (first ? "" : " ") << i << ":" << m_counts[i];
+      first = false;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// LatencyHistograms
+//------------------------------------------------------------------------------
+
+bool LatencyHistograms::s_enabled = false;
+std::string LatencyHistograms::s_strategy;
+std::string LatencyHistograms::s_run;
+LatencyHistogram LatencyHistograms::s_histograms[TIER_COUNT][LATENCY_COMPONENT_COUNT];
+
+void
+LatencyHistograms::Enable(const std::string& strategy, const std::string& run)
+{
+  s_enabled = true;
+  s_strategy = strategy;
+  s_run = run;
+}
+
+bool
+LatencyHistograms::IsEnabled()
+{
+  return s_enabled;
+}
+
+void
+LatencyHistograms::Record(uint32_t tier, LatencyComponent component, Time value)
+{
+  if (s_enabled && tier < TIER_COUNT)
+  {
+    s_histograms[tier][component].Record(value);
+  }
+}
+
+const LatencyHistogram&
+LatencyHistograms::Get(uint32_t tier, LatencyComponent component)
+{
+  NS_ABORT_MSG_IF(tier >= TIER_COUNT, "Unknown offloading tier " << tier);
+  return s_histograms[tier][component];
+}
+
+const char*
+LatencyHistograms::GetComponentName(LatencyComponent component)
+{
+  static const char* names[LATENCY_COMPONENT_COUNT] = {
+    "total", "uplink", "queueing", "elaboration", "downlink"
+  };
+  return names[component];
+}
+
+const char*
+LatencyHistograms::GetTierName(uint32_t tier)
+{
+  static const char* names[TIER_COUNT] = {"EDGE", "CLOUD", "VCC"};
+  return tier < TIER_COUNT ? names[tier] : "UNKNOWN";
+}
+
+void
+LatencyHistograms::Dump(const std::string& filename)
+{
+  if (!s_enabled)
+  {
+    return;
+  }
+
+  std::ofstream file(filename);
+  if (!file.is_open())
+  {
+    NS_LOG_ERROR("Cannot open histogram file " << filename);
+    return;
+  }
+
+  // Header: format version and bucket layout, needed to merge dumps
+  file << "# coe-latency-histogram v1 sub_bucket_bits=" << LatencyHistogram::SUB_BUCKET_BITS << "\n";
+  file << "# strategy,run,tier,component,count,min_ns,max_ns,sum_ns,buckets\n";
+  for (uint32_t tier = 0; tier < TIER_COUNT; ++tier)
+  {
+    for (uint32_t c = 0; c < LATENCY_COMPONENT_COUNT; ++c)
+    {
+      const LatencyHistogram& histogram = s_histograms[tier][c];
+      if (histogram.GetCount() == 0)
+      {
+        continue;
+      }
+      file << s_strategy << "," << s_run << "," << GetTierName(tier) << ","
+           << GetComponentName(static_cast<LatencyComponent>(c)) << ",";
+      histogram.Serialize(file);
+      file << "\n";
+    }
+  }
+}
+
+} // namespace ns3
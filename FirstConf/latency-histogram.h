@@ -0,0 +1,176 @@
+/**
+ * LatencyHistogram - Streaming log-bucketed latency histograms
+ *
+ * Offloading times and their components are accumulated during the run in
+ * HDR-style histograms (exact below 2^SUB_BUCKET_BITS ns, then a fixed number
+ * of linear sub-buckets per power of two, i.e. < 1% relative error). At the
+ * end of the run the non-empty buckets are dumped in a compact text form that
+ * can be merged across replications by merge_latency_histograms.py.
+ */
+
+#ifndef NS3_LATENCY_HISTOGRAM_H
+#define NS3_LATENCY_HISTOGRAM_H
+
+#include "ns3/nstime.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Log-bucketed histogram of non-negative nanosecond values
+ */
+class LatencyHistogram
+{
+public:
+  /// Linear sub-buckets per power of two: 2^SUB_BUCKET_BITS
+  static const uint32_t SUB_BUCKET_BITS = 7;
+
+  LatencyHistogram();
+
+  /**
+   * \brief Add one value
+   * \param value Duration; negative values are counted as zero
+   */
+  void Record(Time value);
+
+  /**
+   * \brief Add all the values of another histogram
+   * \param other Histogram with the same layout
+   */
+  void Merge(const LatencyHistogram& other);
+
+  /**
+   * \return The number of recorded values
+   */
+  uint64_t GetCount() const;
+
+  /**
+   * \return The sum of the recorded values, in nanoseconds
+   */
+  uint64_t GetSum() const;
+
+  /**
+   * \return The largest recorded value, in nanoseconds
+   */
+  uint64_t GetMax() const;
+
+  /**
+   * \brief Get a percentile, resolved to the bucket it falls in
+   * \param percentile Percentile in [0, 100]
+   * \return Lower bound of the bucket, in nanoseconds
+   */
+  uint64_t GetPercentile(double percentile) const;
+
+  /**
+   * \brief Write the histogram as "count,min,max,sum,index:count ..." (non-empty buckets only)
+   * \param os Output stream
+   */
+  void Serialize(std::ostream& os) const;
+
+  /**
+   * \brief Get the bucket of a value
+   * \param value Value in nanoseconds
+   * \return Bucket index
+   */
+  static uint32_t GetBucketIndex(uint64_t value);
+
+  /**
+   * \brief Get the smallest value of a bucket
+   * \param index Bucket index
+   * \return Lower bound in nanoseconds
+   */
+  static uint64_t GetBucketLowerBound(uint32_t index);
+
+private:
+  std::vector<uint64_t> m_counts;   ///< Count per bucket, grown on demand
+  uint64_t m_count;                 ///< Number of recorded values
+  uint64_t m_min;                   ///< Smallest recorded value (ns)
+  uint64_t m_max;                   ///< Largest recorded value (ns)
+  uint64_t m_sum;                   ///< Sum of the recorded values (ns)
+};
+
+/**
+ * \brief Offloading time components tracked by LatencyHistograms
+ */
+enum LatencyComponent
+{
+  LATENCY_TOTAL = 0,      ///< Request creation to response reception
+  LATENCY_UPLINK,         ///< Request creation to arrival at the processing node
+  LATENCY_QUEUEING,       ///< Arrival to start of elaboration
+  LATENCY_ELABORATION,    ///< Elaboration time
+  LATENCY_DOWNLINK,       ///< End of elaboration to response reception
+  LATENCY_COMPONENT_COUNT
+};
+
+/**
+ * \brief Per-run registry of latency histograms keyed by tier and component
+ *
+ * The strategy and run (simulation type) are fixed for a process and are
+ * written in every dumped line, so dumps of different runs can be merged.
+ */
+class LatencyHistograms
+{
+public:
+  /// Number of offloading tiers (0=Edge, 1=Cloud, 2=VCC)
+  static const uint32_t TIER_COUNT = 3;
+
+  /**
+   * \brief Enable recording for a run
+   *
+   * \param strategy Offloading strategy name
+   * \param run Run identifier (the simulation type)
+   */
+  static void Enable(const std::string& strategy, const std::string& run);
+
+  /**
+   * \return true if Enable() was called
+   */
+  static bool IsEnabled();
+
+  /**
+   * \brief Record one component of a completed request
+   *
+   * \param tier Offloading tier (0=Edge, 1=Cloud, 2=VCC)
+   * \param component The component
+   * \param value The duration
+   */
+  static void Record(uint32_t tier, LatencyComponent component, Time value);
+
+  /**
+   * \brief Write all non-empty histograms to a file
+   * \param filename Output file, overwritten
+   */
+  static void Dump(const std::string& filename);
+
+  /**
+   * \brief Get a histogram
+   *
+   * \param tier Offloading tier
+   * \param component The component
+   * \return The histogram
+   */
+  static const LatencyHistogram& Get(uint32_t tier, LatencyComponent component);
+
+  /**
+   * \return Name used for a component in the dump
+   */
+  static const char* GetComponentName(LatencyComponent component);
+
+  /**
+   * \return Name used for a tier in the dump
+   */
+  static const char* GetTierName(uint32_t tier);
+
+private:
+  static bool s_enabled;                  ///< Recording enabled
+  static std::string s_strategy;          ///< Strategy of the run
+  static std::string s_run;               ///< Run identifier
+  static LatencyHistogram s_histograms[TIER_COUNT][LATENCY_COMPONENT_COUNT];
+};
+
+} // namespace ns3
+
+#endif // NS3_LATENCY_HISTOGRAM_H
@@ -0,0 +1,337 @@
+/**
+ * Implementation of the Manhattan grid mobility generator
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include "manhattan-mobility.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("ManhattanMobility");
+
+namespace {
+
+// Default vehicle type of SUMO (passenger car, Krauss model)
+const double VEHICLE_LENGTH = 5.0;      // m
+const double VEHICLE_MIN_GAP = 2.5;     // m
+const double VEHICLE_ACCEL = 2.6;       // m/s^2
+const double VEHICLE_DECEL = 4.5;       // m/s^2
+const double VEHICLE_SIGMA = 0.5;       // Driver imperfection
+const double VEHICLE_TAU = 1.0;         // Reaction time, s
+const double LANE_WIDTH = 3.2;          // m
+
+// Turn ratios of jtrrouter (--turn-defaults 30,50,20); U-turns only at dead ends
+const double TURN_RIGHT = 0.3;
+const double TURN_STRAIGHT = 0.5;
+const double TURN_LEFT = 0.2;
+
+const uint32_t NO_EDGE = UINT32_MAX;
+
+/// Uniform draw in [0, 1), identical on every standard library
+double
+Uniform(std::mt19937_64& rng)
+{
+  return (rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+} // namespace
+
+ManhattanMobilityGenerator::ManhattanMobilityGenerator(const ManhattanGridParameters& params,
+                                                       uint64_t seed)
+  : m_params(params),
+    m_rng(seed)
+{
+  NS_ABORT_MSG_IF(params.gridNumber < 2, "A Manhattan grid needs at least 2 junctions per side");
+  NS_ABORT_MSG_IF(params.xLength <= 0 || params.yLength <= 0, "Invalid Manhattan street lengths");
+  NS_ABORT_MSG_IF(params.lanes == 0 || params.speedLimit <= 0 || params.step <= 0,
+                  "Invalid Manhattan grid parameters");
+  NS_ABORT_MSG_IF(params.tolerance < 0, "The Manhattan waypoint tolerance cannot be negative");
+
+  // Junction (i, j) sits at (i * xLength, j * yLength), as in netgenerate
+  uint32_t n = params.gridNumber;
+  m_out.resize(n * n);
+  auto addStreet = [this](uint32_t a, uint32_t b, double length, double dx, double dy) {
+    m_out[a].push_back(m_edges.size());
+    m_edges.push_back({a, b, length, dx, dy});
+    m_out[b].push_back(m_edges.size());
+    m_edges.push_back({b, a, length, -dx, -dy});
+  };
+  for (uint32_t j = 0; j < n; j++)
+  {
+    for (uint32_t i = 0; i < n; i++)
+    {
+      if (i + 1 < n)
+      {
+        addStreet(j * n + i, j * n + i + 1, params.xLength, 1, 0);
+      }
+      if (j + 1 < n)
+      {
+        addStreet(j * n + i, (j + 1) * n + i, params.yLength, 0, 1);
+      }
+    }
+  }
+}
+
+uint32_t
+ManhattanMobilityGenerator::ChooseNext(uint32_t edge)
+{
+  const Edge& in = m_edges[edge];
+  const std::vector<uint32_t>& out = m_out[in.to];
+  double weights[4];
+  double total = 0;
+  uint32_t uturn = NO_EDGE;
+  for (uint32_t k = 0; k < out.size(); k++)
+  {
+    const Edge& e = m_edges[out[k]];
+    double dot = in.dx * e.dx + in.dy * e.dy;
+    double cross = in.dx * e.dy - in.dy * e.dx;
+    weights[k] = dot > 0.5 ? TURN_STRAIGHT : cross > 0.5 ? TURN_LEFT : cross < -0.5 ? TURN_RIGHT : 0;
+    if (weights[k] == 0)
+    {
+      uturn = out[k];
+    }
+    total += weights[k];
+  }
+  if (total == 0)
+  {
+    return uturn;
+  }
+
+  double draw = Uniform(m_rng) * total;
+  for (uint32_t k = 0; k < out.size(); k++)
+  {
+    if (draw < weights[k])
+    {
+      return out[k];
+    }
+    draw -= weights[k];
+  }
+  // Rounding: the last street with a non-zero weight
+  for (uint32_t k = out.size(); k-- > 0;)
+  {
+    if (weights[k] > 0)
+    {
+      return out[k];
+    }
+  }
+  return uturn;
+}
+
+double
+ManhattanMobilityGenerator::SafeSpeed(double speed, double leaderSpeed, double gap) const
+{
+  return leaderSpeed + (gap - leaderSpeed * VEHICLE_TAU) /
+                       ((speed + leaderSpeed) / (2 * VEHICLE_DECEL) + VEHICLE_TAU);
+}
+
+WaypointTraceSample
+ManhattanMobilityGenerator::Position(const Vehicle& v, double time) const
+{
+  const Edge& e = m_edges[v.edge];
+  uint32_t n = m_params.gridNumber;
+  // Right-hand traffic: lane 0 is the rightmost one
+  double offset = (m_params.lanes - v.lane - 0.5) * LANE_WIDTH;
+  double x = (e.from % n) * m_params.xLength + e.dx * v.pos + e.dy * offset;
+  double y = (e.from / n) * m_params.yLength + e.dy * v.pos - e.dx * offset;
+  return {static_cast<float>(time), static_cast<float>(x), static_cast<float>(y)};
+}
+
+ManhattanMobilityGenerator::Run
+ManhattanMobilityGenerator::StartRun(uint32_t edge, double time, double pos)
+{
+  double unbounded = std::numeric_limits<double>::infinity();
+  return Run{edge, time, pos, time, pos, false, -unbounded, unbounded};
+}
+
+Ptr<WaypointTrace>
+ManhattanMobilityGenerator::Generate(uint32_t nVehicles)
+{
+  uint32_t lanes = m_params.lanes;
+  std::vector<std::vector<uint32_t>> laneVehicles(m_edges.size() * lanes);
+  auto laneOf = [lanes](const Vehicle& v) { return v.edge * lanes + v.lane; };
+  auto byPosition = [](std::vector<Vehicle>& vehicles) {
+    return [&vehicles](uint32_t a, uint32_t b) { return vehicles[a].pos > vehicles[b].pos; };
+  };
+
+  // Departures: random position on a random lane (departPos="random"), at the speed limit
+  // (departSpeed="max"); positions too close to a vehicle already inserted are drawn again
+  double totalLength = 0;
+  for (const Edge& e : m_edges)
+  {
+    totalLength += e.length;
+  }
+  std::vector<Vehicle> vehicles(nVehicles);
+  uint32_t skipped = 0;
+  for (uint32_t i = 0; i < nVehicles; i++)
+  {
+    Vehicle& v = vehicles[i];
+    bool free = false;
+    for (uint32_t attempt = 0; attempt < 100 && !free; attempt++)
+    {
+      double draw = Uniform(m_rng) * totalLength;
+      v.edge = 0;
+      while (v.edge + 1 < m_edges.size() && draw >= m_edges[v.edge].length)
+      {
+        draw -= m_edges[v.edge].length;
+        v.edge++;
+      }
+      v.pos = std::min(draw, m_edges[v.edge].length);
+      v.lane = std::min<uint32_t>(Uniform(m_rng) * lanes, lanes - 1);
+      free = true;
+      for (uint32_t other : laneVehicles[laneOf(v)])
+      {
+        free = free && std::abs(vehicles[other].pos - v.pos) >= VEHICLE_LENGTH + VEHICLE_MIN_GAP;
+      }
+    }
+    if (!free)
+    {
+      // The grid is full: like a vehicle that SUMO cannot insert, it gets no waypoints
+      // (its node stays at the origin)
+      v.edge = NO_EDGE;
+      skipped++;
+      continue;
+    }
+    v.speed = m_params.speedLimit;
+    v.next = ChooseNext(v.edge);
+    laneVehicles[laneOf(v)].push_back(i);
+  }
+  if (skipped > 0)
+  {
+    NS_LOG_WARN(skipped << " of " << nVehicles << " vehicles could not be placed on the grid "
+                << "without overlapping another one: they have no waypoints");
+  }
+
+  // A waypoint ends a run of steps on the same street (anchored at the previous
+  // waypoint) once the positions of the run can no longer be interpolated from
+  // the anchor within the tolerance, as fcd_to_waypoints.py --tolerance does.
+  // The positions are on a straight line, so each step of the run bounds the
+  // speed of the interpolation; the run extends while the speed to the new
+  // position is within all the bounds.
+  std::vector<std::vector<WaypointTraceSample>> waypoints(nVehicles);
+  std::vector<Run> runs(nVehicles);
+  for (uint32_t i = 0; i < nVehicles; i++)
+  {
+    if (vehicles[i].edge != NO_EDGE)
+    {
+      waypoints[i].push_back(Position(vehicles[i], 0));
+      runs[i] = StartRun(vehicles[i].edge, 0, vehicles[i].pos);
+    }
+  }
+
+  double dt = m_params.step;
+  double tolerance = m_params.tolerance;
+  uint64_t steps = std::llround(m_params.duration / dt);
+  std::vector<double> speeds(nVehicles);
+  for (uint64_t step = 1; step <= steps; step++)
+  {
+    // Krauss: accelerate up to the speed limit, stay below the safe speed behind the
+    // leader (on the same lane, or on the lane ahead after the junction), then dawdle
+    for (std::vector<uint32_t>& lane : laneVehicles)
+    {
+      std::sort(lane.begin(), lane.end(), byPosition(vehicles));
+    }
+    for (const std::vector<uint32_t>& lane : laneVehicles)
+    {
+      for (uint32_t k = 0; k < lane.size(); k++)
+      {
+        const Vehicle& v = vehicles[lane[k]];
+        double vMax = std::min(m_params.speedLimit, v.speed + VEHICLE_ACCEL * dt);
+        const Vehicle* leader = nullptr;
+        double gap = 0;
+        if (k > 0)
+        {
+          leader = &vehicles[lane[k - 1]];
+          gap = leader->pos - v.pos;
+        }
+        else
+        {
+          const std::vector<uint32_t>& ahead = laneVehicles[v.next * lanes + v.lane];
+          if (!ahead.empty() && ahead.back() != lane[k])
+          {
+            leader = &vehicles[ahead.back()];
+            gap = m_edges[v.edge].length - v.pos + leader->pos;
+          }
+        }
+        if (leader != nullptr)
+        {
+          gap -= VEHICLE_LENGTH + VEHICLE_MIN_GAP;
+          vMax = std::min(vMax, SafeSpeed(v.speed, leader->speed, std::max(gap, 0.0)));
+        }
+        vMax = std::max(vMax, 0.0);
+        speeds[lane[k]] = std::max(0.0, vMax - VEHICLE_SIGMA * VEHICLE_ACCEL * dt * Uniform(m_rng));
+      }
+    }
+
+    // Move, turn at the junctions, and record the course changes
+    double time = step * dt;
+    for (std::vector<uint32_t>& lane : laneVehicles)
+    {
+      lane.clear();
+    }
+    for (uint32_t i = 0; i < nVehicles; i++)
+    {
+      Vehicle& v = vehicles[i];
+      if (v.edge == NO_EDGE)
+      {
+        continue;
+      }
+      v.speed = speeds[i];
+      v.pos += v.speed * dt;
+      while (v.pos >= m_edges[v.edge].length)
+      {
+        v.pos -= m_edges[v.edge].length;
+        v.edge = v.next;
+        v.next = ChooseNext(v.edge);
+      }
+      laneVehicles[laneOf(v)].push_back(i);
+
+      Run& run = runs[i];
+      if (v.edge != run.edge)
+      {
+        // Crossed a junction: the new position anchors a run on the new street
+        waypoints[i].push_back(Position(v, time));
+        run = StartRun(v.edge, time, v.pos);
+        continue;
+      }
+      double elapsed = time - run.anchorTime;
+      double speed = (v.pos - run.anchorPos) / elapsed;
+      if (run.extended && speed >= run.minSpeed && speed <= run.maxSpeed)
+      {
+        waypoints[i].back() = Position(v, time);
+      }
+      else
+      {
+        if (run.extended)
+        {
+          // The last waypoint anchors a new run
+          run = StartRun(v.edge, run.endTime, run.endPos);
+          elapsed = time - run.anchorTime;
+        }
+        waypoints[i].push_back(Position(v, time));
+        run.extended = true;
+      }
+      // This position must stay within the tolerance when the run is extended
+      run.minSpeed = std::max(run.minSpeed, (v.pos - tolerance - run.anchorPos) / elapsed);
+      run.maxSpeed = std::min(run.maxSpeed, (v.pos + tolerance - run.anchorPos) / elapsed);
+      run.endTime = time;
+      run.endPos = v.pos;
+    }
+  }
+
+  uint64_t total = 0;
+  for (const auto& w : waypoints)
+  {
+    total += w.size();
+  }
+  NS_LOG_INFO("Generated " << nVehicles << " vehicles over " << m_params.duration << " s: "
+              << total << " waypoints");
+  return Create<WaypointTrace>(waypoints);
+}
+
+} // namespace ns3
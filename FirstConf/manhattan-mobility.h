@@ -0,0 +1,143 @@
+/**
+ * ManhattanMobility - Built-in generator of the Manhattan grid scenarios
+ *
+ * Replaces the netgenerate / randomTrips.py / sumo / traceExporter.py chain of
+ * SUMO_Mobility/scripts/manhattan_*.sh: the grid of
+ * "netgenerate --grid" (gridNumber x gridNumber junctions, two-way streets of
+ * the given lane count and speed limit) is rebuilt in memory, vehicles depart
+ * at random positions at the speed limit, follow their leader with the Krauss
+ * model of SUMO (default parameters, 0.1 s steps) and pick their next street
+ * at random at every junction, like the jtrrouter routes with continuous
+ * rerouters. The result is a WaypointTrace, installed directly on the nodes
+ * or written as a .wpt file.
+ *
+ * Simplifications with respect to SUMO: no lane changes (vehicles keep their
+ * departure lane), no right-of-way at the junctions, and the turns do not
+ * slow vehicles down.
+ */
+
+#ifndef NS3_MANHATTAN_MOBILITY_H
+#define NS3_MANHATTAN_MOBILITY_H
+
+#include "waypoint-trace.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Grid and traffic parameters, named after the netgenerate options
+ */
+struct ManhattanGridParameters
+{
+  uint32_t gridNumber = 2;          ///< Junctions per side (--grid.number)
+  double xLength = 600;             ///< Street length along x, m (--grid.x-length)
+  double yLength = 50;              ///< Street length along y, m (--grid.y-length)
+  uint32_t lanes = 1;               ///< Lanes per direction (--default.lanenumber)
+  double speedLimit = 13.88889;     ///< m/s (--default.speed)
+  double duration = 120;            ///< Generated time, s
+  double step = 0.1;                ///< Car-following step, s (--step-length)
+  double tolerance = 0.1;           ///< Position error of the merged waypoints, m (fcd_to_waypoints.py --tolerance)
+};
+
+/**
+ * \brief Generates vehicle waypoints on a Manhattan grid
+ *
+ * The generator has its own random engine, seeded independently of the ns-3
+ * run number, so that replications of the offloading scenario can share the
+ * same mobility as the SUMO traces indexed by run did.
+ */
+class ManhattanMobilityGenerator
+{
+public:
+  /**
+   * \param params Grid and traffic parameters
+   * \param seed Seed of the departures, the car-following noise and the turns
+   */
+  ManhattanMobilityGenerator(const ManhattanGridParameters& params, uint64_t seed);
+
+  /**
+   * \brief Simulate the traffic
+   * \param nVehicles Number of vehicles, all on the grid from the start
+   * \return One waypoint list per vehicle, a waypoint at each course change beyond the
+   *         tolerance; empty for the vehicles that could not be placed without overlap
+   */
+  Ptr<WaypointTrace> Generate(uint32_t nVehicles);
+
+private:
+  /// One direction of a street between two adjacent junctions
+  struct Edge
+  {
+    uint32_t from;                  ///< Junction index
+    uint32_t to;                    ///< Junction index
+    double length;                  ///< m
+    double dx;                      ///< Unit direction
+    double dy;                      ///< Unit direction
+  };
+
+  /// State of a vehicle during the generation
+  struct Vehicle
+  {
+    uint32_t edge;                  ///< Current edge
+    uint32_t next;                  ///< Edge after the next junction
+    uint32_t lane;                  ///< Lane, kept for the whole trip
+    double pos;                     ///< Distance from the start of the edge, m
+    double speed;                   ///< m/s
+  };
+
+  /// Steps of a vehicle on one street, merged into a single waypoint segment
+  struct Run
+  {
+    uint32_t edge;                  ///< Street of the run
+    double anchorTime;              ///< Time of the waypoint starting the run, s
+    double anchorPos;               ///< Its distance from the start of the street, m
+    double endTime;                 ///< Time of the last waypoint of the run, s
+    double endPos;                  ///< Its distance from the start of the street, m
+    bool extended;                  ///< The last waypoint ends the run (it is not the anchor)
+    double minSpeed;                ///< Lowest anchor-to-end speed keeping the steps within the tolerance, m/s
+    double maxSpeed;                ///< Highest one, m/s
+  };
+
+  /**
+   * \brief Start a run at a waypoint
+   * \param edge Street of the waypoint
+   * \param time Time of the waypoint, s
+   * \param pos Distance from the start of the street, m
+   * \return A run without steps
+   */
+  static Run StartRun(uint32_t edge, double time, double pos);
+
+  /**
+   * \brief Pick the edge taken at the end of an edge, with the jtrrouter turn ratios
+   * \param edge The edge being driven
+   * \return The next edge
+   */
+  uint32_t ChooseNext(uint32_t edge);
+
+  /**
+   * \brief Krauss safe speed behind a leader
+   * \param speed Speed of the follower, m/s
+   * \param leaderSpeed Speed of the leader, m/s
+   * \param gap Net distance to the leader, m
+   * \return The highest speed that still allows stopping behind the leader
+   */
+  double SafeSpeed(double speed, double leaderSpeed, double gap) const;
+
+  /**
+   * \param v A vehicle
+   * \param time Current time, s
+   * \return Its position, on the center of its lane
+   */
+  WaypointTraceSample Position(const Vehicle& v, double time) const;
+
+  ManhattanGridParameters m_params;             ///< Grid and traffic parameters
+  std::mt19937_64 m_rng;                        ///< Generator random engine
+  std::vector<Edge> m_edges;                    ///< Streets, both directions
+  std::vector<std::vector<uint32_t>> m_out;     ///< Edges leaving each junction
+};
+
+} // namespace ns3
+
+#endif // NS3_MANHATTAN_MOBILITY_H
@@ -0,0 +1,138 @@
+/**
+ * Implementation of the edge neighbor table
+ */
+
+#include "ns3/abort.h"
+
+#include "neighbor-table.h"
+
+namespace ns3 {
+
+NeighborTable::NeighborTable(Time timeout)
+  : m_timeout(timeout)
+{
+  // Entries are added by Update()
+}
+
+bool
+NeighborTable::Update(Ipv4Address addr, uint32_t nodeId, uint32_t queueState, Time now)
+{
+  // Every beacon pushes a deadline; stale ones are skipped in PopExpired()
+  m_deadlines.push_back({now + m_timeout, addr});
+
+  auto it = m_index.find(addr);
+  if (it != m_index.end())
+  {
+    m_entries[it->second].last_beacon = now;
+    m_entries[it->second].queue_state = queueState;
+    return false;
+  }
+
+  NeighborInformation entry;
+  entry.node_ID = nodeId;
+  entry.neighbor_ip = addr;
+  entry.last_beacon = now;
+  entry.queue_state = queueState;
+  m_index.emplace(addr, static_cast<uint32_t>(m_entries.size()));
+  m_entries.push_back(entry);
+  return true;
+}
+
+bool
+NeighborTable::Remove(Ipv4Address addr, NeighborInformation* removed)
+{
+  auto it = m_index.find(addr);
+  if (it == m_index.end())
+  {
+    return false;
+  }
+
+  uint32_t position = it->second;
+  if (removed)
+  {
+    *removed = m_entries[position];
+  }
+
+  // Move the last entry into the hole to keep the storage dense
+  uint32_t last = static_cast<uint32_t>(m_entries.size() - 1);
+  if (position != last)
+  {
+    m_entries[position] = m_entries[last];
+    m_index[m_entries[position].neighbor_ip] = position;
+  }
+  m_entries.pop_back();
+  m_index.erase(it);
+  return true;
+}
+
+const NeighborInformation*
+NeighborTable::Find(Ipv4Address addr) const
+{
+  auto it = m_index.find(addr);
+  return it == m_index.end() ? nullptr : &m_entries[it->second];
+}
+
+void
+NeighborTable::PopExpired(Time now, std::vector<NeighborInformation>& expired)
+{
+  while (!m_deadlines.empty() && m_deadlines.front().when <= now)
+  {
+    Deadline deadline = m_deadlines.front();
+    m_deadlines.pop_front();
+
+    // Skip neighbors already removed or refreshed by a later beacon
+    const NeighborInformation* entry = Find(deadline.addr);
+    if (entry && entry->last_beacon + m_timeout <= now)
+    {
+      expired.push_back(*entry);
+      Remove(deadline.addr);
+    }
+  }
+}
+
+bool
+NeighborTable::GetNextExpiry(Time& deadline)
+{
+  // Only the deadline of the last beacon of a neighbor can expire it
+  while (!m_deadlines.empty())
+  {
+    const Deadline& front = m_deadlines.front();
+    const NeighborInformation* entry = Find(front.addr);
+    if (entry && entry->last_beacon + m_timeout == front.when)
+    {
+      deadline = front.when;
+      return true;
+    }
+    m_deadlines.pop_front();
+  }
+  return false;
+}
+
+uint32_t
+NeighborTable::GetN() const
+{
+  return static_cast<uint32_t>(m_entries.size());
+}
+
+const NeighborInformation&
+NeighborTable::Get(uint32_t index) const
+{
+  NS_ASSERT_MSG(index < m_entries.size(), "Neighbor index out of range");
+  return m_entries[index];
+}
+
+Time
+NeighborTable::GetTimeout() const
+{
+  return m_timeout;
+}
+
+void
+NeighborTable::Clear()
+{
+  m_entries.clear();
+  m_index.clear();
+  m_deadlines.clear();
+}
+
+} // namespace ns3
@@ -0,0 +1,134 @@
+/**
+ * NeighborTable - Hash-indexed table of the vehicles available for VCC
+ *
+ * The edge keeps one entry per vehicle that recently sent a beacon with free
+ * queue capacity. Entries are stored densely (O(1) uniform random selection),
+ * indexed by IPv4 address (O(1) update and removal) and expire exactly
+ * Timeout after their last beacon through a FIFO of deadlines: since every
+ * deadline is "now + timeout", deadlines are pushed in non-decreasing order
+ * and the FIFO front is always the earliest one. Deadlines made stale by a
+ * newer beacon or a removal are dropped before the next one is reported, so
+ * the expiry check runs about once per timeout rather than once per beacon.
+ */
+
+#ifndef NS3_NEIGHBOR_TABLE_H
+#define NS3_NEIGHBOR_TABLE_H
+
+#include "ns3/nstime.h"
+#include "ns3/ipv4-address.h"
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Structure to store information about neighbor vehicles
+ */
+typedef struct {
+  uint32_t node_ID;       ///< Node identifier
+  Ipv4Address neighbor_ip; ///< IP address of neighbor
+  Time last_beacon;       ///< Time of last received beacon
+  uint32_t queue_state;   ///< Tasks queued in the vehicle at the last beacon
+} NeighborInformation;
+
+/**
+ * \brief Neighbor table with O(1) update, removal, random selection and expiry
+ */
+class NeighborTable
+{
+public:
+  /**
+   * \brief Create an empty table
+   * \param timeout Time after the last beacon at which a neighbor expires
+   */
+  explicit NeighborTable(Time timeout);
+
+  /**
+   * \brief Refresh a neighbor, or add it if unknown
+   *
+   * \param addr IPv4 address of the neighbor
+   * \param nodeId Node ID of the neighbor
+   * \param queueState Tasks queued in the vehicle, as advertised in the beacon
+   * \param now Time of the beacon
+   * \return true if the neighbor was added
+   */
+  bool Update(Ipv4Address addr, uint32_t nodeId, uint32_t queueState, Time now);
+
+  /**
+   * \brief Remove a neighbor
+   *
+   * \param addr IPv4 address of the neighbor
+   * \param removed If not null, receives the removed entry
+   * \return true if the neighbor was in the table
+   */
+  bool Remove(Ipv4Address addr, NeighborInformation* removed = nullptr);
+
+  /**
+   * \brief Look up a neighbor
+   * \param addr IPv4 address of the neighbor
+   * \return The entry, or null if unknown
+   */
+  const NeighborInformation* Find(Ipv4Address addr) const;
+
+  /**
+   * \brief Remove the neighbors whose deadline has passed
+   *
+   * \param now Current time
+   * \param expired Receives the removed entries
+   */
+  void PopExpired(Time now, std::vector<NeighborInformation>& expired);
+
+  /**
+   * \brief Get the earliest deadline of a neighbor in the table
+   *
+   * Drops the stale deadlines ahead of it, superseded by a later beacon or
+   * left by a removed neighbor.
+   *
+   * \param deadline Receives the deadline
+   * \return false if no neighbor can expire
+   */
+  bool GetNextExpiry(Time& deadline);
+
+  /**
+   * \return The number of neighbors
+   */
+  uint32_t GetN() const;
+
+  /**
+   * \brief Get a neighbor by position, e.g. for uniform random selection
+   * \param index Position in [0, GetN())
+   * \return The entry
+   */
+  const NeighborInformation& Get(uint32_t index) const;
+
+  /**
+   * \return The neighbor timeout
+   */
+  Time GetTimeout() const;
+
+  /**
+   * \brief Remove every neighbor and pending deadline
+   */
+  void Clear();
+
+private:
+  /**
+   * \brief A pending expiry check
+   */
+  struct Deadline
+  {
+    Time when;              ///< Expiry time if no newer beacon arrives
+    Ipv4Address addr;       ///< Neighbor to check
+  };
+
+  Time m_timeout;                                   ///< Expiry after last beacon
+  std::vector<NeighborInformation> m_entries;       ///< Dense neighbor storage
+  std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash> m_index; ///< Address -> position
+  std::deque<Deadline> m_deadlines;                 ///< Pending checks, non-decreasing
+};
+
+} // namespace ns3
+
+#endif // NS3_NEIGHBOR_TABLE_H
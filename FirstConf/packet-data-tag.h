@@ -1,9 +1,11 @@
 /**
- * PacketDataTag - A tag for carrying offloading metadata in packets
+ * PacketDataTag - A tag for carrying the task ID in offloading packets
  *
- * This tag carries important metadata including timestamps, workload information,
- * and addressing data for task offloading between pedestrians, edge servers,
- * vehicles, and cloud servers.
+ * Requests and responses only carry the 32-bit ID of their task; the task
+ * metadata (timestamps, workload, tier, addressing) lives in the
+ * TaskRegistry, where every component records its part of the lifecycle.
+ * Tags are copied with every packet copy in the NR stack, so this keeps
+ * the per-hop cost at 4 bytes.
  */
 
 #ifndef PACKET_DATA_TAG_H
@@ -25,8 +27,7 @@ namespace ns3 {
 /**
  * \brief A custom tag for offloading simulation
  *
- * This class provides functionality to carry metadata for task offloading
- * simulation between pedestrians, edge servers, vehicles, and cloud.
+ * Identifies the task of a request or response packet in the TaskRegistry.
  * A tag can be added to any packet, but you cannot add a tag of the same type twice.
  */
 class PacketDataTag : public Tag 
@@ -38,11 +39,11 @@ public:
   PacketDataTag();
   
   /**
-   * \brief Constructor with node ID
+   * \brief Constructor with task ID
    * 
-   * \param nodeId The node identifier
+   * \param taskId The task identifier in the TaskRegistry
    */
-  PacketDataTag(uint32_t nodeId);
+  PacketDataTag(uint32_t taskId);
   
   /**
    * \brief Destructor
@@ -87,154 +88,20 @@ public:
    */
   virtual void Print(std::ostream &os) const;
   
-  // Accessor functions
-  
-  /**
-   * \brief Get the source pedestrian's IPv4 address
-   * \return IPv4 address of the pedestrian
-   */
-  Ipv4Address GetSourcePedestrianIPv4Address();
-  
-  /**
-   * \brief Get the node ID
-   * \return Node ID that generated this packet
-   */
-  uint32_t GetNodeId();
-  
-  /**
-   * \brief Get the initial timestamp
-   * \return Time when packet was created
-   */
-  Time GetInitialTime();
-  
-  /**
-   * \brief Get the final timestamp
-   * \return Time when packet processing was completed
-   */
-  Time GetFinalTime();
-  
-  /**
-   * \brief Get the offloading destination
-   * \return Location code (0=Edge, 1=Cloud, 2=VCC)
-   */
-  uint32_t GetWhere();
-  
-  /**
-   * \brief Get uplink transmission time
-   * \return Time when packet arrived at processing node
-   */
-  Time GetUplinkTime();
-  
-  /**
-   * \brief Get elaboration (processing) time
-   * \return Time taken for processing the task
-   */
-  Time GetElaborationTime();
-  
-  /**
-   * \brief Get time spent in queue
-   * \return Time packet waited in queue
-   */
-  Time GetQueueingTime();
-  
-  /**
-   * \brief Get task workload
-   * \return Workload in millions of instructions
-   */
-  double GetWorkload();
-  
-  /**
-   * \brief Get number of cars in VCC
-   * \return Count of vehicles in vehicular cloud
-   */
-  uint32_t GetCarsInVCC();
-  
-  /**
-   * \brief Check if packet is from VCC to pedestrian
-   * \return 1 if from VCC to pedestrian, 0 otherwise
-   */
-  uint32_t GetIsFromVCCToPed();
-  
-  // Mutator functions
-  
-  /**
-   * \brief Set the source pedestrian's IPv4 address
-   * \param pedestrianIp IPv4 address of the pedestrian
-   */
-  void SetSourcePedestrianIPv4Address(Ipv4Address pedestrianIp);
-  
-  /**
-   * \brief Set the node ID
-   * \param nodeId Node identifier
-   */
-  void SetNodeId(uint32_t nodeId);
-  
-  /**
-   * \brief Set the initial timestamp
-   * \param initialTime Time when packet was created
-   */
-  void SetInitialTime(Time initialTime);
-  
-  /**
-   * \brief Set the final timestamp
-   * \param finalTime Time when packet processing was completed
-   */
-  void SetFinalTime(Time finalTime);
-  
-  /**
-   * \brief Set the offloading destination
-   * \param where Location code (0=Edge, 1=Cloud, 2=VCC)
-   */
-  void SetWhere(uint32_t where);
-  
-  /**
-   * \brief Set uplink transmission time
-   * \param uplinkTime Time when packet arrived at processing node
-   */
-  void SetUplinkTime(Time uplinkTime);
-  
-  /**
-   * \brief Set elaboration (processing) time
-   * \param elaborationTime Time taken for processing the task
-   */
-  void SetElaborationTime(Time elaborationTime);
-  
-  /**
-   * \brief Set time spent in queue
-   * \param queueingTime Time packet waited in queue
-   */
-  void SetQueueingTime(Time queueingTime);
-  
-  /**
-   * \brief Set task workload
-   * \param workload Workload in millions of instructions
-   */
-  void SetWorkload(double workload);
-  
   /**
-   * \brief Set number of cars in VCC
-   * \param carsInVCC Count of vehicles in vehicular cloud
+   * \brief Get the task ID
+   * \return Task identifier in the TaskRegistry
    */
-  void SetCarsInVCC(uint32_t carsInVCC);
+  uint32_t GetTaskId() const;
   
   /**
-   * \brief Set if packet is from VCC to pedestrian
-   * \param isFromVCCToPed 1 if from VCC to pedestrian, 0 otherwise
+   * \brief Set the task ID
+   * \param taskId Task identifier in the TaskRegistry
    */
-  void SetIsFromVCCToPed(uint32_t isFromVCCToPed);
+  void SetTaskId(uint32_t taskId);
   
 private:
-  Ipv4Address m_pedestrian_ip;     ///< IP address of the pedestrian who sent the packet
-  uint32_t m_userNodeId;           ///< User who generated the packet
-  Time m_timestamp_initial;        ///< Time of packet generation
-  Time m_timestamp_final;          ///< Time of completion
-  uint32_t m_where;                ///< Where the packet is offloaded (0=Edge, 1=Cloud, 2=VCC)
-  Time m_uplink_time;              ///< Arrival time to the processing node
-  Time m_elaboration_time;         ///< Time needed for task processing
-  Time m_queueing_time;            ///< Time spent in queue
-  double m_workload;               ///< Task workload in millions of instructions
-  uint32_t m_cars_in_VCC;          ///< Number of cars in VCC at this moment
-  uint32_t m_is_from_VCC_to_ped;   ///< Flag indicating if packet is from VCC to pedestrian
+  uint32_t m_taskId;               ///< Task of the packet
 };
 
 } // namespace ns3
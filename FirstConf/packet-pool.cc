@@ -0,0 +1,52 @@
+/**
+ * Implementation of the packet pool
+ */
+
+#include "packet-pool.h"
+
+namespace ns3 {
+
+PacketPool::PacketPool(uint32_t size)
+  : m_size(size),
+    m_next(0),
+    m_reused(0)
+{
+}
+
+Ptr<Packet>
+PacketPool::Acquire()
+{
+  // Round-robin from the last packet handed out: the oldest ones are the most
+  // likely to have been released
+  uint32_t n = m_packets.size();
+  for (uint32_t k = 0; k < n; k++)
+  {
+    uint32_t i = (m_next + k) % n;
+    Ptr<Packet>& packet = m_packets[i];
+    if (packet->GetReferenceCount() == 1)
+    {
+      *packet = Packet(m_size);
+      m_next = (i + 1) % n;
+      m_reused++;
+      return packet;
+    }
+  }
+
+  m_packets.push_back(Create<Packet>(m_size));
+  m_next = 0;
+  return m_packets.back();
+}
+
+uint32_t
+PacketPool::GetN() const
+{
+  return m_packets.size();
+}
+
+uint64_t
+PacketPool::GetNReused() const
+{
+  return m_reused;
+}
+
+} // namespace ns3
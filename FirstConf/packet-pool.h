@@ -0,0 +1,60 @@
+/**
+ * PacketPool - Recycled packets of a fixed size
+ *
+ * The applications create a packet for every response and every beacon. A
+ * packet handed to a socket is owned by the stack until it is delivered or
+ * dropped; afterwards the pool holds the only reference to it and can reset
+ * it to a fresh packet of the same size (new UID, no tags or headers) instead
+ * of allocating a new one. In steady state a pool holds as many packets as
+ * are in flight at once.
+ */
+
+#ifndef NS3_PACKET_POOL_H
+#define NS3_PACKET_POOL_H
+
+#include "ns3/packet.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Pool of packets of one size, recycled once the stack released them
+ */
+class PacketPool
+{
+public:
+  /**
+   * \param size Payload size of the packets, in bytes
+   */
+  explicit PacketPool(uint32_t size);
+
+  /**
+   * \brief Get an empty packet of the pool size
+   *
+   * \return A recycled packet no one else references, or a new one if all
+   *         the packets of the pool are still in use
+   */
+  Ptr<Packet> Acquire();
+
+  /**
+   * \return Number of packets owned by the pool
+   */
+  uint32_t GetN() const;
+
+  /**
+   * \return Number of Acquire() calls served by a recycled packet
+   */
+  uint64_t GetNReused() const;
+
+private:
+  uint32_t m_size;                      ///< Payload size, bytes
+  std::vector<Ptr<Packet>> m_packets;   ///< Packets owned by the pool
+  uint32_t m_next;                      ///< Where the search for a free packet starts
+  uint64_t m_reused;                    ///< Acquisitions served by a recycled packet
+};
+
+} // namespace ns3
+
+#endif // NS3_PACKET_POOL_H
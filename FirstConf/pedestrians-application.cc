@@ -18,7 +18,12 @@
 
 #include "pedestrians-application.h"
 #include "packet-data-tag.h"
+#include "task-registry.h"
 #include "globals.h"
+#include "trace-sink.h"
+#include "latency-histogram.h"
+#include "convergence-controller.h"
+#include "event-profiler.h"
 
 // Terminal color codes for logging
 #define PURPLE_CODE "\033[95m"
@@ -54,7 +59,11 @@ PedApplication::GetInstanceTypeId() const
 
 PedApplication::PedApplication()
   : m_port0(9999),
-    m_port1(7777)
+    m_port1(7777),
+    m_start_offset(CreateObject<UniformRandomVariable>()),
+    m_inter_arrival(CreateObject<ExponentialRandomVariable>()),
+    m_request_draws(CreateObject<UniformRandomVariable>()),
+    m_request_pool(packet_size)
 {
   // Nothing else to initialize
 }
@@ -64,6 +73,15 @@ PedApplication::~PedApplication()
   // Nothing to clean up
 }
 
+int64_t
+PedApplication::AssignStreams(int64_t stream)
+{
+  m_start_offset->SetStream(stream);
+  m_inter_arrival->SetStream(stream + 1);
+  m_request_draws->SetStream(stream + 2);
+  return 3;
+}
+
 void 
 PedApplication::SetupReceiveSocket(Ptr<Socket> socket, uint16_t port)
 {
@@ -87,18 +105,10 @@ PedApplication::StartApplication()
   m_send_socket = Socket::CreateSocket(GetNode(), tid);
 
   // Add randomness to the first packet time to avoid collision
-  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable>();
-  Time randomOffset = MicroSeconds(rand->GetValue(50, 200));
+  Time randomOffset = MicroSeconds(m_start_offset->GetValue(50, 200));
 
-  // Create the first offloading request packet
-  Ptr<Packet> initialPacket = Create<Packet>(packet_size);
-  
-  // Add metadata tag to the packet
-  PacketDataTag tag;
-  tag.SetWorkload(task_workload);
-  tag.SetNodeId(GetNode()->GetId());
-  tag.SetInitialTime(randomOffset);
-  initialPacket->AddPacketTag(tag);
+  // Create the first offloading request packet (registered when it is sent)
+  Ptr<Packet> initialPacket = m_request_pool.Acquire();
 
   // Schedule sending the first packet after random offset
   Simulator::Schedule(randomOffset, &PedApplication::SendPacket, 
@@ -108,6 +118,7 @@ PedApplication::StartApplication()
 void 
 PedApplication::HandleReadOne(Ptr<Socket> socket)
 {
+  EventProfiler::Scope profile("PedApplication::HandleReadOne");
   NS_LOG_FUNCTION(this << socket);
   Ptr<Packet> packet;
   Address from;
@@ -121,34 +132,52 @@ PedApplication::HandleReadOne(Ptr<Socket> socket)
                 << packetSize << " at time " << Now().GetSeconds() << END_CODE);
     NS_LOG_INFO(packet->ToString());
     
-    // Log response data to CSV file
-    std::ofstream logFile;
-    std::string filename = output_data_csv + "/offloading_time_" + sim_type + ".csv";
-    logFile.open(filename, std::ofstream::app);
-    
-    // Extract metadata from packet tag
+    // Look up the task of the response
     PacketDataTag tag;
     if (packet->PeekPacketTag(tag))
     {
-      if (logFile.is_open()) {
-        logFile << tag.GetNodeId() << ","
-               << packetSize << ","
-               << tag.GetInitialTime() << ","
-               << Now().GetSeconds() << ","
-               << tag.GetWhere() << ","
-               << request_rate << ","
-               << cars_number << ","
-               << pedestrians_number << ","
-               << tag.GetUplinkTime() << ","
-               << tag.GetElaborationTime() << ","
-               << edge_computation_capacity << ","
-               << car_computation_capacity << ","
-               << tag.GetQueueingTime() << ","
-               << tag.GetWorkload() << ","
-               << tag.GetCarsInVCC() << ","
-               << vehicle_queue_length << "\n";
+      uint32_t task = tag.GetTaskId();
+      TaskRegistry::SetFinalTime(task, Now());
+      TaskRegistry::SetStatus(task, TASK_COMPLETED);
+      
+      // Log response data to CSV file
+      TraceRecord record(TRACE_OFFLOADING_TIME);
+      record.AddUint(TaskRegistry::GetNodeId(task))
+            .AddUint(packetSize)
+            .AddTime(TaskRegistry::GetInitialTime(task))
+            .AddSeconds(Now())
+            .AddUint(TaskRegistry::GetWhere(task))
+            .AddDouble(request_rate)
+            .AddUint(cars_number)
+            .AddUint(pedestrians_number)
+            .AddTime(TaskRegistry::GetUplinkTime(task))
+            .AddTime(TaskRegistry::GetElaborationTime(task))
+            .AddDouble(edge_computation_capacity)
+            .AddDouble(car_computation_capacity)
+            .AddTime(TaskRegistry::GetQueueingTime(task))
+            .AddDouble(TaskRegistry::GetWorkload(task))
+            .AddUint(TaskRegistry::GetCarsInVCC(task))
+            .AddUint(vehicle_queue_length);
+      TraceSinkRegistry::Write(record);
+
+      // Feed the latency histograms of the offloading tier
+      if (LatencyHistograms::IsEnabled()) {
+        uint32_t tier = TaskRegistry::GetWhere(task);
+        Time initialTime = TaskRegistry::GetInitialTime(task);
+        Time uplinkTime = TaskRegistry::GetUplinkTime(task);
+        Time queueingTime = TaskRegistry::GetQueueingTime(task);
+        Time elaborationTime = TaskRegistry::GetElaborationTime(task);
+        LatencyHistograms::Record(tier, LATENCY_TOTAL, Now() - initialTime);
+        LatencyHistograms::Record(tier, LATENCY_UPLINK, uplinkTime - initialTime);
+        LatencyHistograms::Record(tier, LATENCY_QUEUEING, queueingTime - uplinkTime);
+        LatencyHistograms::Record(tier, LATENCY_ELABORATION, elaborationTime);
+        LatencyHistograms::Record(tier, LATENCY_DOWNLINK, Now() - (queueingTime + elaborationTime));
+      }
+      
+      // Running statistics of the sequential stopping rule
+      if (ConvergenceController::IsEnabled()) {
+        ConvergenceController::Record(TaskRegistry::GetWhere(task), Now() - TaskRegistry::GetInitialTime(task));
       }
-      logFile.close();
     }
     else {
       NS_LOG_INFO("Pedestrian Received a Packet BUT WITHOUT TAG!!!!");
@@ -159,38 +188,41 @@ PedApplication::HandleReadOne(Ptr<Socket> socket)
 void 
 PedApplication::SendPacket(Ptr<Packet> packet, Ipv4Address destination, uint16_t port)
 { 
+  EventProfiler::Scope profile("PedApplication::SendPacket");
   NS_LOG_FUNCTION(this);
   
+  // The requests already sent drain until the end of the run
+  if (Now() >= Seconds(requests_end_time))
+  {
+    return;
+  }
+  
+  // Register the task; only its ID travels with the packet
+  uint32_t task = TaskRegistry::Create(GetNode()->GetId(), task_workload, Now());
+  
+  // Draws of the random choices of the edge for this request, the same whatever the strategy
+  double tierDraw = m_request_draws->GetValue();
+  TaskRegistry::SetDraws(task, tierDraw, m_request_draws->GetValue());
+  packet->AddPacketTag(PacketDataTag(task));
+  
   // Connect to destination and send packet
   m_send_socket->Connect(InetSocketAddress(Ipv4Address::ConvertFrom(destination), port));
   m_send_socket->Send(packet);
 
   // Log request data to CSV file
-  std::ofstream logFile;
-  std::string filename = output_data_csv + "/total_sent_packets_" + sim_type + ".csv";
-  logFile.open(filename, std::ofstream::app);
-  
-  if (logFile.is_open()) {
-    logFile << GetNode()->GetId() << "," << Now().GetSeconds() << "\n";
-    logFile.close();
-  }
+  TraceRecord record(TRACE_SENT_PACKETS);
+  record.AddUint(GetNode()->GetId())
+        .AddSeconds(Now());
+  TraceSinkRegistry::Write(record);
 
   // Calculate next request time based on exponential distribution
   double reqRateSeconds = request_rate / 1000.0; // Convert milliseconds to seconds
   
   // Generate random offset using exponential distribution
-  Ptr<ExponentialRandomVariable> randExpo = CreateObject<ExponentialRandomVariable>();
-  double nextRequestTime = randExpo->GetValue(reqRateSeconds, 1);
+  double nextRequestTime = m_inter_arrival->GetValue(reqRateSeconds, 1);
   
   // Create next request packet
-  Ptr<Packet> newPacket = Create<Packet>(packet_size);
-  
-  // Add metadata tag to new packet
-  PacketDataTag tag;
-  tag.SetWorkload(task_workload);
-  tag.SetNodeId(GetNode()->GetId());
-  tag.SetInitialTime(Seconds(Now().GetSeconds() + nextRequestTime));
-  newPacket->AddPacketTag(tag);
+  Ptr<Packet> newPacket = m_request_pool.Acquire();
   
   // Schedule sending the next packet
   Simulator::Schedule(Seconds(nextRequestTime), &PedApplication::SendPacket, 
@@ -12,6 +12,9 @@
 #include "ns3/socket.h"
 #include "ns3/application.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/random-variable-stream.h"
+
+#include "packet-pool.h"
 
 namespace ns3 {
 
@@ -48,6 +51,14 @@ public:
    */
   virtual TypeId GetInstanceTypeId() const;
   
+  /**
+   * \brief Assign the streams of the start offset, of the inter-arrival times and of the request draws
+   *
+   * \param stream First stream index to use
+   * \return The number of streams assigned
+   */
+  int64_t AssignStreams(int64_t stream);
+  
   /**
    * \brief Handle incoming response packets
    *
@@ -92,6 +103,10 @@ private:
   Ptr<Socket> m_send_socket;   ///< Socket for sending task requests
   uint16_t m_port0;            ///< Port for receiving responses (9999)
   uint16_t m_port1;            ///< Port for sending requests (7777)
+  Ptr<UniformRandomVariable> m_start_offset;      ///< Offset of the first request
+  Ptr<ExponentialRandomVariable> m_inter_arrival; ///< Time between two requests
+  Ptr<UniformRandomVariable> m_request_draws;     ///< Draws of the random choices made for each request
+  PacketPool m_request_pool;   ///< Request packets, of packet_size bytes
 };
 
 } // namespace ns3
@@ -0,0 +1,343 @@
+/**
+ * Implementation of the calibrated abstract radio links
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-static-routing-helper.h"
+
+#include "radio-abstraction.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("AbstractRadio");
+NS_OBJECT_ENSURE_REGISTERED(AbstractRadioChannel);
+
+namespace {
+
+std::vector<std::string>
+SplitCsvLine(const std::string& line)
+{
+  std::vector<std::string> values;
+  std::stringstream ss(line);
+  std::string value;
+  while (std::getline(ss, value, ','))
+  {
+    values.push_back(value);
+  }
+  return values;
+}
+
+double
+ParseDouble(const std::string& text, const std::string& filename, uint32_t lineNumber)
+{
+  char* end = nullptr;
+  double value = std::strtod(text.c_str(), &end);
+  NS_ABORT_MSG_IF(text.empty() || *end != '\0',
+                  "Invalid value '" << text << "' at " << filename << ":" << lineNumber);
+  return value;
+}
+
+/**
+ * \brief Index of the grid interval containing a value, and the position in it
+ *
+ * \param axis Sorted grid coordinates
+ * \param value Value to locate, clamped to the axis
+ * \param fraction Receives the position between axis[index] and axis[index + 1]
+ * \return The index of the lower coordinate
+ */
+size_t
+Locate(const std::vector<double>& axis, double value, double& fraction)
+{
+  fraction = 0;
+  if (axis.size() == 1 || value <= axis.front())
+  {
+    return 0;
+  }
+  if (value >= axis.back())
+  {
+    return axis.size() - 1;
+  }
+  size_t upper = std::upper_bound(axis.begin(), axis.end(), value) - axis.begin();
+  fraction = (value - axis[upper - 1]) / (axis[upper] - axis[upper - 1]);
+  return upper - 1;
+}
+
+RadioLinkSample
+Blend(const RadioLinkSample& a, const RadioLinkSample& b, double fraction)
+{
+  RadioLinkSample sample;
+  sample.latency = Seconds(a.latency.GetSeconds() +
+                           (b.latency.GetSeconds() - a.latency.GetSeconds()) * fraction);
+  sample.throughput = a.throughput + (b.throughput - a.throughput) * fraction;
+  sample.loss = a.loss + (b.loss - a.loss) * fraction;
+  return sample;
+}
+
+} // namespace
+
+RadioLookupTable::RadioLookupTable(const std::string& filename)
+{
+  std::ifstream file(filename);
+  NS_ABORT_MSG_IF(!file.is_open(), "Cannot open radio table " << filename);
+
+  // Columns are located by name, so that the calibration tool can add more
+  const char* names[] = {"direction", "mcs", "distance_m", "load_pps",
+                         "latency_ms", "throughput_mbps", "loss"};
+  const size_t nNames = sizeof(names) / sizeof(names[0]);
+  size_t columns[nNames];
+
+  std::string line;
+  uint32_t lineNumber = 0;
+  bool header = true;
+  std::map<std::pair<uint8_t, uint8_t>, std::map<std::pair<double, double>, RadioLinkSample>> entries;
+  while (std::getline(file, line))
+  {
+    lineNumber++;
+    if (line.empty() || line[0] == '#')
+    {
+      continue;
+    }
+    std::vector<std::string> values = SplitCsvLine(line);
+    if (header)
+    {
+      for (size_t n = 0; n < nNames; n++)
+      {
+        auto it = std::find(values.begin(), values.end(), names[n]);
+        NS_ABORT_MSG_IF(it == values.end(),
+                        "Radio table " << filename << " has no column " << names[n]);
+        columns[n] = it - values.begin();
+      }
+      header = false;
+      continue;
+    }
+
+    NS_ABORT_MSG_IF(values.size() < nNames,
+                    "Missing values at " << filename << ":" << lineNumber);
+    const std::string& direction = values[columns[0]];
+    NS_ABORT_MSG_IF(direction != "UL" && direction != "DL",
+                    "Unknown direction '" << direction << "' at " << filename << ":" << lineNumber);
+    uint8_t dir = direction == "UL" ? RADIO_UPLINK : RADIO_DOWNLINK;
+    uint8_t mcs = static_cast<uint8_t>(ParseDouble(values[columns[1]], filename, lineNumber));
+    double distance = ParseDouble(values[columns[2]], filename, lineNumber);
+    double load = ParseDouble(values[columns[3]], filename, lineNumber);
+
+    RadioLinkSample sample;
+    sample.latency = MicroSeconds(ParseDouble(values[columns[4]], filename, lineNumber) * 1e3);
+    sample.throughput = ParseDouble(values[columns[5]], filename, lineNumber) * 1e6;
+    sample.loss = ParseDouble(values[columns[6]], filename, lineNumber);
+    NS_ABORT_MSG_IF(sample.latency.IsNegative() || sample.throughput < 0 || sample.loss < 0 ||
+                        sample.loss > 1,
+                    "Out of range values at " << filename << ":" << lineNumber);
+    entries[{dir, mcs}][{distance, load}] = sample;
+  }
+  NS_ABORT_MSG_IF(entries.empty(), "Radio table " << filename << " is empty");
+
+  for (const auto& entry : entries)
+  {
+    Grid grid;
+    grid.mcs = entry.first.second;
+    for (const auto& cell : entry.second)
+    {
+      grid.distances.push_back(cell.first.first);
+      grid.loads.push_back(cell.first.second);
+    }
+    for (std::vector<double>* axis : {&grid.distances, &grid.loads})
+    {
+      std::sort(axis->begin(), axis->end());
+      axis->erase(std::unique(axis->begin(), axis->end()), axis->end());
+    }
+    NS_ABORT_MSG_IF(grid.distances.size() * grid.loads.size() != entry.second.size(),
+                    "Radio table " << filename << " is not a full distance x load grid for "
+                                   << (entry.first.first == RADIO_UPLINK ? "UL" : "DL")
+                                   << " MCS " << +grid.mcs);
+    for (double distance : grid.distances)
+    {
+      for (double load : grid.loads)
+      {
+        grid.cells.push_back(entry.second.at({distance, load}));
+      }
+    }
+    m_grids[entry.first.first].push_back(grid);
+  }
+
+  for (uint8_t dir = 0; dir < RADIO_DIRECTION_COUNT; dir++)
+  {
+    NS_ABORT_MSG_IF(m_grids[dir].empty(), "Radio table " << filename << " has no "
+                                          << (dir == RADIO_UPLINK ? "UL" : "DL") << " entries");
+  }
+}
+
+RadioLinkSample
+RadioLookupTable::Lookup(RadioDirection direction, uint8_t mcs, double distance, double load) const
+{
+  const std::vector<Grid>& grids = m_grids[direction];
+  const Grid* grid = &grids.front();
+  for (const Grid& g : grids)
+  {
+    if (std::abs(g.mcs - mcs) < std::abs(grid->mcs - mcs))
+    {
+      grid = &g;
+    }
+  }
+
+  double fd;
+  double fl;
+  size_t d = Locate(grid->distances, distance, fd);
+  size_t l = Locate(grid->loads, load, fl);
+  size_t nLoads = grid->loads.size();
+  size_t d1 = std::min(d + 1, grid->distances.size() - 1);
+  size_t l1 = std::min(l + 1, nLoads - 1);
+
+  RadioLinkSample low = Blend(grid->cells[d * nLoads + l], grid->cells[d * nLoads + l1], fl);
+  RadioLinkSample high = Blend(grid->cells[d1 * nLoads + l], grid->cells[d1 * nLoads + l1], fl);
+  return Blend(low, high, fd);
+}
+
+RadioLoadMeter::RadioLoadMeter(Time window)
+  : m_window(window)
+{
+  NS_ABORT_MSG_IF(!window.IsStrictlyPositive(), "The radio load window must be positive");
+}
+
+double
+RadioLoadMeter::Record(Time now)
+{
+  m_sent.push_back(now);
+  while (m_sent.front() <= now - m_window)
+  {
+    m_sent.pop_front();
+  }
+  return m_sent.size() / m_window.GetSeconds();
+}
+
+TypeId
+AbstractRadioChannel::GetTypeId()
+{
+  static TypeId tid = TypeId("ns3::AbstractRadioChannel")
+                          .SetParent<SimpleChannel>()
+                          .AddConstructor<AbstractRadioChannel>();
+  return tid;
+}
+
+AbstractRadioChannel::AbstractRadioChannel()
+  : m_mcs(0)
+{
+}
+
+void
+AbstractRadioChannel::Setup(Ptr<SimpleNetDevice> ue, Ptr<SimpleNetDevice> gnb,
+                            Ptr<const RadioLookupTable> table, Ptr<RadioLoadMeter> meter,
+                            Ptr<UniformRandomVariable> loss, uint8_t mcs)
+{
+  m_ue = ue;
+  m_gnb = gnb;
+  m_table = table;
+  m_meter = meter;
+  m_loss = loss;
+  m_mcs = mcs;
+}
+
+void
+AbstractRadioChannel::Send(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from,
+                           Ptr<SimpleNetDevice> sender)
+{
+  RadioDirection direction = sender == m_ue ? RADIO_UPLINK : RADIO_DOWNLINK;
+  Ptr<SimpleNetDevice> receiver = direction == RADIO_UPLINK ? m_gnb : m_ue;
+
+  if (!m_ueMobility)
+  {
+    m_ueMobility = m_ue->GetNode()->GetObject<MobilityModel>();
+    m_gnbMobility = m_gnb->GetNode()->GetObject<MobilityModel>();
+    NS_ABORT_MSG_IF(!m_ueMobility || !m_gnbMobility,
+                    "Abstract radio links need a mobility model on both nodes");
+  }
+
+  Time now = Simulator::Now();
+  double load = m_meter->Record(now);
+  RadioLinkSample link = m_table->Lookup(direction, m_mcs,
+                                         m_ueMobility->GetDistanceFrom(m_gnbMobility), load);
+  if (link.loss > 0 && m_loss->GetValue() < link.loss)
+  {
+    NS_LOG_INFO("Abstract radio drop on node " << m_ue->GetNode()->GetId()
+                << (direction == RADIO_UPLINK ? " UL" : " DL"));
+    return;
+  }
+
+  // The link serializes its packets at the table throughput...
+  Time start = Max(now, m_busyUntil[direction]);
+  Time transmission = link.throughput > 0 ? Seconds(p->GetSize() * 8.0 / link.throughput) : Seconds(0);
+  m_busyUntil[direction] = start + transmission;
+
+  // ...and delivers them in order after the table latency
+  Time arrival = Max(m_busyUntil[direction] + link.latency, m_lastArrival[direction]);
+  m_lastArrival[direction] = arrival;
+  Simulator::ScheduleWithContext(receiver->GetNode()->GetId(), arrival - now,
+                                 &SimpleNetDevice::Receive, receiver, p->Copy(), protocol, to, from);
+}
+
+AbstractRadioHelper::AbstractRadioHelper(const std::string& tableFile, uint8_t mcs, Time loadWindow)
+  : m_table(Create<RadioLookupTable>(tableFile)),
+    m_meter(Create<RadioLoadMeter>(loadWindow)),
+    m_loss(CreateObject<UniformRandomVariable>()),
+    m_mcs(mcs)
+{
+  // Same UE address space as the NR EPC
+  m_addresses.SetBase("7.0.0.0", "255.255.255.252");
+}
+
+Ipv4InterfaceContainer
+AbstractRadioHelper::Install(Ptr<Node> gnb, NodeContainer ues)
+{
+  Ipv4StaticRoutingHelper routingHelper;
+  Ipv4InterfaceContainer ueInterfaces;
+  for (uint32_t i = 0; i < ues.GetN(); i++)
+  {
+    Ptr<Node> ue = ues.Get(i);
+    Ptr<AbstractRadioChannel> channel = CreateObject<AbstractRadioChannel>();
+
+    // Point-to-point mode: no ARP, every frame goes to the other end
+    Ptr<SimpleNetDevice> ueDevice = CreateObject<SimpleNetDevice>();
+    Ptr<SimpleNetDevice> gnbDevice = CreateObject<SimpleNetDevice>();
+    NetDeviceContainer devices;
+    for (Ptr<SimpleNetDevice> device : {ueDevice, gnbDevice})
+    {
+      device->SetAttribute("PointToPointMode", BooleanValue(true));
+      device->SetAddress(Mac48Address::Allocate());
+      device->SetChannel(channel);
+    }
+    gnb->AddDevice(gnbDevice);
+    ue->AddDevice(ueDevice);
+    channel->Setup(ueDevice, gnbDevice, m_table, m_meter, m_loss, m_mcs);
+
+    // gNB end first, so that it gets the .1 address of the /30
+    devices.Add(gnbDevice);
+    devices.Add(ueDevice);
+    Ipv4InterfaceContainer interfaces = m_addresses.Assign(devices);
+    m_addresses.NewNetwork();
+    ueInterfaces.Add(interfaces.Get(1));
+
+    Ptr<Ipv4> ueIpv4 = ue->GetObject<Ipv4>();
+    routingHelper.GetStaticRouting(ueIpv4)->SetDefaultRoute(
+        interfaces.GetAddress(0), ueIpv4->GetInterfaceForDevice(ueDevice));
+  }
+  return ueInterfaces;
+}
+
+int64_t
+AbstractRadioHelper::AssignStreams(int64_t stream)
+{
+  m_loss->SetStream(stream);
+  return 1;
+}
+
+} // namespace ns3
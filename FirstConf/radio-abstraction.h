@@ -0,0 +1,208 @@
+/**
+ * AbstractRadio - Calibrated link abstraction replacing the NR stack
+ *
+ * In abstract radio mode (CoE --radioModel=abstract) every UE is connected to
+ * the gNB node by its own point-to-point link instead of an NR device, and the
+ * gNB node also hosts the edge application and the link to the cloud. Each
+ * packet crossing a link is delayed and dropped according to a lookup table
+ * calibrated from full NR runs (see RadioProbe and
+ * scripts/calibrate_radio.py), indexed by direction, MCS, UE-gNB distance and
+ * offered radio load:
+ *
+ *   arrival = max(now, link busy until) + size / throughput + latency
+ *
+ * with per-link FIFO order. The applications only see IPv4/UDP, so their
+ * logic is the same in both modes.
+ */
+
+#ifndef NS3_RADIO_ABSTRACTION_H
+#define NS3_RADIO_ABSTRACTION_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/mobility-model.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/node-container.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/nstime.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Direction of a radio transmission
+ */
+enum RadioDirection
+{
+  RADIO_UPLINK = 0,     ///< UE to gNB
+  RADIO_DOWNLINK,       ///< gNB to UE
+  RADIO_DIRECTION_COUNT
+};
+
+/**
+ * \brief Link performance of one table entry
+ */
+struct RadioLinkSample
+{
+  Time latency;         ///< Delay not depending on the packet size
+  double throughput;    ///< Bits per second, 0 when the size does not matter
+  double loss;          ///< Packet loss probability
+};
+
+/**
+ * \brief Latency/throughput/loss lookup table calibrated from full NR runs
+ *
+ * CSV with a header line and the columns
+ * direction,mcs,distance_m,load_pps,latency_ms,throughput_mbps,loss
+ * (extra columns are ignored). For each direction and MCS the entries must
+ * form a full distance x load grid; lookups use the nearest calibrated MCS
+ * and interpolate bilinearly in distance and load, clamping outside the grid.
+ */
+class RadioLookupTable : public SimpleRefCount<RadioLookupTable>
+{
+public:
+  /**
+   * \brief Load a table, aborting on malformed files
+   * \param filename CSV file written by calibrate_radio.py
+   */
+  explicit RadioLookupTable(const std::string& filename);
+
+  /**
+   * \param direction Uplink or downlink
+   * \param mcs Modulation and coding scheme
+   * \param distance UE-gNB distance (m)
+   * \param load Packets per second on the radio links
+   * \return The interpolated link performance
+   */
+  RadioLinkSample Lookup(RadioDirection direction, uint8_t mcs, double distance,
+                         double load) const;
+
+private:
+  /**
+   * \brief Distance x load grid of one direction and MCS
+   */
+  struct Grid
+  {
+    uint8_t mcs;                          ///< Calibrated MCS
+    std::vector<double> distances;        ///< Sorted grid distances (m)
+    std::vector<double> loads;            ///< Sorted grid loads (packets/s)
+    std::vector<RadioLinkSample> cells;   ///< Row-major [distance][load]
+  };
+
+  std::vector<Grid> m_grids[RADIO_DIRECTION_COUNT];  ///< Grids by direction
+};
+
+/**
+ * \brief Offered load of all the abstract radio links
+ *
+ * Counts the packets sent on any link in a sliding window; the same
+ * definition of load is used by RadioProbe when calibrating.
+ */
+class RadioLoadMeter : public SimpleRefCount<RadioLoadMeter>
+{
+public:
+  /**
+   * \param window Length of the sliding window
+   */
+  explicit RadioLoadMeter(Time window);
+
+  /**
+   * \brief Count a packet sent now
+   * \param now Current time
+   * \return The load including this packet (packets/s)
+   */
+  double Record(Time now);
+
+private:
+  Time m_window;              ///< Sliding window length
+  std::deque<Time> m_sent;    ///< Send times within the window
+};
+
+/**
+ * \brief Link between one UE and the gNB node, driven by a RadioLookupTable
+ */
+class AbstractRadioChannel : public SimpleChannel
+{
+public:
+  static TypeId GetTypeId();
+
+  AbstractRadioChannel();
+
+  /**
+   * \brief Configure the link
+   *
+   * \param ue Device of the UE
+   * \param gnb Device of the gNB node
+   * \param table Calibrated table
+   * \param meter Load meter shared by all the links
+   * \param loss Random variable for the packet losses, shared by all the links
+   * \param mcs Modulation and coding scheme of the table entries to use
+   */
+  void Setup(Ptr<SimpleNetDevice> ue, Ptr<SimpleNetDevice> gnb,
+             Ptr<const RadioLookupTable> table, Ptr<RadioLoadMeter> meter,
+             Ptr<UniformRandomVariable> loss, uint8_t mcs);
+
+  void Send(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from,
+            Ptr<SimpleNetDevice> sender) override;
+
+private:
+  Ptr<SimpleNetDevice> m_ue;                      ///< UE end of the link
+  Ptr<SimpleNetDevice> m_gnb;                     ///< gNB end of the link
+  Ptr<MobilityModel> m_ueMobility;                ///< Looked up at the first packet
+  Ptr<MobilityModel> m_gnbMobility;               ///< Looked up at the first packet
+  Ptr<const RadioLookupTable> m_table;            ///< Calibrated table
+  Ptr<RadioLoadMeter> m_meter;                    ///< Shared load meter
+  Ptr<UniformRandomVariable> m_loss;              ///< Shared loss draws
+  uint8_t m_mcs;                                  ///< MCS of the link
+  Time m_busyUntil[RADIO_DIRECTION_COUNT];        ///< End of the last transmission
+  Time m_lastArrival[RADIO_DIRECTION_COUNT];      ///< Keeps each direction FIFO
+};
+
+/**
+ * \brief Connects the UEs to the gNB node with abstract radio links
+ */
+class AbstractRadioHelper
+{
+public:
+  /**
+   * \param tableFile Calibrated table (CSV)
+   * \param mcs Modulation and coding scheme of the table entries to use
+   * \param loadWindow Window of the load meter, as used in the calibration
+   */
+  AbstractRadioHelper(const std::string& tableFile, uint8_t mcs, Time loadWindow);
+
+  /**
+   * \brief Create one link per UE and configure IPv4 over it
+   *
+   * Both ends must have the internet stack installed. Each link gets its own
+   * /30 subnet of 7.0.0.0/8, with the UE default route through the gNB node.
+   *
+   * \param gnb The gNB node
+   * \param ues The UE nodes
+   * \return The UE interfaces
+   */
+  Ipv4InterfaceContainer Install(Ptr<Node> gnb, NodeContainer ues);
+
+  /**
+   * \brief Assign the stream of the packet loss draws
+   * \param stream First stream index to use
+   * \return The number of streams assigned
+   */
+  int64_t AssignStreams(int64_t stream);
+
+private:
+  Ptr<const RadioLookupTable> m_table;    ///< Calibrated table
+  Ptr<RadioLoadMeter> m_meter;            ///< Shared load meter
+  Ptr<UniformRandomVariable> m_loss;      ///< Shared loss draws
+  uint8_t m_mcs;                          ///< MCS of the links
+  Ipv4AddressHelper m_addresses;          ///< One /30 per link
+};
+
+} // namespace ns3
+
+#endif // NS3_RADIO_ABSTRACTION_H
@@ -0,0 +1,168 @@
+/**
+ * Implementation of the radio calibration probe
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4-header.h"
+
+#include "radio-probe.h"
+#include "trace-sink.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("RadioProbe");
+
+namespace {
+
+/// Key of the IPv4 header at the front of a packet
+std::pair<uint64_t, uint16_t>
+GetPacketKey(Ptr<const Packet> packet, Ipv4Header& header)
+{
+  packet->PeekHeader(header);
+  uint64_t addresses = (static_cast<uint64_t>(header.GetSource().Get()) << 32) |
+                       header.GetDestination().Get();
+  return {addresses, header.GetIdentification()};
+}
+
+} // namespace
+
+RadioProbe::RadioProbe(uint8_t mcs, Time loadWindow, Time lossTimeout)
+  : m_mcs(mcs),
+    m_lossTimeout(lossTimeout),
+    m_meter(loadWindow),
+    m_tunInterface(0)
+{
+}
+
+void
+RadioProbe::Install(Ptr<Node> pgw, uint32_t tunInterface, Ptr<Node> gnb, NodeContainer ues)
+{
+  m_tunInterface = tunInterface;
+  m_gnbMobility = gnb->GetObject<MobilityModel>();
+
+  Ptr<Ipv4> pgwIpv4 = pgw->GetObject<Ipv4>();
+  pgwIpv4->TraceConnectWithoutContext("Tx", MakeCallback(&RadioProbe::PgwTx, this));
+  pgwIpv4->TraceConnectWithoutContext("Rx", MakeCallback(&RadioProbe::PgwRx, this));
+
+  for (uint32_t i = 0; i < ues.GetN(); i++)
+  {
+    Ptr<Ipv4> ipv4 = ues.Get(i)->GetObject<Ipv4>();
+    m_ueByAddress[ipv4->GetAddress(1, 0).GetLocal().Get()] = ues.Get(i);
+    ipv4->TraceConnectWithoutContext("Tx", MakeCallback(&RadioProbe::UeTx, this));
+    ipv4->TraceConnectWithoutContext("Rx", MakeCallback(&RadioProbe::UeRx, this));
+  }
+}
+
+void
+RadioProbe::UeTx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  // Interface 0 is the loopback
+  if (interface != 0)
+  {
+    Sent(packet, RADIO_UPLINK, ipv4->GetObject<Node>());
+  }
+}
+
+void
+RadioProbe::UeRx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  if (interface != 0)
+  {
+    Received(packet);
+  }
+}
+
+void
+RadioProbe::PgwTx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  if (interface != m_tunInterface)
+  {
+    return;
+  }
+  Ipv4Header header;
+  packet->PeekHeader(header);
+  auto ue = m_ueByAddress.find(header.GetDestination().Get());
+  if (ue != m_ueByAddress.end())
+  {
+    Sent(packet, RADIO_DOWNLINK, ue->second);
+  }
+}
+
+void
+RadioProbe::PgwRx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  // GTP-U packets on the S1-U interface carry the same packet again
+  if (interface == m_tunInterface)
+  {
+    Received(packet);
+  }
+}
+
+void
+RadioProbe::Sent(Ptr<const Packet> packet, RadioDirection direction, Ptr<Node> ue)
+{
+  ExpireLost();
+
+  Ipv4Header header;
+  PacketKey key = GetPacketKey(packet, header);
+
+  InFlight sent;
+  sent.direction = direction;
+  sent.ueNode = ue->GetId();
+  sent.distance = ue->GetObject<MobilityModel>()->GetDistanceFrom(m_gnbMobility);
+  sent.size = packet->GetSize();
+  sent.sent = Simulator::Now();
+  sent.load = m_meter.Record(sent.sent);
+
+  m_inFlight[key] = sent;
+  m_sendOrder.push_back({sent.sent, key});
+}
+
+void
+RadioProbe::Received(Ptr<const Packet> packet)
+{
+  Ipv4Header header;
+  auto it = m_inFlight.find(GetPacketKey(packet, header));
+  if (it == m_inFlight.end())
+  {
+    return;
+  }
+  Write(it->second, Simulator::Now() - it->second.sent, false);
+  m_inFlight.erase(it);
+}
+
+void
+RadioProbe::ExpireLost()
+{
+  Time now = Simulator::Now();
+  while (!m_sendOrder.empty() && m_sendOrder.front().first <= now - m_lossTimeout)
+  {
+    // Received packets were already removed from the in-flight map
+    auto it = m_inFlight.find(m_sendOrder.front().second);
+    if (it != m_inFlight.end() && it->second.sent == m_sendOrder.front().first)
+    {
+      Write(it->second, Seconds(0), true);
+      m_inFlight.erase(it);
+    }
+    m_sendOrder.pop_front();
+  }
+}
+
+void
+RadioProbe::Write(const InFlight& packet, Time latency, bool lost) const
+{
+  TraceRecord record(TRACE_RADIO_PROBE);
+  record.AddText(packet.direction == RADIO_UPLINK ? "UL" : "DL")
+        .AddUint(packet.ueNode)
+        .AddDouble(packet.distance)
+        .AddDouble(packet.load)
+        .AddUint(m_mcs)
+        .AddUint(packet.size)
+        .AddSeconds(packet.sent)
+        .AddTime(latency)
+        .AddUint(lost ? 1 : 0);
+  TraceSinkRegistry::Write(record);
+}
+
+} // namespace ns3
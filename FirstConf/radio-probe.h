@@ -0,0 +1,111 @@
+/**
+ * RadioProbe - Per-packet radio measurements for the abstract radio calibration
+ *
+ * In full NR runs with --radioProbe the probe follows every IPv4 packet over
+ * the radio: uplink from the UE IPv4 layer to the PGW tunnel interface,
+ * downlink from the PGW tunnel interface to the UE IPv4 layer. Packets are
+ * matched by source, destination and IPv4 identification, and each one is
+ * written to radio_probe_<simType>.csv with the UE-gNB distance, the radio
+ * load (RadioLoadMeter, as in the abstract links) and the MCS at send time,
+ * the size, the one-way latency and whether it was lost. These rows are the
+ * input of scripts/calibrate_radio.py.
+ */
+
+#ifndef NS3_RADIO_PROBE_H
+#define NS3_RADIO_PROBE_H
+
+#include "ns3/ipv4.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+
+#include "radio-abstraction.h"
+
+#include <deque>
+#include <map>
+
+namespace ns3 {
+
+/**
+ * \brief Measures the one-way radio latency and loss of every packet
+ */
+class RadioProbe : public SimpleRefCount<RadioProbe>
+{
+public:
+  /**
+   * \param mcs MCS configured in the NR scheduler
+   * \param loadWindow Window of the load meter
+   * \param lossTimeout Packets not received within this time are written as lost
+   */
+  RadioProbe(uint8_t mcs, Time loadWindow, Time lossTimeout);
+
+  /**
+   * \brief Connect to the IPv4 traces of the PGW and of the UEs
+   *
+   * \param pgw The PGW node
+   * \param tunInterface IPv4 interface of the PGW tunnel towards the UEs
+   * \param gnb The gNB node, for the distances
+   * \param ues The UE nodes, with their addresses already assigned
+   */
+  void Install(Ptr<Node> pgw, uint32_t tunInterface, Ptr<Node> gnb, NodeContainer ues);
+
+private:
+  /**
+   * \brief A packet sent over the radio and not received yet
+   */
+  struct InFlight
+  {
+    uint8_t direction;    ///< RadioDirection
+    uint32_t ueNode;      ///< UE node id
+    double distance;      ///< UE-gNB distance at send time (m)
+    double load;          ///< Radio load at send time (packets/s)
+    uint32_t size;        ///< IPv4 packet size (bytes)
+    Time sent;            ///< Send time
+  };
+
+  /// Source, destination and identification of an IPv4 packet
+  typedef std::pair<uint64_t, uint16_t> PacketKey;
+
+  void UeTx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  void UeRx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  void PgwTx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  void PgwRx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  /**
+   * \brief Start following a packet
+   * \param packet The packet, with its IPv4 header
+   * \param direction RadioDirection
+   * \param ue UE node
+   */
+  void Sent(Ptr<const Packet> packet, RadioDirection direction, Ptr<Node> ue);
+
+  /**
+   * \brief Write the measurement of a packet that reached the other end
+   * \param packet The packet, with its IPv4 header
+   */
+  void Received(Ptr<const Packet> packet);
+
+  /**
+   * \brief Write as lost the packets older than the loss timeout
+   */
+  void ExpireLost();
+
+  /**
+   * \brief Write one trace row
+   */
+  void Write(const InFlight& packet, Time latency, bool lost) const;
+
+  uint8_t m_mcs;                                  ///< Configured MCS
+  Time m_lossTimeout;                             ///< Age of a lost packet
+  RadioLoadMeter m_meter;                         ///< Radio load
+  uint32_t m_tunInterface;                        ///< PGW interface towards the UEs
+  Ptr<MobilityModel> m_gnbMobility;               ///< gNB position
+  std::map<uint32_t, Ptr<Node>> m_ueByAddress;    ///< Downlink destinations
+  std::map<PacketKey, InFlight> m_inFlight;       ///< Packets on the radio
+  std::deque<std::pair<Time, PacketKey>> m_sendOrder;  ///< For the loss timeout
+};
+
+} // namespace ns3
+
+#endif // NS3_RADIO_PROBE_H
@@ -0,0 +1,130 @@
+/**
+ * Implementation of the fork-based replication server
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include "replication-server.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("ReplicationServer");
+
+namespace {
+
+uint32_t
+ParseRun(const std::string& text, const std::string& item)
+{
+  char* end = nullptr;
+  unsigned long run = std::strtoul(text.c_str(), &end, 10);
+  NS_ABORT_MSG_IF(text.empty() || *end != '\0' || run == 0,
+                  "Invalid run '" << text << "' in replication variant '" << item << "'");
+  return static_cast<uint32_t>(run);
+}
+
+} // namespace
+
+std::vector<ReplicationVariant>
+ParseReplicationVariants(const std::string& spec)
+{
+  std::vector<ReplicationVariant> variants;
+  std::stringstream ss(spec);
+  std::string item;
+  while (std::getline(ss, item, ','))
+  {
+    size_t colon = item.find(':');
+    NS_ABORT_MSG_IF(colon == std::string::npos || colon == 0,
+                    "Replication variant '" << item << "' is not strategy:run[-lastRun]");
+    std::string strategy = item.substr(0, colon);
+    std::string runs = item.substr(colon + 1);
+
+    size_t dash = runs.find('-');
+    uint32_t first = ParseRun(runs.substr(0, dash), item);
+    uint32_t last = dash == std::string::npos ? first : ParseRun(runs.substr(dash + 1), item);
+    NS_ABORT_MSG_IF(last < first, "Empty run range in replication variant '" << item << "'");
+
+    for (uint32_t run = first; run <= last; run++)
+    {
+      variants.push_back({strategy, run});
+    }
+  }
+  NS_ABORT_MSG_IF(variants.empty(), "No replication variants in '" << spec << "'");
+  return variants;
+}
+
+int
+ForkReplications(const std::vector<ReplicationVariant>& variants, uint32_t maxJobs,
+                 uint32_t& failures)
+{
+  if (maxJobs == 0)
+  {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    maxJobs = cores > 0 ? static_cast<uint32_t>(cores) : 1;
+  }
+
+  // Buffered output would otherwise be written once by every child
+  std::cout.flush();
+  std::fflush(nullptr);
+
+  std::map<pid_t, uint32_t> running;
+  uint32_t next = 0;
+  failures = 0;
+  while (next < variants.size() || !running.empty())
+  {
+    if (next < variants.size() && running.size() < maxJobs)
+    {
+      pid_t pid = fork();
+      NS_ABORT_MSG_IF(pid < 0, "fork() failed: " << std::strerror(errno));
+      if (pid == 0)
+      {
+        return static_cast<int>(next);
+      }
+      running[pid] = next++;
+      continue;
+    }
+
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0)
+    {
+      NS_ABORT_MSG_IF(errno != EINTR, "waitpid() failed: " << std::strerror(errno));
+      continue;
+    }
+    auto it = running.find(pid);
+    if (it == running.end())
+    {
+      continue;
+    }
+
+    const ReplicationVariant& variant = variants[it->second];
+    bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (!ok)
+    {
+      failures++;
+    }
+    NS_LOG_UNCOND("Replication " << GetReplicationFolder(variant) << (ok ? " done" : " FAILED"));
+    running.erase(it);
+  }
+  return -1;
+}
+
+std::string
+GetReplicationFolder(const ReplicationVariant& variant)
+{
+  return variant.strategy + "_run" + std::to_string(variant.run);
+}
+
+} // namespace ns3
@@ -0,0 +1,62 @@
+/**
+ * ReplicationServer - Fork-based warm start of replications
+ *
+ * Replications that differ only in seed or strategy share the whole scenario
+ * setup (NR helper, operation band, device installation, EPC bearers, RRC
+ * attachment). In replication server mode CoE builds and runs the scenario
+ * once up to a warm-up time, before any application starts, and then fork()s
+ * one child per variant. Each child reseeds its random streams, selects its
+ * strategy and continues the simulation from the shared state with its own
+ * output folder, so the per-replication startup cost is only the fork.
+ */
+
+#ifndef NS3_REPLICATION_SERVER_H
+#define NS3_REPLICATION_SERVER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief One replication continued from the warm state
+ */
+struct ReplicationVariant
+{
+  std::string strategy;   ///< Offloading strategy
+  uint32_t run;           ///< RngRun of the replication
+};
+
+/**
+ * \brief Parse a list of variants
+ *
+ * \param spec Comma-separated "strategy:run" or "strategy:firstRun-lastRun",
+ *             e.g. "VCCFirst:1-10,EC_and_CC:1-10"
+ * \return The variants, in order
+ */
+std::vector<ReplicationVariant> ParseReplicationVariants(const std::string& spec);
+
+/**
+ * \brief Fork one child process per variant, at most maxJobs at a time
+ *
+ * Returns in the children immediately, and in the parent once every child
+ * has exited.
+ *
+ * \param variants The variants
+ * \param maxJobs Maximum number of concurrent children, 0 for the number of cores
+ * \param failures Receives, in the parent, the number of children that failed
+ * \return In a child, the index of its variant; in the parent, -1
+ */
+int ForkReplications(const std::vector<ReplicationVariant>& variants, uint32_t maxJobs,
+                     uint32_t& failures);
+
+/**
+ * \param variant The variant
+ * \return Name of the output subfolder of a variant, "<strategy>_run<run>"
+ */
+std::string GetReplicationFolder(const ReplicationVariant& variant);
+
+} // namespace ns3
+
+#endif // NS3_REPLICATION_SERVER_H
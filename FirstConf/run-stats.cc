@@ -0,0 +1,88 @@
+/**
+ * Implementation of the run statistics
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include "run-stats.h"
+#include "globals.h"
+#include "task-registry.h"
+
+#include <chrono>
+#include <fstream>
+#include <sys/resource.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("RunStats");
+
+namespace {
+
+int64_t
+WallClock()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+int64_t RunStats::s_start = 0;
+int64_t RunStats::s_markWall = 0;
+double RunStats::s_markTime = 0;
+uint64_t RunStats::s_markEvents = 0;
+
+void
+RunStats::Start()
+{
+  s_start = WallClock();
+}
+
+void
+RunStats::Mark()
+{
+  s_markWall = WallClock();
+  s_markTime = Simulator::Now().GetSeconds();
+  s_markEvents = Simulator::GetEventCount();
+}
+
+void
+RunStats::Dump(std::string filename)
+{
+  // Called at Simulator::Destroy(): includes the outputs written before it
+  int64_t now = WallClock();
+  double setupWall = (s_markWall - s_start) / 1e9;
+  double runWall = (now - s_markWall) / 1e9;
+  uint64_t events = Simulator::GetEventCount() - s_markEvents;
+
+  // Linux reports the peak resident set size in KiB
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  double peakRss = usage.ru_maxrss / 1024.0;
+
+  uint32_t requests = TaskRegistry::GetN();
+  uint32_t completed = 0;
+  for (uint32_t task = 0; task < requests; task++)
+  {
+    if (TaskRegistry::GetStatus(task) == TASK_COMPLETED)
+    {
+      completed++;
+    }
+  }
+
+  std::ofstream file(filename);
+  if (!file.is_open())
+  {
+    NS_LOG_ERROR("Cannot open run statistics file " << filename);
+    return;
+  }
+  file << "vehicles,pedestrians,request_interval_ms,sim_time_s,setup_wall_s,run_wall_s,"
+          "events,events_per_s,peak_rss_mb,requests,completed_requests\n";
+  file << cars_number << "," << pedestrians_number << "," << request_rate << ","
+       << Simulator::Now().GetSeconds() - s_markTime << "," << setupWall << "," << runWall << ","
+       << events << "," << (runWall > 0 ? events / runWall : 0) << "," << peakRss << ","
+       << requests << "," << completed << "\n";
+}
+
+} // namespace ns3
@@ -0,0 +1,51 @@
+/**
+ * RunStats - Cost of a simulation run
+ *
+ * With --runStats, the run writes run_stats_<simType>.csv at its end: the
+ * scenario size (vehicles, pedestrians, request interval, simulated time),
+ * the wall-clock time spent building the scenario and running it, the
+ * simulation events executed and their rate, the peak resident set size and
+ * the requests sent and completed. scripts/scaling_benchmark.py runs a grid
+ * of scenario sizes and fits a cost model on these rows.
+ */
+
+#ifndef NS3_RUN_STATS_H
+#define NS3_RUN_STATS_H
+
+#include <cstdint>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \brief Wall-clock time, events and memory of the run
+ */
+class RunStats
+{
+public:
+  /**
+   * \brief Remember the start of the process, before the scenario is built
+   */
+  static void Start();
+
+  /**
+   * \brief Remember the start of the simulation run (in a forked replication, of its own run)
+   */
+  static void Mark();
+
+  /**
+   * \brief Write the statistics of the run since Mark()
+   * \param filename Output file, overwritten
+   */
+  static void Dump(std::string filename);
+
+private:
+  static int64_t s_start;      ///< Wall clock at Start() (ns)
+  static int64_t s_markWall;   ///< Wall clock at Mark() (ns)
+  static double s_markTime;    ///< Simulation time at Mark() (s)
+  static uint64_t s_markEvents; ///< Events executed at Mark()
+};
+
+} // namespace ns3
+
+#endif // NS3_RUN_STATS_H
@@ -0,0 +1,87 @@
+"""
+Beaconing Report
+
+Compares runs of the same scenario with different vehicle beaconing modes
+(CoE --beaconMode=fixed|delta|adaptive) against a baseline run, normally
+the fixed 100 ms beaconing:
+    beacons       beacons sent, per vehicle and second, and uplink bytes/s
+    stale         tasks the edge offloaded to a vehicle whose queue was
+                  already full (rejected by the vehicle), over all the tasks
+                  offloaded to vehicles
+    latency       mean and p95 offloading time per tier, and the change
+                  against the baseline
+    run time      when the folders are sweep runs (DONE marker)
+
+Usage:
+    python beacon_report.py BASELINE_RUN RUN [RUN ...] [--labels fixed,delta,...]
+        [--sim-time 120]
+"""
+import argparse
+import os
+import statistics
+import sys
+
+from trace_utils import TIERS, offloading_times, percentile, read_trace, run_duration
+
+BEACON_COLUMNS = ['node_id', 'packet_size', 'position_x', 'position_y', 'position_z', 'time_ns',
+                  'queue_state', 'request_rate', 'cars_number']
+PACKET_COLUMNS = ['node_id', 'packet_size', 'initial_time_ns', 'time_ns', 'where']
+
+
+def summarize(run_dir, sim_time):
+    beacons = read_trace(run_dir, 'total_VCC_beacons_', BEACON_COLUMNS)
+    received = read_trace(run_dir, 'total_VCC_received_from_edge_packets_', PACKET_COLUMNS)
+    rejected = read_trace(run_dir, 'total_VCC_rejected_packets_cause_full_queue_', PACKET_COLUMNS)
+    vehicles = int(beacons[0]['cars_number']) if beacons else 0
+    return {
+        'beacons': len(beacons),
+        'rate': len(beacons) / (vehicles * sim_time) if vehicles else 0.0,
+        'bytes': sum(b['packet_size'] for b in beacons) / sim_time,
+        'offloaded': len(received),
+        'stale': len(rejected) / len(received) if received else 0.0,
+        'times': offloading_times(run_dir),
+        'duration': run_duration(run_dir),
+    }
+
+
+def change(value, baseline):
+    return f'{100 * (value - baseline) / baseline:>+7.1f}%' if baseline else f'{"-":>8}'
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare beaconing modes against a baseline run')
+    parser.add_argument('runs', nargs='+', help='output folders, the baseline first')
+    parser.add_argument('--labels', help='comma-separated names of the runs (default: folder names)')
+    parser.add_argument('--sim-time', type=float, default=120, help='simulated time of the runs (s)')
+    args = parser.parse_args()
+
+    labels = args.labels.split(',') if args.labels else [os.path.basename(os.path.normpath(r))
+                                                         for r in args.runs]
+    if len(labels) != len(args.runs):
+        sys.exit('One label per run is needed')
+    runs = [summarize(r, args.sim_time) for r in args.runs]
+    base = runs[0]
+
+    print(f'{"run":>16} {"beacons":>9} {"/veh/s":>7} {"kB/s":>8} {"change":>8} '
+          f'{"VCC tasks":>9} {"stale":>7} {"run time":>9}')
+    for label, run in zip(labels, runs):
+        duration = f'{run["duration"]:>8.1f}s' if run['duration'] else f'{"-":>9}'
+        print(f'{label:>16} {run["beacons"]:>9} {run["rate"]:>7.2f} {run["bytes"] / 1e3:>8.1f} '
+              f'{change(run["beacons"], base["beacons"])} {run["offloaded"]:>9} '
+              f'{100 * run["stale"]:>6.2f}% {duration}')
+
+    print(f'\n{"run":>16} {"tier":>6} {"tasks":>7} {"mean":>9} {"change":>8} {"p95":>9} {"change":>8}   (ms)')
+    for label, run in zip(labels, runs):
+        for where, tier in TIERS.items():
+            times, base_times = run['times'].get(where, []), base['times'].get(where, [])
+            if not times:
+                continue
+            mean, p95 = statistics.fmean(times), percentile(times, 95)
+            base_mean = statistics.fmean(base_times) if base_times else 0
+            base_p95 = percentile(base_times, 95) if base_times else 0
+            print(f'{label:>16} {tier:>6} {len(times):>7} {mean:>9.3f} {change(mean, base_mean)} '
+                  f'{p95:>9.3f} {change(p95, base_p95)}')
+
+
+if __name__ == '__main__':
+    main()
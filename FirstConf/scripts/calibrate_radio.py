@@ -0,0 +1,255 @@
+"""
+Abstract Radio Calibration
+
+Builds the lookup table of the abstract radio model (CoE --radioModel=abstract)
+from full NR runs, and reports how far the abstraction is from the NR model.
+
+fit: reads the per-packet radio measurements of one or more full NR runs
+(CoE --radioProbe=true, radio_probe_<simType>.csv or the binary folder), bins
+them by direction, MCS, UE-gNB distance and radio load, and writes one table
+entry per bin:
+    latency_ms, throughput_mbps  least-squares fit of latency = a + size / b,
+                                 or the mean latency (throughput 0) when the
+                                 packets of the bin all have the same size
+    loss                         fraction of packets lost in the bin
+Grid points are the bin centres; empty bins are filled from the nearest
+calibrated bin, so that the table is a full grid. The error of the table on
+the calibration packets (and on --validate runs, measured independently) is
+reported per direction, interpolating as CoE does.
+
+compare: end-to-end check of a whole configuration run with both models, on
+the offloading time of every tier, and on the run time when the folders are
+sweep runs (DONE marker written by run_sweep.py).
+
+Usage:
+    python calibrate_radio.py fit NR_RUN [NR_RUN ...] -o table.csv
+        [--distance-bins 0,25,50,...] [--load-bins 0,100,...] [--validate NR_RUN ...]
+    python calibrate_radio.py compare --nr NR_RUN --abstract ABSTRACT_RUN
+"""
+import argparse
+import bisect
+import csv
+import statistics
+import sys
+from collections import defaultdict
+
+from trace_utils import TIERS, offloading_times, percentile, read_trace, run_duration
+
+PROBE_COLUMNS = ['direction', 'node_id', 'distance_m', 'load_pps', 'mcs', 'packet_size',
+                 'time_ns', 'latency_ns', 'lost']
+TABLE_COLUMNS = ['direction', 'mcs', 'distance_m', 'load_pps', 'latency_ms', 'throughput_mbps',
+                 'loss', 'samples']
+
+DEFAULT_DISTANCE_BINS = '0,25,50,100,150,200,300,400,600,1000'
+DEFAULT_LOAD_BINS = '0,50,100,200,500,1000,2000,5000,10000'
+
+
+def parse_bins(text):
+    edges = sorted(float(v) for v in text.split(','))
+    if len(edges) < 2:
+        sys.exit('At least two bin edges are needed: ' + text)
+    return edges
+
+
+def bin_index(edges, value):
+    # Values beyond the last edge go into the last bin
+    return min(max(bisect.bisect_right(edges, value) - 1, 0), len(edges) - 2)
+
+
+def centres(edges):
+    return [(edges[i] + edges[i + 1]) / 2 for i in range(len(edges) - 1)]
+
+
+def fit_bin(samples):
+    """(latency_ms, throughput_mbps) of the received packets of one bin"""
+    sizes = [8.0 * s[0] for s in samples]
+    latencies = [s[1] for s in samples]
+    mean_latency = statistics.fmean(latencies)
+    if len(set(sizes)) > 1:
+        mean_size = statistics.fmean(sizes)
+        var = sum((x - mean_size) ** 2 for x in sizes)
+        slope = sum((x - mean_size) * (y - mean_latency) for x, y in zip(sizes, latencies)) / var
+        intercept = mean_latency - slope * mean_size
+        if slope > 0 and intercept >= 0:
+            return intercept * 1e3, 1e-6 / slope
+    return mean_latency * 1e3, 0.0
+
+
+def fit(args):
+    distance_edges = parse_bins(args.distance_bins)
+    load_edges = parse_bins(args.load_bins)
+    rows = [r for run in args.runs for r in read_trace(run, 'radio_probe_', PROBE_COLUMNS)]
+    if not rows:
+        sys.exit('No radio probe rows: run CoE with --radioProbe=true')
+
+    # (direction, mcs) -> (distance bin, load bin) -> received (size, latency) and lost count
+    received = defaultdict(lambda: defaultdict(list))
+    lost = defaultdict(lambda: defaultdict(int))
+    for r in rows:
+        key = (r['direction'], int(r['mcs']))
+        cell = (bin_index(distance_edges, r['distance_m']), bin_index(load_edges, r['load_pps']))
+        if r['lost']:
+            lost[key][cell] += 1
+        else:
+            received[key][cell].append((r['packet_size'], r['latency_ns'] * 1e-9))
+
+    table = []
+    for key in sorted(set(received) | set(lost)):
+        cells = {}
+        for cell in set(received[key]) | set(lost[key]):
+            samples = received[key][cell]
+            n = len(samples) + lost[key][cell]
+            if len(samples) < args.min_samples:
+                continue
+            latency_ms, throughput_mbps = fit_bin(samples)
+            cells[cell] = (latency_ms, throughput_mbps, lost[key][cell] / n, n)
+        if not cells:
+            print(f'{key[0]} MCS {key[1]}: no bin with {args.min_samples} packets, skipped')
+            continue
+        for d, distance in enumerate(centres(distance_edges)):
+            for l, load in enumerate(centres(load_edges)):
+                if (d, l) in cells:
+                    entry = cells[(d, l)]
+                else:
+                    nearest = min(cells, key=lambda c: (c[0] - d) ** 2 + (c[1] - l) ** 2)
+                    entry = cells[nearest][:3] + (0,)
+                table.append([key[0], key[1], distance, load] + list(entry))
+
+    with open(args.output, 'w', newline='') as f:
+        writer = csv.writer(f)
+        writer.writerow(TABLE_COLUMNS)
+        writer.writerows(table)
+    print(f'{len(rows)} packets from {len(args.runs)} runs, {len(table)} table entries '
+          f'written to {args.output}')
+
+    lookup = LookupTable(args.output)
+    report_error('calibration runs', rows, lookup)
+    if args.validate:
+        report_error('validation runs', [r for run in args.validate
+                                         for r in read_trace(run, 'radio_probe_', PROBE_COLUMNS)],
+                     lookup)
+
+
+class LookupTable:
+    """Same lookup as RadioLookupTable in radio-abstraction.cc"""
+
+    def __init__(self, file_name):
+        self.grids = defaultdict(dict)
+        with open(file_name) as f:
+            for row in csv.DictReader(f):
+                grid = self.grids[row['direction']].setdefault(int(float(row['mcs'])), {})
+                grid[(float(row['distance_m']), float(row['load_pps']))] = (
+                    float(row['latency_ms']) * 1e-3, float(row['throughput_mbps']) * 1e6,
+                    float(row['loss']))
+
+    @staticmethod
+    def locate(axis, value):
+        if len(axis) == 1 or value <= axis[0]:
+            return 0, 0.0
+        if value >= axis[-1]:
+            return len(axis) - 1, 0.0
+        upper = bisect.bisect_right(axis, value)
+        return upper - 1, (value - axis[upper - 1]) / (axis[upper] - axis[upper - 1])
+
+    def lookup(self, direction, mcs, distance, load):
+        grids = self.grids[direction]
+        grid = grids[min(grids, key=lambda m: abs(m - mcs))]
+        distances = sorted({d for d, _ in grid})
+        loads = sorted({l for _, l in grid})
+        d, fd = self.locate(distances, distance)
+        l, fl = self.locate(loads, load)
+        d1 = min(d + 1, len(distances) - 1)
+        l1 = min(l + 1, len(loads) - 1)
+
+        def blend(a, b, fraction):
+            return tuple(x + (y - x) * fraction for x, y in zip(a, b))
+
+        low = blend(grid[(distances[d], loads[l])], grid[(distances[d], loads[l1])], fl)
+        high = blend(grid[(distances[d1], loads[l])], grid[(distances[d1], loads[l1])], fl)
+        return blend(low, high, fd)
+
+    def latency(self, direction, mcs, distance, load, size):
+        # Without the per-link serialization queue of the abstract channel
+        latency, throughput, loss = self.lookup(direction, mcs, distance, load)
+        return latency + (8.0 * size / throughput if throughput > 0 else 0.0), loss
+
+
+def report_error(title, rows, lookup):
+    print(f'\nError of the table on the {title}:')
+    print(f'{"dir":>4} {"packets":>8} {"NR mean":>9} {"table":>9} {"MAE":>8} '
+          f'{"NR p95":>9} {"table p95":>9} {"NR loss":>8} {"table":>8}   (ms)')
+    for direction in ('UL', 'DL'):
+        measured, predicted = [], []
+        lost = 0
+        expected_loss = 0.0
+        for r in rows:
+            if r['direction'] != direction:
+                continue
+            latency, loss = lookup.latency(direction, int(r['mcs']), r['distance_m'],
+                                           r['load_pps'], r['packet_size'])
+            expected_loss += loss
+            if r['lost']:
+                lost += 1
+            else:
+                measured.append(r['latency_ns'] * 1e-6)
+                predicted.append(latency * 1e3)
+        n = len(measured) + lost
+        if not measured:
+            continue
+        mae = statistics.fmean(abs(m - p) for m, p in zip(measured, predicted))
+        print(f'{direction:>4} {n:>8} {statistics.fmean(measured):>9.3f} '
+              f'{statistics.fmean(predicted):>9.3f} {mae:>8.3f} {percentile(measured, 95):>9.3f} '
+              f'{percentile(predicted, 95):>9.3f} {lost / n:>8.4f} {expected_loss / n:>8.4f}')
+
+
+def compare(args):
+    nr = offloading_times(args.nr)
+    abstract = offloading_times(args.abstract)
+    print(f'{"tier":>6} {"NR tasks":>9} {"abstract":>9} {"NR mean":>9} {"abstract":>9} {"error":>8} '
+          f'{"NR p95":>9} {"abstract":>9} {"error":>8}   (ms)')
+    for where, tier in TIERS.items():
+        a, b = nr.get(where, []), abstract.get(where, [])
+        if not a or not b:
+            print(f'{tier:>6} {len(a):>9} {len(b):>9}')
+            continue
+        mean_a, mean_b = statistics.fmean(a), statistics.fmean(b)
+        p95_a, p95_b = percentile(a, 95), percentile(b, 95)
+        print(f'{tier:>6} {len(a):>9} {len(b):>9} {mean_a:>9.3f} {mean_b:>9.3f} '
+              f'{100 * (mean_b - mean_a) / mean_a:>7.1f}% {p95_a:>9.3f} {p95_b:>9.3f} '
+              f'{100 * (p95_b - p95_a) / p95_a:>7.1f}%')
+
+    nr_duration, abstract_duration = run_duration(args.nr), run_duration(args.abstract)
+    if nr_duration and abstract_duration:
+        print(f'\nRun time: NR {nr_duration:.1f} s, abstract {abstract_duration:.1f} s, '
+              f'speedup {nr_duration / abstract_duration:.1f}x')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Calibrate the abstract radio model')
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    fit_parser = commands.add_parser('fit', help='build a table from full NR runs')
+    fit_parser.add_argument('runs', nargs='+', help='output folders of NR runs with --radioProbe')
+    fit_parser.add_argument('-o', '--output', required=True, help='table to write (CSV)')
+    fit_parser.add_argument('--distance-bins', default=DEFAULT_DISTANCE_BINS,
+                            help='distance bin edges (m)')
+    fit_parser.add_argument('--load-bins', default=DEFAULT_LOAD_BINS,
+                            help='radio load bin edges (packets/s)')
+    fit_parser.add_argument('--min-samples', type=int, default=20,
+                            help='packets needed to calibrate a bin')
+    fit_parser.add_argument('--validate', nargs='+', default=[],
+                            help='NR runs not used for the fit, to measure the error on')
+
+    compare_parser = commands.add_parser('compare', help='compare an NR and an abstract run')
+    compare_parser.add_argument('--nr', required=True, help='output folder of the NR run')
+    compare_parser.add_argument('--abstract', required=True, help='output folder of the abstract run')
+
+    args = parser.parse_args()
+    if args.command == 'fit':
+        fit(args)
+    else:
+        compare(args)
+
+
+if __name__ == '__main__':
+    main()
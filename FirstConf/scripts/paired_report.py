@@ -0,0 +1,169 @@
+"""
+Paired Strategy Report
+
+Compares offloading strategies on paired runs: runs of the same
+configuration with the same seed (RngRun) send the same requests (common
+random numbers: the request generators and the per-request draws of the edge
+random choices have their own streams), so the difference between two
+strategies is estimated on the per-seed differences, whose variance excludes
+the request-to-request noise shared by the pair.
+
+Reads either a sweep output folder (run_sweep.py: index.csv and runs/<hash>
+with a DONE marker), pairing the runs whose parameters differ only by
+strategy, or a replication server folder (CoE --forkVariants:
+<strategy>_run<run> subfolders), pairing the runs by run number.
+
+For every configuration and strategy other than the baseline, and for the
+mean and the 95th percentile of the offloading time of the run, it reports
+the mean difference to the baseline over the pairs, its paired confidence
+interval (Student t on the differences), the unpaired (Welch) interval that
+independent runs would give, and the ratio of the two half-widths. Also
+written to paired_differences.csv in the folder.
+
+Usage:
+    python paired_report.py FOLDER [--baseline VCCFirst] [--confidence 0.95]
+"""
+import argparse
+import csv
+import os
+import re
+import statistics
+import sys
+from collections import defaultdict
+
+from trace_utils import offloading_times, percentile, t_quantile
+
+METRICS = ['mean_ms', 'p95_ms']
+PAIR_KEYS = ['RngRun']
+OUTPUT_COLUMNS = ['configuration', 'strategy', 'baseline', 'metric', 'pairs', 'strategy_value',
+                  'baseline_value', 'difference', 'paired_half_width', 'unpaired_half_width',
+                  'half_width_ratio', 'correlation']
+
+
+def run_metrics(run_dir):
+    times = [t for tier_times in offloading_times(run_dir).values() for t in tier_times]
+    if not times:
+        return None
+    return {'mean_ms': statistics.fmean(times), 'p95_ms': percentile(times, 95)}
+
+
+def sweep_runs(folder):
+    """(configuration, pair, strategy, run folder) of the completed runs of a sweep"""
+    runs = []
+    with open(os.path.join(folder, 'index.csv'), newline='') as f:
+        for row in csv.DictReader(f):
+            run_dir = os.path.join(folder, 'runs', row['hash'])
+            if not os.path.exists(os.path.join(run_dir, 'DONE')) or 'strategy' not in row:
+                continue
+            configuration = ' '.join(f'{k}={v}' for k, v in sorted(row.items())
+                                     if k not in ['hash', 'strategy'] + PAIR_KEYS and v != '')
+            pair = tuple(row.get(k, '') for k in PAIR_KEYS)
+            runs.append((configuration or 'all', pair, row['strategy'], run_dir))
+    return runs
+
+
+def replication_runs(folder):
+    """(configuration, pair, strategy, run folder) of the replications of a forked run"""
+    runs = []
+    for name in sorted(os.listdir(folder)):
+        match = re.fullmatch(r'(.+)_run(\d+)', name)
+        if match and os.path.isdir(os.path.join(folder, name)):
+            runs.append(('all', (match.group(2),), match.group(1), os.path.join(folder, name)))
+    return runs
+
+
+def correlation(a, b):
+    try:
+        return statistics.correlation(a, b)
+    except (statistics.StatisticsError, AttributeError):
+        return float('nan')
+
+
+def compare(values, baseline, confidence):
+    """Paired and unpaired comparison of a strategy to the baseline, on the common pairs"""
+    pairs = sorted(set(values) & set(baseline))
+    n = len(pairs)
+    a = [values[p] for p in pairs]
+    b = [baseline[p] for p in pairs]
+    differences = [x - y for x, y in zip(a, b)]
+    result = {'pairs': n, 'strategy_value': float('nan'), 'baseline_value': float('nan'),
+              'difference': float('nan'), 'paired_half_width': float('nan'),
+              'unpaired_half_width': float('nan'), 'half_width_ratio': float('nan'),
+              'correlation': float('nan')}
+    # No common seed, e.g. the runs of one side failed: skipped by the caller
+    if n == 0:
+        return result
+    result.update({'strategy_value': statistics.fmean(a), 'baseline_value': statistics.fmean(b),
+                   'difference': statistics.fmean(differences)})
+    if n < 2:
+        return result
+
+    t = t_quantile(confidence, n - 1)
+    paired = t * statistics.stdev(differences) / n ** 0.5
+    # Welch: the interval of the same number of independent runs of each strategy
+    var_a, var_b = statistics.variance(a), statistics.variance(b)
+    se = ((var_a + var_b) / n) ** 0.5
+    df = (var_a + var_b) ** 2 / ((var_a ** 2 + var_b ** 2) / (n - 1)) if var_a + var_b > 0 else n - 1
+    unpaired = t_quantile(confidence, max(df, 1)) * se
+    result.update({
+        'paired_half_width': paired,
+        'unpaired_half_width': unpaired,
+        'half_width_ratio': unpaired / paired if paired > 0 else float('inf'),
+        'correlation': correlation(a, b),
+    })
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Paired differences between offloading strategies')
+    parser.add_argument('folder', help='sweep output folder or replication server output folder')
+    parser.add_argument('--baseline', default='VCCFirst', help='reference strategy (default VCCFirst)')
+    parser.add_argument('--confidence', type=float, default=0.95, help='confidence level (default 0.95)')
+    args = parser.parse_args()
+
+    is_sweep = os.path.exists(os.path.join(args.folder, 'index.csv'))
+    runs = sweep_runs(args.folder) if is_sweep else replication_runs(args.folder)
+    if not runs:
+        sys.exit(f'No completed runs in {args.folder}')
+
+    # configuration -> strategy -> metric -> pair -> value
+    values = defaultdict(lambda: defaultdict(lambda: defaultdict(dict)))
+    for configuration, pair, strategy, run_dir in runs:
+        metrics = run_metrics(run_dir)
+        if metrics is None:
+            continue
+        for metric in METRICS:
+            values[configuration][strategy][metric][pair] = metrics[metric]
+
+    rows = []
+    for configuration in sorted(values):
+        strategies = values[configuration]
+        if args.baseline not in strategies:
+            print(f'{configuration}: no {args.baseline} runs, skipped')
+            continue
+        print(f'\n{configuration}  (baseline {args.baseline}, {100 * args.confidence:.0f}% intervals)')
+        print(f'{"strategy":>18} {"metric":>8} {"pairs":>6} {"value":>9} {"baseline":>9} '
+              f'{"diff":>9} {"paired +-":>10} {"unpaired +-":>12} {"ratio":>6} {"corr":>6}')
+        for strategy in sorted(s for s in strategies if s != args.baseline):
+            for metric in METRICS:
+                result = compare(strategies[strategy][metric], strategies[args.baseline][metric],
+                                 args.confidence)
+                if result['pairs'] == 0:
+                    continue
+                print(f'{strategy:>18} {metric:>8} {result["pairs"]:>6} {result["strategy_value"]:>9.3f} '
+                      f'{result["baseline_value"]:>9.3f} {result["difference"]:>+9.3f} '
+                      f'{result["paired_half_width"]:>10.3f} {result["unpaired_half_width"]:>12.3f} '
+                      f'{result["half_width_ratio"]:>6.2f} {result["correlation"]:>6.2f}')
+                rows.append(dict(result, configuration=configuration, strategy=strategy,
+                                 baseline=args.baseline, metric=metric))
+
+    output = os.path.join(args.folder, 'paired_differences.csv')
+    with open(output, 'w', newline='') as f:
+        writer = csv.DictWriter(f, fieldnames=OUTPUT_COLUMNS)
+        writer.writeheader()
+        writer.writerows(rows)
+    print(f'\nWritten {output}')
+
+
+if __name__ == '__main__':
+    main()
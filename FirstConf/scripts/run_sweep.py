@@ -0,0 +1,217 @@
+"""
+Parameter Sweep Runner
+
+Expands a declarative parameter matrix into CoE runs and executes them
+concurrently on the local cores, one process per run.
+
+Every run gets its own output folder <output_root>/runs/<hash>, where <hash>
+is computed from the full CoE argument set and the seed (--RngRun), and is
+passed to CoE as --outputDataCsv. A run is complete when its folder contains
+DONE; complete runs are skipped, so an interrupted or crashed sweep is resumed
+by launching the same command again. Folders of runs that were started but
+did not complete are emptied before the run is repeated, since the CSV traces
+are opened in append mode.
+
+Matrix file (JSON):
+    {
+      "binary": "/path/to/ns-3-dev/build/scratch/FirstConf/ns3-dev-CoE-default",
+      "output_root": "/path/to/results/sweep",
+      "seeds": [1, 2, 3],
+      "vars": {"speed": ["speed0", "speed1"], "run": [0, 1]},
+      "params": {
+        "strategy": ["VCCFirst", "EC_and_CC"],
+        "nVehicles": [10, 20],
+        "simTime": 120,
+        "traceFile": "/path/{speed}/Krauss/{nVehicles}/manhattan_Krauss_{nVehicles}_{run}.tcl"
+      }
+    }
+Lists are sweep axes and scalars are fixed values. "vars" are axes that are
+not CoE parameters but can be used in {placeholders} of string parameters.
+
+Status of each run (started, done, failed) is appended to
+<output_root>/sweep_status.jsonl and the full job list, with the parameters of
+every hash, is written to <output_root>/index.csv.
+
+Usage:
+    python run_sweep.py matrix.json [-j 8] [--binary PATH] [--dry-run] [--retry-failed]
+"""
+import argparse
+import csv
+import hashlib
+import itertools
+import json
+import os
+import shlex
+import shutil
+import subprocess
+import sys
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor, as_completed
+
+DONE_FILE = 'DONE'
+FAILED_FILE = 'FAILED'
+PARAMS_FILE = 'params.json'
+LOG_FILE = 'log.txt'
+
+
+def axes(section):
+    # Lists are axes, scalars are single-valued axes
+    return [(name, values if isinstance(values, list) else [values])
+            for name, values in section.items()]
+
+
+def expand_matrix(matrix):
+    var_axes = axes(matrix.get('vars', {}))
+    param_axes = axes(matrix.get('params', {}))
+    seeds = matrix.get('seeds', [1])
+
+    jobs = []
+    all_axes = var_axes + param_axes + [('RngRun', seeds)]
+    for combination in itertools.product(*(values for _, values in all_axes)):
+        values = dict(zip((name for name, _ in all_axes), combination))
+        params = {}
+        for name, _ in param_axes:
+            value = values[name]
+            if isinstance(value, str):
+                value = value.format(**values)
+            params[name] = value
+        params['RngRun'] = values['RngRun']
+        job_vars = {name: values[name] for name, _ in var_axes}
+        jobs.append({'hash': config_hash(params), 'vars': job_vars, 'params': params})
+
+    # The same CoE configuration may be reached from different vars: run it once
+    unique = {}
+    for job in jobs:
+        unique.setdefault(job['hash'], job)
+    return list(unique.values())
+
+
+def config_hash(params):
+    canonical = json.dumps(params, sort_keys=True, separators=(',', ':'))
+    return hashlib.sha1(canonical.encode()).hexdigest()[:16]
+
+
+class StatusLog:
+    def __init__(self, file_name):
+        self.lock = threading.Lock()
+        self.file = open(file_name, 'a')
+
+    def write(self, job_hash, status, **fields):
+        entry = {'hash': job_hash, 'status': status, 'time': time.time()}
+        entry.update(fields)
+        with self.lock:
+            self.file.write(json.dumps(entry) + '\n')
+            self.file.flush()
+
+
+def write_index(jobs, file_name):
+    var_names = sorted({name for job in jobs for name in job['vars']})
+    param_names = sorted({name for job in jobs for name in job['params']})
+    with open(file_name, 'w', newline='') as f:
+        writer = csv.writer(f)
+        writer.writerow(['hash'] + var_names + param_names)
+        for job in jobs:
+            writer.writerow([job['hash']] + [job['vars'].get(n, '') for n in var_names] +
+                            [job['params'].get(n, '') for n in param_names])
+
+
+def command_line(binary, params, run_dir):
+    command = shlex.split(binary)
+    for name, value in params.items():
+        command.append(f'--{name}={value}')
+    command.append(f'--outputDataCsv={run_dir}')
+    return command
+
+
+def run_job(job, binary, runs_root, status):
+    run_dir = os.path.join(runs_root, job['hash'])
+
+    # Start from an empty folder: a previous attempt may have left partial traces
+    if os.path.isdir(run_dir):
+        shutil.rmtree(run_dir)
+    os.makedirs(run_dir)
+    with open(os.path.join(run_dir, PARAMS_FILE), 'w') as f:
+        json.dump({'vars': job['vars'], 'params': job['params']}, f, indent=2, sort_keys=True)
+
+    command = command_line(binary, job['params'], run_dir)
+    status.write(job['hash'], 'started', command=command)
+    start = time.time()
+    with open(os.path.join(run_dir, LOG_FILE), 'w') as log:
+        returncode = subprocess.call(command, stdout=log, stderr=subprocess.STDOUT)
+    duration = time.time() - start
+
+    marker = DONE_FILE if returncode == 0 else FAILED_FILE
+    with open(os.path.join(run_dir, marker), 'w') as f:
+        json.dump({'returncode': returncode, 'duration_s': duration}, f)
+    status.write(job['hash'], 'done' if returncode == 0 else 'failed',
+                 returncode=returncode, duration_s=duration)
+    return returncode
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Run a CoE parameter sweep')
+    parser.add_argument('matrix', help='JSON matrix file')
+    parser.add_argument('-j', '--jobs', type=int, default=os.cpu_count(),
+                        help='concurrent runs (default: number of cores)')
+    parser.add_argument('--binary', help='CoE executable, overrides the matrix file')
+    parser.add_argument('--dry-run', action='store_true', help='list the pending runs and exit')
+    parser.add_argument('--retry-failed', action='store_true',
+                        help='run again the configurations that failed')
+    args = parser.parse_args()
+
+    with open(args.matrix) as f:
+        matrix = json.load(f)
+    binary = args.binary or matrix.get('binary')
+    if not binary:
+        sys.exit('No CoE executable: set "binary" in the matrix or pass --binary')
+    output_root = matrix.get('output_root') or os.path.splitext(args.matrix)[0]
+    runs_root = os.path.join(output_root, 'runs')
+    jobs = expand_matrix(matrix)
+
+    pending = []
+    skipped = 0
+    for job in jobs:
+        run_dir = os.path.join(runs_root, job['hash'])
+        if os.path.exists(os.path.join(run_dir, DONE_FILE)):
+            skipped += 1
+        elif os.path.exists(os.path.join(run_dir, FAILED_FILE)) and not args.retry_failed:
+            skipped += 1
+        else:
+            pending.append(job)
+
+    print(f'{len(jobs)} configurations, {skipped} already run, {len(pending)} to run '
+          f'on {args.jobs} cores')
+    if args.dry_run:
+        for job in pending:
+            print(job['hash'], ' '.join(command_line(binary, job['params'],
+                                                     os.path.join(runs_root, job['hash']))))
+        return
+
+    os.makedirs(runs_root, exist_ok=True)
+    write_index(jobs, os.path.join(output_root, 'index.csv'))
+    status = StatusLog(os.path.join(output_root, 'sweep_status.jsonl'))
+    failed = 0
+    completed = 0
+    with ThreadPoolExecutor(max_workers=args.jobs) as executor:
+        futures = {executor.submit(run_job, job, binary, runs_root, status): job for job in pending}
+        try:
+            for future in as_completed(futures):
+                completed += 1
+                job = futures[future]
+                returncode = future.result()
+                if returncode != 0:
+                    failed += 1
+                print(f'[{completed}/{len(pending)}] {job["hash"]} '
+                      f'{"done" if returncode == 0 else f"FAILED ({returncode})"}')
+        except KeyboardInterrupt:
+            # Runs in progress have no DONE marker and are repeated on resume
+            executor.shutdown(wait=False, cancel_futures=True)
+            sys.exit('Interrupted: launch the same command again to resume')
+
+    print(f'{completed - failed} done, {failed} failed, {skipped} skipped')
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
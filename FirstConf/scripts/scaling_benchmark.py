@@ -0,0 +1,294 @@
+"""
+Scaling Benchmark
+
+Measures how the cost of a CoE run grows with the scenario size, to predict
+the runtime of a sweep before launching it.
+
+run: runs CoE with --runStats=true over a fixed grid of nVehicles,
+nPedestrians, requestRate and simTime (one run at a time by default, so that
+the runs do not compete for the cores and memory bandwidth), then fits the
+cost model as the fit command does. Every grid point gets its own folder
+<output>/runs/v<nVehicles>_p<nPedestrians>_r<requestRate>_t<simTime>; points
+whose run_stats file exists are not run again, so an interrupted benchmark is
+resumed by launching the same command again.
+
+fit: reads the run_stats rows of the runs and writes
+    scaling_summary.csv  one row per run: wall-clock time of the setup and of
+                         the run, events executed, events per second, peak
+                         RSS, requests sent and completed
+    cost_model.json      power-law fit of every cost on the scenario size,
+                         cost = c * nVehicles^a * nPedestrians^b
+                                  * (1000 / requestRate)^d * simTime^e,
+                         by least squares on the logarithms, with its R^2 and
+                         its leave-one-out relative error
+and prints the summary table and the fitted models. Grid axes with a single
+value get no exponent.
+
+predict: evaluates the cost model at any configuration.
+
+Usage:
+    python scaling_benchmark.py run --binary PATH -o OUTPUT [--grid grid.json] [-j 1]
+        [--args "--radioModel=abstract --radioTable=table.csv"]
+    python scaling_benchmark.py fit OUTPUT
+    python scaling_benchmark.py predict OUTPUT/cost_model.json --nVehicles 200
+        --nPedestrians 50 --requestRate 20 --simTime 120
+"""
+import argparse
+import csv
+import glob
+import itertools
+import json
+import math
+import os
+import shlex
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor
+
+# Small enough to run in minutes with the NR model; a grid file can replace it
+DEFAULT_GRID = {
+    'nVehicles': [10, 20, 40],
+    'nPedestrians': [5, 10, 20],
+    'requestRate': [200, 100, 50],
+    'simTime': [5, 10],
+}
+AXES = ['nVehicles', 'nPedestrians', 'requestRate', 'simTime']
+STATS_COLUMNS = ['vehicles', 'pedestrians', 'request_interval_ms', 'sim_time_s', 'setup_wall_s',
+                 'run_wall_s', 'events', 'events_per_s', 'peak_rss_mb', 'requests',
+                 'completed_requests']
+COSTS = ['run_wall_s', 'setup_wall_s', 'events', 'peak_rss_mb']
+SIM_TYPE = 'scaling'
+LOG_FILE = 'log.txt'
+
+
+def run_name(point):
+    return 'v{nVehicles}_p{nPedestrians}_r{requestRate}_t{simTime}'.format(**point)
+
+
+def grid_points(grid):
+    for axis in grid:
+        if axis not in AXES:
+            sys.exit(f'Unknown grid axis {axis}, expected {", ".join(AXES)}')
+    values = [grid.get(axis, DEFAULT_GRID[axis]) for axis in AXES]
+    return [dict(zip(AXES, combination)) for combination in itertools.product(*values)]
+
+
+def stats_file(run_dir):
+    return os.path.join(run_dir, f'run_stats_{SIM_TYPE}.csv')
+
+
+def run_point(point, binary, extra_args, runs_root):
+    run_dir = os.path.join(runs_root, run_name(point))
+    os.makedirs(run_dir, exist_ok=True)
+    command = shlex.split(binary) + [f'--{axis}={point[axis]}' for axis in AXES]
+    command += shlex.split(extra_args)
+    command += ['--runStats=true', f'--simType={SIM_TYPE}', f'--outputDataCsv={run_dir}']
+    with open(os.path.join(run_dir, LOG_FILE), 'w') as log:
+        return subprocess.call(command, stdout=log, stderr=subprocess.STDOUT)
+
+
+def run(args):
+    grid = DEFAULT_GRID
+    if args.grid:
+        with open(args.grid) as f:
+            grid = json.load(f)
+    runs_root = os.path.join(args.output, 'runs')
+    points = grid_points(grid)
+    pending = [p for p in points if not os.path.exists(stats_file(os.path.join(runs_root, run_name(p))))]
+    print(f'{len(points)} grid points, {len(points) - len(pending)} already run, '
+          f'{len(pending)} to run on {args.jobs} cores')
+
+    failed = 0
+    with ThreadPoolExecutor(max_workers=args.jobs) as executor:
+        futures = [(p, executor.submit(run_point, p, args.binary, args.args, runs_root))
+                   for p in pending]
+        for k, (point, future) in enumerate(futures, 1):
+            returncode = future.result()
+            if returncode != 0:
+                failed += 1
+            print(f'[{k}/{len(pending)}] {run_name(point)} '
+                  f'{"done" if returncode == 0 else f"FAILED ({returncode})"}')
+
+    fit_folder(args.output)
+    if failed:
+        sys.exit(f'{failed} runs failed, see {LOG_FILE} in their folders')
+
+
+def read_stats(output):
+    rows = []
+    for path in sorted(glob.glob(os.path.join(output, 'runs', '*', f'run_stats_{SIM_TYPE}.csv'))):
+        with open(path, newline='') as f:
+            for row in csv.DictReader(f):
+                row = {column: float(row[column]) for column in STATS_COLUMNS}
+                row['run'] = os.path.basename(os.path.dirname(path))
+                rows.append(row)
+    return rows
+
+
+def features(vehicles, pedestrians, request_interval_ms, sim_time_s):
+    # Requests per pedestrian and second rather than the interval, so that every cost grows with it
+    return {
+        'nVehicles': vehicles,
+        'nPedestrians': pedestrians,
+        'requestRate': 1000.0 / request_interval_ms,
+        'simTime': sim_time_s,
+    }
+
+
+def row_features(row):
+    return features(row['vehicles'], row['pedestrians'], row['request_interval_ms'],
+                    row['sim_time_s'])
+
+
+def solve(matrix, vector):
+    """Solve a small linear system by Gaussian elimination with partial pivoting"""
+    n = len(vector)
+    a = [list(matrix[i]) + [vector[i]] for i in range(n)]
+    for col in range(n):
+        pivot = max(range(col, n), key=lambda r: abs(a[r][col]))
+        if abs(a[pivot][col]) < 1e-12:
+            raise ValueError('singular system')
+        a[col], a[pivot] = a[pivot], a[col]
+        for r in range(col + 1, n):
+            factor = a[r][col] / a[col][col]
+            for c in range(col, n + 1):
+                a[r][c] -= factor * a[col][c]
+    x = [0.0] * n
+    for r in range(n - 1, -1, -1):
+        x[r] = (a[r][n] - sum(a[r][c] * x[c] for c in range(r + 1, n))) / a[r][r]
+    return x
+
+
+def least_squares(xs, ys):
+    """Coefficients of y = x . beta, from the normal equations"""
+    n = len(xs[0])
+    normal = [[sum(x[i] * x[j] for x in xs) for j in range(n)] for i in range(n)]
+    rhs = [sum(x[i] * y for x, y in zip(xs, ys)) for i in range(n)]
+    return solve(normal, rhs)
+
+
+def fit_power_law(rows, cost, axes):
+    """log(cost) = log(c) + sum of exponent * log(axis), on the runs with a positive cost"""
+    samples = [(row_features(row), row[cost]) for row in rows if row[cost] > 0]
+    if len(samples) <= len(axes) + 1:
+        return None
+    xs = [[1.0] + [math.log(f[axis]) for axis in axes] for f, _ in samples]
+    ys = [math.log(y) for _, y in samples]
+    beta = least_squares(xs, ys)
+
+    mean = sum(ys) / len(ys)
+    residual = sum((y - sum(b * v for b, v in zip(beta, x))) ** 2 for x, y in zip(xs, ys))
+    total = sum((y - mean) ** 2 for y in ys)
+
+    # Leave-one-out: how well a configuration outside the grid is predicted
+    loo_errors = []
+    for k in range(len(xs)):
+        try:
+            loo_beta = least_squares(xs[:k] + xs[k + 1:], ys[:k] + ys[k + 1:])
+        except ValueError:
+            continue
+        predicted = math.exp(sum(b * v for b, v in zip(loo_beta, xs[k])))
+        loo_errors.append(abs(predicted / math.exp(ys[k]) - 1))
+
+    return {
+        'coefficient': math.exp(beta[0]),
+        'exponents': dict(zip(axes, beta[1:])),
+        'r2': 1 - residual / total if total > 0 else 1.0,
+        'loo_mean_rel_error': sum(loo_errors) / len(loo_errors) if loo_errors else None,
+        'loo_max_rel_error': max(loo_errors) if loo_errors else None,
+    }
+
+
+def predict(model, point):
+    f = features(point['nVehicles'], point['nPedestrians'], point['requestRate'], point['simTime'])
+    value = model['coefficient']
+    for axis, exponent in model['exponents'].items():
+        value *= f[axis] ** exponent
+    return value
+
+
+def print_table(rows):
+    columns = [('run', 'run', '{}'), ('setup_wall_s', 'setup s', '{:.2f}'),
+               ('run_wall_s', 'run s', '{:.2f}'), ('events', 'events', '{:.0f}'),
+               ('events_per_s', 'events/s', '{:.0f}'), ('peak_rss_mb', 'RSS MB', '{:.1f}'),
+               ('requests', 'requests', '{:.0f}'), ('completed_requests', 'completed', '{:.0f}')]
+    cells = [[header for _, header, _ in columns]]
+    cells += [[fmt.format(row[key]) for key, _, fmt in columns] for row in rows]
+    widths = [max(len(line[k]) for line in cells) for k in range(len(columns))]
+    for line in cells:
+        print('  '.join(cell.rjust(width) for cell, width in zip(line, widths)))
+
+
+def fit_folder(output):
+    rows = read_stats(output)
+    if not rows:
+        sys.exit(f'No run_stats_{SIM_TYPE}.csv under {output}/runs')
+
+    with open(os.path.join(output, 'scaling_summary.csv'), 'w', newline='') as f:
+        writer = csv.writer(f)
+        writer.writerow(['run'] + STATS_COLUMNS)
+        for row in rows:
+            writer.writerow([row['run']] + [row[column] for column in STATS_COLUMNS])
+    print_table(rows)
+
+    # Only the axes that vary over the runs can be fitted
+    axes = [axis for axis in AXES if len({row_features(row)[axis] for row in rows}) > 1]
+    models = {}
+    print(f'\nCost model, cost = c * product of axis^exponent (axes: {", ".join(axes)})')
+    for cost in COSTS:
+        try:
+            model = fit_power_law(rows, cost, axes)
+        except ValueError:
+            model = None
+        if model is None:
+            print(f'{cost:>14}: not enough runs to fit')
+            continue
+        models[cost] = model
+        exponents = ' '.join(f'{axis}^{e:.3f}' for axis, e in model['exponents'].items())
+        loo = model['loo_max_rel_error']
+        print(f'{cost:>14}: {model["coefficient"]:.4g} * {exponents}  R^2 {model["r2"]:.3f}'
+              + (f', leave-one-out error mean {100 * model["loo_mean_rel_error"]:.1f}% '
+                 f'max {100 * loo:.1f}%' if loo is not None else ''))
+
+    with open(os.path.join(output, 'cost_model.json'), 'w') as f:
+        json.dump({'requestRate': 'fitted on requests per pedestrian and second, 1000 / requestRate',
+                   'runs': len(rows), 'models': models}, f, indent=2)
+    print(f'\nWritten {os.path.join(output, "scaling_summary.csv")} and '
+          f'{os.path.join(output, "cost_model.json")}')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Scaling benchmark of CoE runs')
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    run_parser = sub.add_parser('run', help='run the grid and fit the cost model')
+    run_parser.add_argument('--binary', required=True, help='CoE executable')
+    run_parser.add_argument('-o', '--output', required=True, help='output folder')
+    run_parser.add_argument('--grid', help='JSON object of axis value lists, overriding the default grid')
+    run_parser.add_argument('-j', '--jobs', type=int, default=1,
+                            help='concurrent runs (default 1, for undisturbed timings)')
+    run_parser.add_argument('--args', default='', help='extra CoE arguments for every run')
+
+    fit_parser = sub.add_parser('fit', help='fit the cost model on the runs of an output folder')
+    fit_parser.add_argument('output', help='output folder of a run command')
+
+    predict_parser = sub.add_parser('predict', help='predict the cost of a configuration')
+    predict_parser.add_argument('model', help='cost_model.json')
+    for axis in AXES:
+        predict_parser.add_argument(f'--{axis}', type=float, required=True)
+
+    args = parser.parse_args()
+    if args.command == 'run':
+        run(args)
+    elif args.command == 'fit':
+        fit_folder(args.output)
+    else:
+        with open(args.model) as f:
+            models = json.load(f)['models']
+        point = {axis: getattr(args, axis) for axis in AXES}
+        for cost, model in models.items():
+            print(f'{cost:>14}: {predict(model, point):.4g}')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,168 @@
+"""
+Steady-State Estimation
+
+Estimates the steady-state mean offloading time of a single long run, in
+place of independent replications:
+    warm-up      the start-up transient (empty queues, vehicles joining the
+                 neighbor table, RRC attachment) is detected with MSER-5 on
+                 the offloading times of all the tiers, in request creation
+                 order: the series is averaged in batches of 5 and truncated
+                 at the batch that minimizes the standard error of the mean
+                 of the remaining batches (searched over the first half). The
+                 requests created before the truncation time are discarded
+                 in every tier.
+    batch means  the remaining requests of each tier are split into
+                 --batches (20) consecutive batches, whose means are treated
+                 as independent: mean +- t * s / sqrt(batches). The lag-1
+                 autocorrelation of the batch means is reported; above
+                 2 / sqrt(batches), its approximate 95% bound under
+                 independence, the batches are too short for the run and the
+                 interval is optimistic (run longer or use fewer batches).
+
+Writes steady_state.csv in every run folder (or -o for a single run) and
+prints a table per run. Reads CSV or binary offloading_time_ traces.
+
+Usage:
+    python steady_state.py RUN [RUN ...] [--batches 20] [--confidence 0.95] [-o steady_state.csv]
+"""
+import argparse
+import csv
+import math
+import os
+import statistics
+import sys
+from collections import defaultdict
+
+from trace_utils import OFFLOADING_COLUMNS, TIERS, read_trace, t_quantile
+
+MSER_BATCH = 5
+OUTPUT_COLUMNS = ['tier', 'requests', 'warmup_requests', 'warmup_s', 'kept_requests', 'mean_ms',
+                  'half_width_ms', 'relative_half_width', 'batches', 'batch_size',
+                  'lag1_autocorrelation', 'confidence']
+
+
+def mser_truncation(values, batch=MSER_BATCH):
+    """Number of leading values to discard, by MSER on the means of consecutive batches"""
+    means = [statistics.fmean(values[i:i + batch])
+             for i in range(0, len(values) - batch + 1, batch)]
+    n = len(means)
+    if n < 4:
+        return 0
+
+    # Suffix sums give the variance of every tail in O(n)
+    suffix_sum = [0.0] * (n + 1)
+    suffix_squares = [0.0] * (n + 1)
+    for i in range(n - 1, -1, -1):
+        suffix_sum[i] = suffix_sum[i + 1] + means[i]
+        suffix_squares[i] = suffix_squares[i + 1] + means[i] * means[i]
+
+    best, best_d = math.inf, 0
+    for d in range(n // 2 + 1):
+        m = n - d
+        squared_deviations = suffix_squares[d] - suffix_sum[d] ** 2 / m
+        statistic = squared_deviations / (m * m)
+        if statistic < best:
+            best, best_d = statistic, d
+    return best_d * batch
+
+
+def lag1_autocorrelation(values):
+    mean = statistics.fmean(values)
+    variance = sum((v - mean) ** 2 for v in values)
+    if variance == 0:
+        return 0.0
+    return sum((values[i] - mean) * (values[i + 1] - mean)
+               for i in range(len(values) - 1)) / variance
+
+
+def batch_means(values, batches, confidence):
+    """Mean, half-width, batch size and lag-1 autocorrelation of the batch means"""
+    size = len(values) // batches
+    if batches < 2 or size == 0:
+        return statistics.fmean(values) if values else math.nan, math.nan, 0, math.nan
+    # The remainder goes to no batch: the batches cover the same span of the run
+    means = [statistics.fmean(values[b * size:(b + 1) * size]) for b in range(batches)]
+    grand_mean = statistics.fmean(means)
+    half_width = t_quantile(confidence, batches - 1) * statistics.stdev(means) / math.sqrt(batches)
+    return grand_mean, half_width, size, lag1_autocorrelation(means)
+
+
+def analyze(run_dir, batches, confidence):
+    rows = read_trace(run_dir, 'offloading_time_', OFFLOADING_COLUMNS)
+    rows.sort(key=lambda r: r['initial_time_ns'])
+    if not rows:
+        return [], 0.0
+
+    # Warm-up of the whole system, from the requests of all the tiers
+    all_times = [(r['time_ns'] - r['initial_time_ns']) * 1e-6 for r in rows]
+    truncation = mser_truncation(all_times)
+    cut_ns = rows[truncation]['initial_time_ns'] if truncation < len(rows) else math.inf
+    warmup_s = (cut_ns - rows[0]['initial_time_ns']) * 1e-9 if truncation else 0.0
+
+    by_tier = defaultdict(list)
+    for r in rows:
+        by_tier[int(r['where'])].append(r)
+
+    results = []
+    for name, tier_rows in [('all', rows)] + [(TIERS.get(w, str(w)), by_tier[w]) for w in sorted(by_tier)]:
+        kept = [(r['time_ns'] - r['initial_time_ns']) * 1e-6 for r in tier_rows
+                if r['initial_time_ns'] >= cut_ns]
+        mean, half_width, size, rho = batch_means(kept, batches, confidence)
+        results.append({
+            'tier': name,
+            'requests': len(tier_rows),
+            'warmup_requests': len(tier_rows) - len(kept),
+            'warmup_s': warmup_s,
+            'kept_requests': len(kept),
+            'mean_ms': mean,
+            'half_width_ms': half_width,
+            'relative_half_width': half_width / mean if mean else math.nan,
+            'batches': batches if size else 0,
+            'batch_size': size,
+            'lag1_autocorrelation': rho,
+            'confidence': confidence,
+        })
+    return results, warmup_s
+
+
+def print_results(run_dir, results, warmup_s):
+    print(f'\n{run_dir}: warm-up {warmup_s:.2f} s')
+    print(f'{"tier":>6} {"requests":>9} {"warm-up":>8} {"kept":>8} {"mean":>9} {"+-":>8} '
+          f'{"rel":>7} {"batch":>6} {"rho1":>6}   (ms)')
+    for r in results:
+        correlated = r['batches'] and r['lag1_autocorrelation'] > 2 / math.sqrt(r['batches'])
+        warning = '  batches correlated' if correlated else ''
+        print(f'{r["tier"]:>6} {r["requests"]:>9} {r["warmup_requests"]:>8} {r["kept_requests"]:>8} '
+              f'{r["mean_ms"]:>9.3f} {r["half_width_ms"]:>8.3f} {100 * r["relative_half_width"]:>6.1f}% '
+              f'{r["batch_size"]:>6} {r["lag1_autocorrelation"]:>6.2f}{warning}')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='MSER warm-up truncation and batch-means '
+                                                 'confidence intervals of the offloading time')
+    parser.add_argument('runs', nargs='+', help='run folders')
+    parser.add_argument('--batches', type=int, default=20, help='number of batches (default 20)')
+    parser.add_argument('--confidence', type=float, default=0.95, help='confidence level (default 0.95)')
+    parser.add_argument('-o', '--output', help='output file, for a single run '
+                                               '(default: steady_state.csv in every run folder)')
+    args = parser.parse_args()
+    if args.output and len(args.runs) > 1:
+        sys.exit('-o is only available with a single run')
+    if args.batches < 2:
+        sys.exit('At least two batches are needed')
+
+    for run_dir in args.runs:
+        results, warmup_s = analyze(run_dir, args.batches, args.confidence)
+        if not results:
+            print(f'\n{run_dir}: no offloading_time_ rows')
+            continue
+        print_results(run_dir, results, warmup_s)
+        output = args.output or os.path.join(run_dir, 'steady_state.csv')
+        with open(output, 'w', newline='') as f:
+            writer = csv.DictWriter(f, fieldnames=OUTPUT_COLUMNS)
+            writer.writeheader()
+            writer.writerows(results)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,116 @@
+"""
+Trace Utilities
+
+Readers and statistics shared by the analysis scripts: columns or rows of
+the CSV or binary (--traceFormat=binary, one .npy file per column) traces of
+a run folder, offloading times per tier, run duration of a sweep run,
+percentiles and Student t quantiles.
+
+Binary traces are read as memory-mapped numpy arrays and reduced column-wise;
+numpy is only needed for them.
+"""
+import csv
+import glob
+import json
+import math
+import os
+import statistics
+from collections import defaultdict
+
+OFFLOADING_COLUMNS = ['node_id', 'packet_size', 'initial_time_ns', 'time_ns', 'where']
+TIERS = {0: 'Edge', 1: 'Cloud', 2: 'VCC'}
+
+
+def parse_time_ns(value):
+    # TRACE_FIELD_TIME is written like ns3::Time, "+<value>ns"
+    return int(value.rstrip('ns').lstrip('+'))
+
+
+def read_csv_rows(path, columns):
+    rows = []
+    with open(path) as f:
+        for values in csv.reader(f):
+            row = dict(zip(columns, values))
+            for c in columns:
+                if c.endswith('_ns') and c != 'time_ns':
+                    row[c] = parse_time_ns(row[c])
+                elif c == 'time_ns':
+                    row[c] = int(round(float(row[c]) * 1e9))
+                elif c != 'direction':
+                    row[c] = float(row[c])
+            rows.append(row)
+    return rows
+
+
+def read_columns(run_dir, prefix, columns):
+    """Columns of a CSV or binary trace of a run folder, times in ns: numpy arrays
+    (memory-mapped for a single trace folder) if the trace is binary, else lists.
+    The columns are the leading ones of the trace, in order, as CSV rows are positional"""
+    paths = [p for p in sorted(glob.glob(os.path.join(run_dir, prefix + '*')))
+             if os.path.isdir(p) or p.endswith('.csv')]
+    if paths and all(os.path.isdir(p) for p in paths):
+        import numpy as np
+        parts = [{c: np.load(os.path.join(p, c + '.npy'), mmap_mode='r') for c in columns} for p in paths]
+        if len(parts) == 1:
+            return parts[0]
+        return {c: np.concatenate([part[c] for part in parts]) for c in columns}
+
+    data = {c: [] for c in columns}
+    for path in paths:
+        if os.path.isdir(path):
+            import numpy as np
+            for c in columns:
+                data[c].extend(np.load(os.path.join(path, c + '.npy'), mmap_mode='r').tolist())
+        else:
+            for row in read_csv_rows(path, columns):
+                for c in columns:
+                    data[c].append(row[c])
+    return data
+
+
+def read_trace(run_dir, prefix, columns):
+    """Rows of a CSV or binary trace of a run folder, as dicts with times in ns"""
+    data = read_columns(run_dir, prefix, columns)
+    # Whole columns are converted at once, not element by element from the maps
+    values = [data[c].tolist() if hasattr(data[c], 'tolist') else data[c] for c in columns]
+    rows = [dict(zip(columns, row)) for row in zip(*values)]
+    if 'direction' in columns:
+        for row in rows:
+            if isinstance(row['direction'], bytes):
+                row['direction'] = row['direction'].decode().rstrip('\0')
+    return rows
+
+
+def percentile(values, p):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(math.ceil(p / 100.0 * len(values))) - 1)]
+
+
+def offloading_times(run_dir):
+    """Offloading times (ms) of the completed requests, per tier"""
+    data = read_columns(run_dir, 'offloading_time_', OFFLOADING_COLUMNS)
+    times = defaultdict(list)
+    if hasattr(data['where'], 'dtype'):
+        import numpy as np
+        ms = (data['time_ns'] - data['initial_time_ns']) * 1e-6
+        for where in np.unique(data['where']):
+            times[int(where)] = ms[data['where'] == where].tolist()
+        return times
+    for initial, final, where in zip(data['initial_time_ns'], data['time_ns'], data['where']):
+        times[int(where)].append((final - initial) * 1e-6)
+    return times
+
+
+def run_duration(run_dir):
+    try:
+        with open(os.path.join(run_dir, 'DONE')) as f:
+            return json.load(f)['duration_s']
+    except (OSError, ValueError, KeyError):
+        return None
+
+
+def t_quantile(confidence, df):
+    """Two-sided Student t quantile, Cornish-Fisher expansion around the normal one"""
+    z = statistics.NormalDist().inv_cdf(0.5 + confidence / 2)
+    return (z + (z ** 3 + z) / (4 * df) + (5 * z ** 5 + 16 * z ** 3 + 3 * z) / (96 * df ** 2)
+            + (3 * z ** 7 + 19 * z ** 5 + 17 * z ** 3 - 15 * z) / (384 * df ** 3))
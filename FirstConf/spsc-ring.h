@@ -0,0 +1,111 @@
+/**
+ * SpscRing - Bounded lock-free single-producer/single-consumer ring buffer
+ *
+ * Used to hand fixed-size trace records from the ns-3 event thread to the
+ * background trace writer thread. Exactly one thread may call TryPush and
+ * exactly one (other) thread may call TryPop.
+ */
+
+#ifndef NS3_SPSC_RING_H
+#define NS3_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Bounded lock-free ring for one producer and one consumer thread
+ *
+ * The capacity is rounded up to a power of two. Head and tail counters live
+ * on separate cache lines, and each side caches the other side's counter so
+ * that the shared atomics are only read when the ring looks full or empty.
+ */
+template <typename T>
+class SpscRing
+{
+public:
+  /**
+   * \brief Create a ring
+   * \param capacity Minimum number of elements the ring can hold
+   */
+  explicit SpscRing(size_t capacity)
+    : m_head(0),
+      m_cachedTail(0),
+      m_tail(0),
+      m_cachedHead(0)
+  {
+    size_t size = 2;
+    while (size < capacity)
+    {
+      size <<= 1;
+    }
+    m_slots.resize(size);
+    m_mask = size - 1;
+  }
+
+  /**
+   * \brief Append an element (producer side)
+   * \param value Element to copy into the ring
+   * \return false if the ring is full
+   */
+  bool TryPush(const T& value)
+  {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_cachedHead > m_mask)
+    {
+      m_cachedHead = m_head.load(std::memory_order_acquire);
+      if (tail - m_cachedHead > m_mask)
+      {
+        return false;
+      }
+    }
+    m_slots[tail & m_mask] = value;
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * \brief Remove the oldest element (consumer side)
+   * \param value Receives the element
+   * \return false if the ring is empty
+   */
+  bool TryPop(T& value)
+  {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_cachedTail)
+    {
+      m_cachedTail = m_tail.load(std::memory_order_acquire);
+      if (head == m_cachedTail)
+      {
+        return false;
+      }
+    }
+    value = m_slots[head & m_mask];
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * \return The number of elements the ring can hold
+   */
+  size_t GetCapacity() const
+  {
+    return m_mask + 1;
+  }
+
+private:
+  std::vector<T> m_slots;                 ///< Element storage
+  size_t m_mask;                          ///< Capacity - 1
+
+  alignas(64) std::atomic<size_t> m_head; ///< Next slot to read (consumer)
+  size_t m_cachedTail;                    ///< Consumer copy of m_tail
+
+  alignas(64) std::atomic<size_t> m_tail; ///< Next slot to write (producer)
+  size_t m_cachedHead;                    ///< Producer copy of m_head
+};
+
+} // namespace ns3
+
+#endif // NS3_SPSC_RING_H
@@ -0,0 +1,301 @@
+/**
+ * Implementation of the task registry
+ */
+
+#include "ns3/assert.h"
+
+#include "task-registry.h"
+#include "trace-sink.h"
+
+namespace ns3 {
+
+std::vector<uint32_t> TaskRegistry::s_nodeId;
+std::vector<uint32_t> TaskRegistry::s_pedestrianIp;
+std::vector<int64_t> TaskRegistry::s_initial;
+std::vector<int64_t> TaskRegistry::s_dispatch;
+std::vector<int64_t> TaskRegistry::s_uplink;
+std::vector<int64_t> TaskRegistry::s_queueing;
+std::vector<int64_t> TaskRegistry::s_elaboration;
+std::vector<int64_t> TaskRegistry::s_final;
+std::vector<double> TaskRegistry::s_workload;
+std::vector<double> TaskRegistry::s_tierDraw;
+std::vector<double> TaskRegistry::s_vehicleDraw;
+std::vector<uint32_t> TaskRegistry::s_carsInVcc;
+std::vector<uint8_t> TaskRegistry::s_where;
+std::vector<uint8_t> TaskRegistry::s_fromVcc;
+std::vector<uint8_t> TaskRegistry::s_status;
+
+namespace {
+
+const char*
+GetStatusName(uint8_t status)
+{
+  static const char* const names[] = {"pending", "completed", "rejected", "dropped"};
+  return names[status];
+}
+
+} // namespace
+
+uint32_t
+TaskRegistry::Create(uint32_t nodeId, double workload, Time initialTime)
+{
+  uint32_t task = s_nodeId.size();
+  s_nodeId.push_back(nodeId);
+  s_pedestrianIp.push_back(0);
+  s_initial.push_back(initialTime.GetNanoSeconds());
+  s_dispatch.push_back(0);
+  s_uplink.push_back(0);
+  s_queueing.push_back(0);
+  s_elaboration.push_back(0);
+  s_final.push_back(0);
+  s_workload.push_back(workload);
+  s_tierDraw.push_back(0);
+  s_vehicleDraw.push_back(0);
+  s_carsInVcc.push_back(0);
+  s_where.push_back(0);
+  s_fromVcc.push_back(0);
+  s_status.push_back(TASK_PENDING);
+  return task;
+}
+
+uint32_t
+TaskRegistry::GetN()
+{
+  return s_nodeId.size();
+}
+
+void
+TaskRegistry::Clear()
+{
+  for (auto* v : {&s_nodeId, &s_pedestrianIp, &s_carsInVcc})
+  {
+    v->clear();
+  }
+  for (auto* v : {&s_initial, &s_dispatch, &s_uplink, &s_queueing, &s_elaboration, &s_final})
+  {
+    v->clear();
+  }
+  for (auto* v : {&s_where, &s_fromVcc, &s_status})
+  {
+    v->clear();
+  }
+  for (auto* v : {&s_workload, &s_tierDraw, &s_vehicleDraw})
+  {
+    v->clear();
+  }
+}
+
+void
+TaskRegistry::Write()
+{
+  for (uint32_t task = 0; task < GetN(); task++)
+  {
+    TraceRecord record(TRACE_TASKS);
+    record.AddUint(task)
+          .AddUint(s_nodeId[task])
+          .AddText(GetStatusName(s_status[task]))
+          .AddUint(s_where[task])
+          .AddUint(s_fromVcc[task])
+          .AddTime(NanoSeconds(s_initial[task]))
+          .AddTime(NanoSeconds(s_uplink[task]))
+          .AddTime(NanoSeconds(s_queueing[task]))
+          .AddTime(NanoSeconds(s_elaboration[task]))
+          .AddTime(NanoSeconds(s_final[task]))
+          .AddDouble(s_workload[task])
+          .AddUint(s_carsInVcc[task]);
+    TraceSinkRegistry::Write(record);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Accessor methods
+//------------------------------------------------------------------------------
+
+uint32_t
+TaskRegistry::GetNodeId(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return s_nodeId[task];
+}
+
+Ipv4Address
+TaskRegistry::GetSourcePedestrianIPv4Address(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return Ipv4Address(s_pedestrianIp[task]);
+}
+
+Time
+TaskRegistry::GetInitialTime(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return NanoSeconds(s_initial[task]);
+}
+
+Time
+TaskRegistry::GetDispatchTime(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return NanoSeconds(s_dispatch[task]);
+}
+
+Time
+TaskRegistry::GetUplinkTime(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return NanoSeconds(s_uplink[task]);
+}
+
+Time
+TaskRegistry::GetQueueingTime(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return NanoSeconds(s_queueing[task]);
+}
+
+Time
+TaskRegistry::GetElaborationTime(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return NanoSeconds(s_elaboration[task]);
+}
+
+Time
+TaskRegistry::GetFinalTime(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return NanoSeconds(s_final[task]);
+}
+
+double
+TaskRegistry::GetWorkload(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return s_workload[task];
+}
+
+double
+TaskRegistry::GetTierDraw(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return s_tierDraw[task];
+}
+
+double
+TaskRegistry::GetVehicleDraw(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return s_vehicleDraw[task];
+}
+
+uint32_t
+TaskRegistry::GetWhere(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return s_where[task];
+}
+
+uint32_t
+TaskRegistry::GetCarsInVCC(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return s_carsInVcc[task];
+}
+
+uint32_t
+TaskRegistry::GetIsFromVCCToPed(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return s_fromVcc[task];
+}
+
+TaskStatus
+TaskRegistry::GetStatus(uint32_t task)
+{
+  NS_ASSERT(task < GetN());
+  return static_cast<TaskStatus>(s_status[task]);
+}
+
+//------------------------------------------------------------------------------
+// Mutator methods
+//------------------------------------------------------------------------------
+
+void
+TaskRegistry::SetSourcePedestrianIPv4Address(uint32_t task, Ipv4Address pedestrianIp)
+{
+  NS_ASSERT(task < GetN());
+  s_pedestrianIp[task] = pedestrianIp.Get();
+}
+
+void
+TaskRegistry::SetDispatchTime(uint32_t task, Time dispatchTime)
+{
+  NS_ASSERT(task < GetN());
+  s_dispatch[task] = dispatchTime.GetNanoSeconds();
+}
+
+void
+TaskRegistry::SetUplinkTime(uint32_t task, Time uplinkTime)
+{
+  NS_ASSERT(task < GetN());
+  s_uplink[task] = uplinkTime.GetNanoSeconds();
+}
+
+void
+TaskRegistry::SetQueueingTime(uint32_t task, Time queueingTime)
+{
+  NS_ASSERT(task < GetN());
+  s_queueing[task] = queueingTime.GetNanoSeconds();
+}
+
+void
+TaskRegistry::SetElaborationTime(uint32_t task, Time elaborationTime)
+{
+  NS_ASSERT(task < GetN());
+  s_elaboration[task] = elaborationTime.GetNanoSeconds();
+}
+
+void
+TaskRegistry::SetFinalTime(uint32_t task, Time finalTime)
+{
+  NS_ASSERT(task < GetN());
+  s_final[task] = finalTime.GetNanoSeconds();
+}
+
+void
+TaskRegistry::SetWhere(uint32_t task, uint32_t where)
+{
+  NS_ASSERT(task < GetN());
+  s_where[task] = where;
+}
+
+void
+TaskRegistry::SetCarsInVCC(uint32_t task, uint32_t carsInVCC)
+{
+  NS_ASSERT(task < GetN());
+  s_carsInVcc[task] = carsInVCC;
+}
+
+void
+TaskRegistry::SetIsFromVCCToPed(uint32_t task, uint32_t isFromVCCToPed)
+{
+  NS_ASSERT(task < GetN());
+  s_fromVcc[task] = isFromVCCToPed;
+}
+
+void
+TaskRegistry::SetStatus(uint32_t task, TaskStatus status)
+{
+  NS_ASSERT(task < GetN());
+  s_status[task] = status;
+}
+
+void
+TaskRegistry::SetDraws(uint32_t task, double tierDraw, double vehicleDraw)
+{
+  NS_ASSERT(task < GetN());
+  s_tierDraw[task] = tierDraw;
+  s_vehicleDraw[task] = vehicleDraw;
+}
+
+} // namespace ns3
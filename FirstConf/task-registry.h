@@ -0,0 +1,127 @@
+/**
+ * TaskRegistry - Lifecycle records of all offloading requests
+ *
+ * Every request gets a 32-bit task ID when the pedestrian sends it; only
+ * this ID travels in the packets (PacketDataTag), and every component
+ * records its timestamps and decisions here. Records are kept as
+ * struct-of-arrays indexed by task ID, so lost requests keep their record
+ * and the end-of-run dump (tasks_<simType>, one row per request) is a
+ * single contiguous scan.
+ */
+
+#ifndef NS3_TASK_REGISTRY_H
+#define NS3_TASK_REGISTRY_H
+
+#include "ns3/nstime.h"
+#include "ns3/ipv4-address.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Outcome of a request
+ */
+enum TaskStatus : uint8_t
+{
+  TASK_PENDING = 0,     ///< Sent, no response yet (lost if still pending at the end)
+  TASK_COMPLETED,       ///< Response received by the pedestrian
+  TASK_REJECTED,        ///< Rejected by a vehicle with a full queue
+  TASK_DROPPED          ///< Dropped by a full edge or cloud queue
+};
+
+/**
+ * \brief Simulation-wide struct-of-arrays registry of the requests
+ */
+class TaskRegistry
+{
+public:
+  /**
+   * \brief Register a new request
+   *
+   * \param nodeId Pedestrian node sending the request
+   * \param workload Task workload in millions of instructions
+   * \param initialTime Time the request is sent
+   * \return The task ID
+   */
+  static uint32_t Create(uint32_t nodeId, double workload, Time initialTime);
+
+  /**
+   * \return Number of registered requests
+   */
+  static uint32_t GetN();
+
+  /**
+   * \brief Forget all requests (task IDs restart from 0)
+   */
+  static void Clear();
+
+  /**
+   * \brief Write one tasks_ trace row per request, in task ID order
+   */
+  static void Write();
+
+  // Accessors, by task ID
+  static uint32_t GetNodeId(uint32_t task);
+  static Ipv4Address GetSourcePedestrianIPv4Address(uint32_t task);
+  static Time GetInitialTime(uint32_t task);
+  static Time GetDispatchTime(uint32_t task);
+  static Time GetUplinkTime(uint32_t task);
+  static Time GetQueueingTime(uint32_t task);
+  static Time GetElaborationTime(uint32_t task);
+  static Time GetFinalTime(uint32_t task);
+  static double GetWorkload(uint32_t task);
+  static double GetTierDraw(uint32_t task);
+  static double GetVehicleDraw(uint32_t task);
+  static uint32_t GetWhere(uint32_t task);
+  static uint32_t GetCarsInVCC(uint32_t task);
+  static uint32_t GetIsFromVCCToPed(uint32_t task);
+  static TaskStatus GetStatus(uint32_t task);
+
+  // Mutators, by task ID
+  static void SetSourcePedestrianIPv4Address(uint32_t task, Ipv4Address pedestrianIp);
+  static void SetDispatchTime(uint32_t task, Time dispatchTime);
+  static void SetUplinkTime(uint32_t task, Time uplinkTime);
+  static void SetQueueingTime(uint32_t task, Time queueingTime);
+  static void SetElaborationTime(uint32_t task, Time elaborationTime);
+  static void SetFinalTime(uint32_t task, Time finalTime);
+  static void SetWhere(uint32_t task, uint32_t where);
+  static void SetCarsInVCC(uint32_t task, uint32_t carsInVCC);
+  static void SetIsFromVCCToPed(uint32_t task, uint32_t isFromVCCToPed);
+  static void SetStatus(uint32_t task, TaskStatus status);
+
+  /**
+   * \brief Set the uniform draws of the random choices made for the request
+   *
+   * Drawn by the pedestrian from its own stream when the request is created,
+   * so that a request gets the same draws whatever the strategy and the order
+   * in which the edge receives the requests (common random numbers).
+   *
+   * \param task The task
+   * \param tierDraw Draw in [0, 1) of the random tier choice
+   * \param vehicleDraw Draw in [0, 1) of the random vehicle choice
+   */
+  static void SetDraws(uint32_t task, double tierDraw, double vehicleDraw);
+
+private:
+  static std::vector<uint32_t> s_nodeId;         ///< Pedestrian node
+  static std::vector<uint32_t> s_pedestrianIp;   ///< Pedestrian address seen by the edge
+  static std::vector<int64_t> s_initial;         ///< Request sent (ns)
+  static std::vector<int64_t> s_dispatch;        ///< Offloaded to a vehicle by the edge (ns), not in the trace
+  static std::vector<int64_t> s_uplink;          ///< Arrival at the processing node (ns)
+  static std::vector<int64_t> s_queueing;        ///< Start of the elaboration (ns)
+  static std::vector<int64_t> s_elaboration;     ///< Elaboration duration (ns)
+  static std::vector<int64_t> s_final;           ///< Response received (ns)
+  static std::vector<double> s_workload;         ///< Millions of instructions
+  static std::vector<double> s_tierDraw;         ///< Uniform draw of the random tier choice
+  static std::vector<double> s_vehicleDraw;      ///< Uniform draw of the random vehicle choice
+  static std::vector<uint32_t> s_carsInVcc;      ///< Vehicles available when the edge received it
+  static std::vector<uint8_t> s_where;           ///< 0=Edge, 1=Cloud, 2=VCC
+  static std::vector<uint8_t> s_fromVcc;         ///< Response sent by a vehicle
+  static std::vector<uint8_t> s_status;          ///< TaskStatus
+};
+
+} // namespace ns3
+
+#endif // NS3_TASK_REGISTRY_H
@@ -0,0 +1,359 @@
+/**
+ * Implementation of the binary columnar trace output
+ *
+ * Each column is a NumPy .npy v1.0 file: a 128-byte header followed by the
+ * raw little-endian values. The header is written with a zero row count when
+ * the file is created and rewritten with the final count on Close(). As the
+ * CSV traces, the files of a previous run in the same folder are appended to:
+ * their header gives the rows to keep and the new rows follow them.
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/system-path.h"
+
+#include "trace-columnar.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("ColumnarTraceFile");
+
+namespace {
+
+/// Total size of the .npy header, keeps the data 64-byte aligned
+const uint32_t NPY_HEADER_SIZE = 128;
+
+/// Values buffered per column before they are written
+const size_t COLUMN_BUFFER_SIZE = 64 * 1024;
+
+/// Columns shared by the offloading time and gNB response traces
+const TraceColumn OFFLOADING_COLUMNS[] = {
+  {"node_id", TRACE_FIELD_UINT},
+  {"packet_size", TRACE_FIELD_UINT},
+  {"initial_time_ns", TRACE_FIELD_TIME},
+  {"time_ns", TRACE_FIELD_SECONDS},
+  {"where", TRACE_FIELD_UINT},
+  {"request_rate", TRACE_FIELD_DOUBLE},
+  {"cars_number", TRACE_FIELD_UINT},
+  {"pedestrians_number", TRACE_FIELD_UINT},
+  {"uplink_time_ns", TRACE_FIELD_TIME},
+  {"elaboration_time_ns", TRACE_FIELD_TIME},
+  {"edge_computation_capacity", TRACE_FIELD_DOUBLE},
+  {"car_computation_capacity", TRACE_FIELD_DOUBLE},
+  {"queueing_time_ns", TRACE_FIELD_TIME},
+  {"workload", TRACE_FIELD_DOUBLE},
+  {"cars_in_vcc", TRACE_FIELD_UINT},
+  {"vehicle_queue_length", TRACE_FIELD_UINT}
+};
+
+/// Columns of the sent/received/rejected packets traces of each tier
+const TraceColumn PACKET_COLUMNS[] = {
+  {"node_id", TRACE_FIELD_UINT},
+  {"packet_size", TRACE_FIELD_UINT},
+  {"initial_time_ns", TRACE_FIELD_TIME},
+  {"time_ns", TRACE_FIELD_SECONDS},
+  {"where", TRACE_FIELD_UINT},
+  {"request_rate", TRACE_FIELD_DOUBLE},
+  {"cars_number", TRACE_FIELD_UINT},
+  {"pedestrians_number", TRACE_FIELD_UINT},
+  {"edge_computation_capacity", TRACE_FIELD_DOUBLE},
+  {"car_computation_capacity", TRACE_FIELD_DOUBLE},
+  {"workload", TRACE_FIELD_DOUBLE},
+  {"cars_in_vcc", TRACE_FIELD_UINT},
+  {"vehicle_queue_length", TRACE_FIELD_UINT}
+};
+
+const TraceColumn SENT_COLUMNS[] = {
+  {"node_id", TRACE_FIELD_UINT},
+  {"time_ns", TRACE_FIELD_SECONDS}
+};
+
+const TraceColumn BEACON_COLUMNS[] = {
+  {"node_id", TRACE_FIELD_UINT},
+  {"packet_size", TRACE_FIELD_UINT},
+  {"position_x", TRACE_FIELD_DOUBLE},
+  {"position_y", TRACE_FIELD_POSITION},
+  {"position_z", TRACE_FIELD_POSITION},
+  {"time_ns", TRACE_FIELD_SECONDS},
+  {"queue_state", TRACE_FIELD_UINT},
+  {"request_rate", TRACE_FIELD_DOUBLE},
+  {"cars_number", TRACE_FIELD_UINT},
+  {"pedestrians_number", TRACE_FIELD_UINT},
+  {"edge_computation_capacity", TRACE_FIELD_DOUBLE},
+  {"car_computation_capacity", TRACE_FIELD_DOUBLE},
+  {"queue_max_packets", TRACE_FIELD_UINT},
+  {"vehicle_queue_length", TRACE_FIELD_UINT}
+};
+
+const TraceColumn DWELL_TIME_COLUMNS[] = {
+  {"node_id", TRACE_FIELD_UINT},
+  {"cars_number", TRACE_FIELD_UINT},
+  {"address", TRACE_FIELD_ADDRESS},
+  {"time_ns", TRACE_FIELD_TIME},
+  {"event", TRACE_FIELD_TEXT},
+  {"reason", TRACE_FIELD_TEXT},
+  {"position_x", TRACE_FIELD_DOUBLE},
+  {"position_y", TRACE_FIELD_POSITION},
+  {"position_z", TRACE_FIELD_POSITION}
+};
+
+const TraceColumn SINR_COLUMNS[] = {
+  {"node_id", TRACE_FIELD_UINT},
+  {"cell_id", TRACE_FIELD_UINT},
+  {"rnti", TRACE_FIELD_UINT},
+  {"sinr_db", TRACE_FIELD_DOUBLE},
+  {"bwp_id", TRACE_FIELD_UINT},
+  {"unused", TRACE_FIELD_TEXT},
+  {"stream_id", TRACE_FIELD_UINT},
+  {"time_ns", TRACE_FIELD_SECONDS}
+};
+
+const TraceColumn RADIO_PROBE_COLUMNS[] = {
+  {"direction", TRACE_FIELD_TEXT},
+  {"node_id", TRACE_FIELD_UINT},
+  {"distance_m", TRACE_FIELD_DOUBLE},
+  {"load_pps", TRACE_FIELD_DOUBLE},
+  {"mcs", TRACE_FIELD_UINT},
+  {"packet_size", TRACE_FIELD_UINT},
+  {"time_ns", TRACE_FIELD_SECONDS},
+  {"latency_ns", TRACE_FIELD_TIME},
+  {"lost", TRACE_FIELD_UINT}
+};
+
+const TraceColumn TASK_COLUMNS[] = {
+  {"task_id", TRACE_FIELD_UINT},
+  {"node_id", TRACE_FIELD_UINT},
+  {"status", TRACE_FIELD_TEXT},
+  {"where", TRACE_FIELD_UINT},
+  {"from_vcc", TRACE_FIELD_UINT},
+  {"initial_time_ns", TRACE_FIELD_TIME},
+  {"uplink_time_ns", TRACE_FIELD_TIME},
+  {"queueing_time_ns", TRACE_FIELD_TIME},
+  {"elaboration_time_ns", TRACE_FIELD_TIME},
+  {"final_time_ns", TRACE_FIELD_TIME},
+  {"workload", TRACE_FIELD_DOUBLE},
+  {"cars_in_vcc", TRACE_FIELD_UINT}
+};
+
+#define TRACE_SCHEMA(columns) columns, sizeof(columns) / sizeof(columns[0])
+
+struct TraceSchema
+{
+  const TraceColumn* columns;
+  uint32_t nColumns;
+};
+
+const TraceSchema SCHEMAS[TRACE_KIND_COUNT] = {
+  {TRACE_SCHEMA(OFFLOADING_COLUMNS)},   // TRACE_OFFLOADING_TIME
+  {TRACE_SCHEMA(SENT_COLUMNS)},         // TRACE_SENT_PACKETS
+  {TRACE_SCHEMA(PACKET_COLUMNS)},       // TRACE_EDGE_SENT_PACKETS
+  {TRACE_SCHEMA(PACKET_COLUMNS)},       // TRACE_CLOUD_SENT_PACKETS
+  {TRACE_SCHEMA(PACKET_COLUMNS)},       // TRACE_VCC_SENT_PACKETS
+  {TRACE_SCHEMA(PACKET_COLUMNS)},       // TRACE_VCC_RECEIVED_PACKETS
+  {TRACE_SCHEMA(PACKET_COLUMNS)},       // TRACE_VCC_REJECTED_PACKETS
+  {TRACE_SCHEMA(BEACON_COLUMNS)},       // TRACE_VCC_BEACONS
+  {TRACE_SCHEMA(DWELL_TIME_COLUMNS)},   // TRACE_DWELL_TIME
+  {TRACE_SCHEMA(SINR_COLUMNS)},         // TRACE_SINR
+  {TRACE_SCHEMA(OFFLOADING_COLUMNS)},   // TRACE_RESPONSE_PASSING_IN_GNB
+  {TRACE_SCHEMA(RADIO_PROBE_COLUMNS)},  // TRACE_RADIO_PROBE
+  {TRACE_SCHEMA(TASK_COLUMNS)}          // TRACE_TASKS
+};
+
+#undef TRACE_SCHEMA
+
+} // namespace
+
+const TraceColumn*
+GetTraceSchema(TraceKind kind, uint32_t& nColumns)
+{
+  nColumns = SCHEMAS[kind].nColumns;
+  return SCHEMAS[kind].columns;
+}
+
+ColumnarTraceFile::ColumnarTraceFile(TraceKind kind, const std::string& folder)
+  : m_rows(0)
+{
+  SystemPath::MakeDirectories(folder);
+
+  uint32_t nColumns;
+  const TraceColumn* schema = GetTraceSchema(kind, nColumns);
+  m_columns.resize(nColumns);
+
+  for (uint32_t c = 0; c < nColumns; ++c)
+  {
+    Column& column = m_columns[c];
+    column.fieldType = schema[c].fieldType;
+    switch (column.fieldType)
+    {
+      case TRACE_FIELD_UINT:
+      case TRACE_FIELD_ADDRESS:
+        column.width = 4;
+        column.descr = "<u4";
+        break;
+      case TRACE_FIELD_INT:
+      case TRACE_FIELD_TIME:
+      case TRACE_FIELD_SECONDS:
+        column.width = 8;
+        column.descr = "<i8";
+        break;
+      case TRACE_FIELD_DOUBLE:
+      case TRACE_FIELD_POSITION:
+        column.width = 8;
+        column.descr = "<f8";
+        break;
+      default:
+        column.width = TEXT_WIDTH;
+        column.descr = "|S16";
+        break;
+    }
+
+    std::string filename = folder + "/" + schema[c].name + ".npy";
+    uint64_t rows = OpenColumn(column, filename);
+    if (c == 0)
+    {
+      m_rows = rows;
+    }
+    NS_ABORT_MSG_IF(rows != m_rows, "Trace column " << filename << " holds " << rows
+                                    << " rows, the other columns " << m_rows);
+    column.buffer.reserve(COLUMN_BUFFER_SIZE);
+  }
+}
+
+ColumnarTraceFile::~ColumnarTraceFile()
+{
+  Close();
+}
+
+uint64_t
+ColumnarTraceFile::OpenColumn(Column& column, const std::string& filename)
+{
+  column.file = std::fopen(filename.c_str(), "r+b");
+  char header[NPY_HEADER_SIZE + 1] = {};
+  if (!column.file || std::fread(header, 1, NPY_HEADER_SIZE, column.file) == 0)
+  {
+    if (column.file)
+    {
+      std::fclose(column.file);
+    }
+    column.file = std::fopen(filename.c_str(), "w+b");
+    NS_ABORT_MSG_IF(!column.file, "Cannot open trace column " << filename);
+    WriteHeader(column, 0);
+    return 0;
+  }
+
+  char descr[8] = {};
+  unsigned long long rows = 0;
+  bool valid = std::memcmp(header, "\x93NUMPY\x01\x00", 8) == 0
+               && static_cast<uint8_t>(header[8]) == NPY_HEADER_SIZE - 10 && header[9] == 0
+               && std::sscanf(header + 10, "{'descr': '%7[^']', 'fortran_order': False, 'shape': (%llu,), }",
+                              descr, &rows) == 2
+               && std::strcmp(descr, column.descr) == 0;
+  NS_ABORT_MSG_IF(!valid, "Cannot append to trace column " << filename << ", written with another schema");
+
+  // Rows past the header count come from a run that did not close its traces
+  NS_ABORT_MSG_IF(ftruncate(fileno(column.file), NPY_HEADER_SIZE + rows * column.width) != 0,
+                  "Cannot truncate trace column " << filename);
+  std::fseek(column.file, 0, SEEK_END);
+  return rows;
+}
+
+void
+ColumnarTraceFile::WriteHeader(Column& column, uint64_t rows)
+{
+  char header[NPY_HEADER_SIZE];
+  std::memset(header, ' ', sizeof(header));
+  std::memcpy(header, "\x93NUMPY\x01\x00", 8);
+  uint16_t dictSize = NPY_HEADER_SIZE - 10;
+  header[8] = static_cast<char>(dictSize & 0xff);
+  header[9] = static_cast<char>(dictSize >> 8);
+
+  int written = std::snprintf(header + 10, dictSize,
+                              "{'descr': '%s', 'fortran_order': False, 'shape': (%llu,), }",
+                              column.descr, static_cast<unsigned long long>(rows));
+  header[10 + written] = ' ';   // overwrite the terminating null
+  header[NPY_HEADER_SIZE - 1] = '\n';
+
+  std::fseek(column.file, 0, SEEK_SET);
+  std::fwrite(header, 1, sizeof(header), column.file);
+  std::fseek(column.file, 0, SEEK_END);
+}
+
+void
+ColumnarTraceFile::FlushColumn(Column& column)
+{
+  if (!column.buffer.empty())
+  {
+    std::fwrite(column.buffer.data(), 1, column.buffer.size(), column.file);
+    column.buffer.clear();
+  }
+}
+
+void
+ColumnarTraceFile::Append(const TraceRecord& record)
+{
+  uint32_t nFields = record.GetNFields();
+  NS_ASSERT_MSG(nFields <= m_columns.size(), "Trace record does not match its schema");
+
+  for (uint32_t c = 0; c < m_columns.size(); ++c)
+  {
+    Column& column = m_columns[c];
+    char value[TEXT_WIDTH];
+    std::memset(value, 0, sizeof(value));
+
+    if (c < nFields)
+    {
+      const TraceField& field = record.GetField(c);
+      NS_ASSERT_MSG(field.type == column.fieldType, "Trace field type does not match its schema");
+      switch (column.width)
+      {
+        case 4:
+        {
+          uint32_t v = static_cast<uint32_t>(field.u);
+          std::memcpy(value, &v, 4);
+          break;
+        }
+        case 8:
+          // i, u and d share the storage of the union
+          std::memcpy(value, &field.i, 8);
+          break;
+        default:
+          std::strncpy(value, field.s, TEXT_WIDTH);
+          break;
+      }
+    }
+    else if (column.width == 8 && column.descr[1] == 'f')
+    {
+      double nan = std::numeric_limits<double>::quiet_NaN();
+      std::memcpy(value, &nan, 8);
+    }
+
+    column.buffer.insert(column.buffer.end(), value, value + column.width);
+    if (column.buffer.size() >= COLUMN_BUFFER_SIZE)
+    {
+      FlushColumn(column);
+    }
+  }
+  ++m_rows;
+}
+
+void
+ColumnarTraceFile::Close()
+{
+  for (Column& column : m_columns)
+  {
+    if (column.file)
+    {
+      FlushColumn(column);
+      WriteHeader(column, m_rows);
+      std::fclose(column.file);
+      column.file = nullptr;
+    }
+  }
+}
+
+} // namespace ns3
@@ -0,0 +1,107 @@
+/**
+ * ColumnarTraceFile - Binary columnar output for the simulation traces
+ *
+ * In binary trace format every trace kind is written to a folder holding one
+ * NumPy .npy file per column (int64 nanosecond timestamps, uint32 ids and
+ * counters, float64 workloads and capacities, fixed-width text). Each file is
+ * self-describing and can be memory-mapped with numpy.load(mmap_mode="r")
+ * and wrapped zero-copy by pyarrow.
+ */
+
+#ifndef NS3_TRACE_COLUMNAR_H
+#define NS3_TRACE_COLUMNAR_H
+
+#include "trace-sink.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Description of one column of a trace kind
+ */
+struct TraceColumn
+{
+  const char* name;     ///< Column (and .npy file) name
+  uint8_t fieldType;    ///< TraceFieldType expected at this position of the record
+};
+
+/**
+ * \brief Get the columns of a trace kind, in record order
+ *
+ * \param kind The trace kind
+ * \param nColumns Receives the number of columns
+ * \return Pointer to a static array of nColumns columns
+ */
+const TraceColumn* GetTraceSchema(TraceKind kind, uint32_t& nColumns);
+
+/**
+ * \brief Writer of a folder of .npy column files for one trace kind
+ *
+ * Values are buffered per column and appended to the files in blocks; the
+ * row count in each .npy header is patched when the file is closed. Files
+ * left in the folder by a previous run are appended to, as the CSV traces,
+ * provided their columns have the same types and row count. Records
+ * with fewer fields than the schema (e.g. dwell time rows without position)
+ * are padded with NaN, zero or empty text.
+ */
+class ColumnarTraceFile
+{
+public:
+  /**
+   * \brief Open the column files, created or appended to
+   *
+   * \param kind Trace kind, selecting the schema
+   * \param folder Output folder, created if missing
+   */
+  ColumnarTraceFile(TraceKind kind, const std::string& folder);
+  ~ColumnarTraceFile();
+
+  /**
+   * \brief Append one row
+   * \param record The record, laid out as the schema of the trace kind
+   */
+  void Append(const TraceRecord& record);
+
+  /**
+   * \brief Write the buffered values and the final headers, then close the files
+   */
+  void Close();
+
+  /// Width in bytes of text columns
+  static const uint32_t TEXT_WIDTH = 16;
+
+private:
+  /**
+   * \brief One open .npy file
+   */
+  struct Column
+  {
+    uint8_t fieldType;          ///< TraceFieldType of the values
+    uint32_t width;             ///< Bytes per value
+    const char* descr;          ///< NumPy dtype descriptor
+    std::FILE* file;            ///< Open .npy file
+    std::vector<char> buffer;   ///< Values not yet written
+  };
+
+  /**
+   * \brief Open a column file, reusing its rows if it exists
+   *
+   * \param column The column, whose type is set
+   * \param filename Path of the .npy file
+   * \return Rows already in the file
+   */
+  uint64_t OpenColumn(Column& column, const std::string& filename);
+
+  void WriteHeader(Column& column, uint64_t rows);
+  void FlushColumn(Column& column);
+
+  std::vector<Column> m_columns;  ///< One entry per schema column
+  uint64_t m_rows;                ///< Rows appended so far
+};
+
+} // namespace ns3
+
+#endif // NS3_TRACE_COLUMNAR_H
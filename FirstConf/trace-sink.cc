@@ -0,0 +1,554 @@
+/**
+ * Implementation of the TraceSink subsystem
+ *
+ * Rows are formatted with a small hand-rolled number formatter (no iostreams,
+ * no locale lookups) into a per-kind buffer that is written to disk in large
+ * blocks and flushed when the simulator is destroyed.
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include "trace-sink.h"
+#include "trace-columnar.h"
+#include "spsc-ring.h"
+#include "event-profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("TraceSink");
+
+//------------------------------------------------------------------------------
+// TraceRecord
+//------------------------------------------------------------------------------
+
+TraceRecord::TraceRecord(TraceKind kind)
+  : m_kind(kind),
+    m_nFields(0)
+{
+  // Field values are written by the Add* methods
+}
+
+TraceField&
+TraceRecord::NextField(TraceFieldType type)
+{
+  NS_ABORT_MSG_IF(m_nFields >= MAX_FIELDS, "Too many fields in a trace record");
+  TraceField& field = m_fields[m_nFields++];
+  field.type = type;
+  return field;
+}
+
+TraceRecord&
+TraceRecord::AddUint(uint64_t value)
+{
+  NextField(TRACE_FIELD_UINT).u = value;
+  return *this;
+}
+
+TraceRecord&
+TraceRecord::AddInt(int64_t value)
+{
+  NextField(TRACE_FIELD_INT).i = value;
+  return *this;
+}
+
+TraceRecord&
+TraceRecord::AddDouble(double value)
+{
+  NextField(TRACE_FIELD_DOUBLE).d = value;
+  return *this;
+}
+
+TraceRecord&
+TraceRecord::AddTime(Time value)
+{
+  NextField(TRACE_FIELD_TIME).i = value.GetNanoSeconds();
+  return *this;
+}
+
+TraceRecord&
+TraceRecord::AddSeconds(Time value)
+{
+  NextField(TRACE_FIELD_SECONDS).i = value.GetNanoSeconds();
+  return *this;
+}
+
+TraceRecord&
+TraceRecord::AddAddress(Ipv4Address value)
+{
+  NextField(TRACE_FIELD_ADDRESS).u = value.Get();
+  return *this;
+}
+
+TraceRecord&
+TraceRecord::AddPosition(const Vector& value)
+{
+  // The first component starts a new column, the others are joined with ':'
+  NextField(TRACE_FIELD_DOUBLE).d = value.x;
+  NextField(TRACE_FIELD_POSITION).d = value.y;
+  NextField(TRACE_FIELD_POSITION).d = value.z;
+  return *this;
+}
+
+TraceRecord&
+TraceRecord::AddText(const char* value)
+{
+  NextField(TRACE_FIELD_TEXT).s = value;
+  return *this;
+}
+
+TraceKind
+TraceRecord::GetKind() const
+{
+  return static_cast<TraceKind>(m_kind);
+}
+
+uint32_t
+TraceRecord::GetNFields() const
+{
+  return m_nFields;
+}
+
+const TraceField&
+TraceRecord::GetField(uint32_t index) const
+{
+  return m_fields[index];
+}
+
+//------------------------------------------------------------------------------
+// Number formatting
+//------------------------------------------------------------------------------
+
+namespace {
+
+/// Maximum number of characters copied from a text field
+const size_t MAX_TEXT_SIZE = 30;
+
+char*
+AppendUint(char* out, uint64_t value)
+{
+  char digits[20];
+  int n = 0;
+  do
+  {
+    digits[n++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+
+  while (n > 0)
+  {
+    *out++ = digits[--n];
+  }
+  return out;
+}
+
+char*
+AppendInt(char* out, int64_t value)
+{
+  if (value < 0)
+  {
+    *out++ = '-';
+    return AppendUint(out, static_cast<uint64_t>(-(value + 1)) + 1);
+  }
+  return AppendUint(out, static_cast<uint64_t>(value));
+}
+
+/**
+ * Write a nine-digit decimal fraction (".000000123"), dropping trailing zeros
+ */
+char*
+AppendFraction(char* out, uint64_t fractionPart)
+{
+  if (fractionPart != 0)
+  {
+    char digits[9];
+    for (int k = 8; k >= 0; --k)
+    {
+      digits[k] = static_cast<char>('0' + fractionPart % 10);
+      fractionPart /= 10;
+    }
+    int last = 8;
+    while (digits[last] == '0')
+    {
+      --last;
+    }
+    *out++ = '.';
+    std::memcpy(out, digits, last + 1);
+    out += last + 1;
+  }
+  return out;
+}
+
+/**
+ * Write a double with up to nine decimals (nanosecond resolution for values
+ * in seconds), dropping trailing zeros. Values outside the fixed-point range
+ * fall back to printf.
+ */
+char*
+AppendDouble(char* out, double value)
+{
+  double magnitude = std::fabs(value);
+  if (!std::isfinite(value) || magnitude >= 1e9 || (magnitude < 1e-6 && magnitude != 0))
+  {
+    return out + std::snprintf(out, 32, "%.15g", value);
+  }
+
+  if (value < 0)
+  {
+    *out++ = '-';
+  }
+
+  uint64_t scaled = static_cast<uint64_t>(std::llround(magnitude * 1e9));
+  uint64_t integerPart = scaled / 1000000000ULL;
+  uint64_t fractionPart = scaled % 1000000000ULL;
+
+  out = AppendUint(out, integerPart);
+  return AppendFraction(out, fractionPart);
+}
+
+/**
+ * Write integer nanoseconds as exact decimal seconds, dropping trailing zeros
+ */
+char*
+AppendSeconds(char* out, int64_t nanoSeconds)
+{
+  uint64_t magnitude = static_cast<uint64_t>(nanoSeconds);
+  if (nanoSeconds < 0)
+  {
+    *out++ = '-';
+    magnitude = static_cast<uint64_t>(-(nanoSeconds + 1)) + 1;
+  }
+  out = AppendUint(out, magnitude / 1000000000ULL);
+
+  uint64_t fractionPart = magnitude % 1000000000ULL;
+  return AppendFraction(out, fractionPart);
+}
+
+char*
+AppendAddress(char* out, uint32_t address)
+{
+  out = AppendUint(out, (address >> 24) & 0xff);
+  *out++ = '.';
+  out = AppendUint(out, (address >> 16) & 0xff);
+  *out++ = '.';
+  out = AppendUint(out, (address >> 8) & 0xff);
+  *out++ = '.';
+  return AppendUint(out, address & 0xff);
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// TraceSink
+//------------------------------------------------------------------------------
+
+TraceSink::TraceSink()
+  : m_kind(TRACE_OFFLOADING_TIME),
+    m_format(TRACE_FORMAT_CSV),
+    m_columns(nullptr),
+    m_file(nullptr),
+    m_used(0)
+{
+  // The buffer is allocated on the first write
+}
+
+TraceSink::~TraceSink()
+{
+  Close();
+}
+
+void
+TraceSink::SetOutput(TraceKind kind, const std::string& filename, TraceFormat format)
+{
+  Close();
+  m_kind = kind;
+  m_format = format;
+  m_filename = filename;
+}
+
+size_t
+TraceSink::FormatRow(const TraceRecord& record, char* out)
+{
+  char* p = out;
+  for (uint32_t k = 0; k < record.GetNFields(); ++k)
+  {
+    const TraceField& field = record.GetField(k);
+    if (field.type == TRACE_FIELD_POSITION)
+    {
+      *p++ = ':';
+    }
+    else if (k > 0)
+    {
+      *p++ = ',';
+    }
+
+    switch (field.type)
+    {
+      case TRACE_FIELD_UINT:
+        p = AppendUint(p, field.u);
+        break;
+      case TRACE_FIELD_INT:
+        p = AppendInt(p, field.i);
+        break;
+      case TRACE_FIELD_DOUBLE:
+      case TRACE_FIELD_POSITION:
+        p = AppendDouble(p, field.d);
+        break;
+      case TRACE_FIELD_TIME:
+        // Same layout as ns3::Time streaming ("+<value>ns"), without rounding
+        if (field.i >= 0)
+        {
+          *p++ = '+';
+        }
+        p = AppendInt(p, field.i);
+        *p++ = 'n';
+        *p++ = 's';
+        break;
+      case TRACE_FIELD_SECONDS:
+        p = AppendSeconds(p, field.i);
+        break;
+      case TRACE_FIELD_ADDRESS:
+        p = AppendAddress(p, static_cast<uint32_t>(field.u));
+        break;
+      case TRACE_FIELD_TEXT:
+        for (size_t c = 0; field.s[c] != '\0' && c < MAX_TEXT_SIZE; ++c)
+        {
+          *p++ = field.s[c];
+        }
+        break;
+    }
+  }
+  *p++ = '\n';
+  return p - out;
+}
+
+void
+TraceSink::Write(const TraceRecord& record)
+{
+  if (m_format == TRACE_FORMAT_BINARY)
+  {
+    if (!m_columns)
+    {
+      m_columns = new ColumnarTraceFile(m_kind, m_filename);
+    }
+    m_columns->Append(record);
+    return;
+  }
+
+  if (m_buffer.empty())
+  {
+    m_buffer.resize(BUFFER_SIZE);
+  }
+  if (m_used + MAX_ROW_SIZE > m_buffer.size())
+  {
+    Flush();
+  }
+  m_used += FormatRow(record, m_buffer.data() + m_used);
+}
+
+void
+TraceSink::Flush()
+{
+  if (m_used == 0)
+  {
+    return;
+  }
+
+  if (!m_file)
+  {
+    m_file = std::fopen((m_filename + ".csv").c_str(), "a");
+    if (!m_file)
+    {
+      NS_LOG_ERROR("Cannot open trace file " << m_filename << ", dropping " << m_used << " bytes");
+      m_used = 0;
+      return;
+    }
+    // Rows are already buffered here, stdio buffering would only copy them again
+    std::setvbuf(m_file, nullptr, _IONBF, 0);
+  }
+
+  if (std::fwrite(m_buffer.data(), 1, m_used, m_file) != m_used)
+  {
+    NS_LOG_ERROR("Short write on trace file " << m_filename);
+  }
+  m_used = 0;
+}
+
+void
+TraceSink::Close()
+{
+  if (m_columns)
+  {
+    m_columns->Close();
+    delete m_columns;
+    m_columns = nullptr;
+  }
+  Flush();
+  if (m_file)
+  {
+    std::fclose(m_file);
+    m_file = nullptr;
+  }
+  std::vector<char>().swap(m_buffer);
+}
+
+//------------------------------------------------------------------------------
+// TraceSinkRegistry
+//------------------------------------------------------------------------------
+
+TraceSink TraceSinkRegistry::s_sinks[TRACE_KIND_COUNT];
+
+namespace {
+
+/**
+ * State of the asynchronous mode, shared by the event thread (producer) and
+ * the writer thread (consumer)
+ */
+struct AsyncWriterState
+{
+  std::unique_ptr<SpscRing<TraceRecord>> ring;  ///< Records waiting to be written
+  std::thread writer;                           ///< Background writer thread
+  std::atomic<bool> stop{false};                ///< Set by Close() to end the writer
+  TraceFullPolicy policy = TRACE_FULL_BLOCK;    ///< Behaviour on a full ring
+  uint64_t dropped = 0;                         ///< Records dropped (producer side)
+};
+
+AsyncWriterState g_async;
+
+/// Writer sleep when the ring is empty
+const std::chrono::microseconds WRITER_IDLE_SLEEP(200);
+
+} // namespace
+
+const char*
+TraceSinkRegistry::GetFilePrefix(TraceKind kind)
+{
+  static const char* prefixes[TRACE_KIND_COUNT] = {
+    "offloading_time_",
+    "total_sent_packets_",
+    "total_EDGE_sent_packets_",
+    "total_CLOUD_sent_packets_",
+    "total_VCC_sent_packets_",
+    "total_VCC_received_from_edge_packets_",
+    "total_VCC_rejected_packets_cause_full_queue_",
+    "total_VCC_beacons_",
+    "dwell_time_",
+    "total_data_SINR_received_from_edge_packets_",
+    "response_offloading_passing_in_gNB_",
+    "radio_probe_",
+    "tasks_"
+  };
+  return prefixes[kind];
+}
+
+void
+TraceSinkRegistry::Open(const std::string& outputFolder, const std::string& simType,
+                        TraceFormat format)
+{
+  for (uint32_t k = 0; k < TRACE_KIND_COUNT; ++k)
+  {
+    TraceKind kind = static_cast<TraceKind>(k);
+    s_sinks[k].SetOutput(kind, outputFolder + "/" + GetFilePrefix(kind) + simType, format);
+  }
+}
+
+void
+TraceSinkRegistry::EnableAsync(size_t ringCapacity, TraceFullPolicy policy)
+{
+  NS_ABORT_MSG_IF(g_async.ring, "Asynchronous trace writer already enabled");
+  g_async.ring.reset(new SpscRing<TraceRecord>(ringCapacity));
+  g_async.policy = policy;
+  g_async.dropped = 0;
+  g_async.stop.store(false);
+  g_async.writer = std::thread(&TraceSinkRegistry::WriterLoop);
+}
+
+uint64_t
+TraceSinkRegistry::GetDroppedRecords()
+{
+  return g_async.dropped;
+}
+
+void
+TraceSinkRegistry::WriterLoop()
+{
+  TraceRecord record;
+  while (true)
+  {
+    // Read the flag before draining so that nothing pushed before Close() is lost
+    bool stop = g_async.stop.load(std::memory_order_acquire);
+    uint32_t drained = 0;
+    while (g_async.ring->TryPop(record))
+    {
+      s_sinks[record.GetKind()].Write(record);
+      ++drained;
+    }
+    if (drained == 0)
+    {
+      if (stop)
+      {
+        break;
+      }
+      std::this_thread::sleep_for(WRITER_IDLE_SLEEP);
+    }
+  }
+}
+
+void
+TraceSinkRegistry::Write(const TraceRecord& record)
+{
+  EventProfiler::Scope profile("TraceSinkRegistry::Write");
+  if (!g_async.ring)
+  {
+    s_sinks[record.GetKind()].Write(record);
+    return;
+  }
+
+  while (!g_async.ring->TryPush(record))
+  {
+    if (g_async.policy == TRACE_FULL_DROP)
+    {
+      ++g_async.dropped;
+      return;
+    }
+    std::this_thread::yield();
+  }
+}
+
+void
+TraceSinkRegistry::FlushAll()
+{
+  NS_ABORT_MSG_IF(g_async.ring, "FlushAll() is not available with the asynchronous writer");
+  for (uint32_t k = 0; k < TRACE_KIND_COUNT; ++k)
+  {
+    s_sinks[k].Flush();
+  }
+}
+
+void
+TraceSinkRegistry::Close()
+{
+  if (g_async.ring)
+  {
+    g_async.stop.store(true, std::memory_order_release);
+    g_async.writer.join();
+    g_async.ring.reset();
+    if (g_async.dropped > 0)
+    {
+      NS_LOG_UNCOND("TraceSink: " << g_async.dropped << " trace records dropped (ring full)");
+    }
+  }
+  for (uint32_t k = 0; k < TRACE_KIND_COUNT; ++k)
+  {
+    s_sinks[k].Close();
+  }
+}
+
+} // namespace ns3
@@ -0,0 +1,286 @@
+/**
+ * TraceSink - Persistent buffered output for the simulation CSV traces
+ *
+ * This file defines the trace records produced by the applications and the
+ * registry of sinks that writes them to disk. Each trace kind keeps one file
+ * handle open for the whole run and writes through a large user-space buffer,
+ * instead of opening, appending and closing the CSV file for every event.
+ */
+
+#ifndef NS3_TRACE_SINK_H
+#define NS3_TRACE_SINK_H
+
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+#include "ns3/ipv4-address.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Trace kinds written by the simulation, one output file each
+ */
+enum TraceKind
+{
+  TRACE_OFFLOADING_TIME = 0,      ///< offloading_time_*
+  TRACE_SENT_PACKETS,             ///< total_sent_packets_*
+  TRACE_EDGE_SENT_PACKETS,        ///< total_EDGE_sent_packets_*
+  TRACE_CLOUD_SENT_PACKETS,       ///< total_CLOUD_sent_packets_*
+  TRACE_VCC_SENT_PACKETS,         ///< total_VCC_sent_packets_*
+  TRACE_VCC_RECEIVED_PACKETS,     ///< total_VCC_received_from_edge_packets_*
+  TRACE_VCC_REJECTED_PACKETS,     ///< total_VCC_rejected_packets_cause_full_queue_*
+  TRACE_VCC_BEACONS,              ///< total_VCC_beacons_*
+  TRACE_DWELL_TIME,               ///< dwell_time_*
+  TRACE_SINR,                     ///< total_data_SINR_received_from_edge_packets_*
+  TRACE_RESPONSE_PASSING_IN_GNB,  ///< response_offloading_passing_in_gNB_*
+  TRACE_RADIO_PROBE,              ///< radio_probe_*
+  TRACE_TASKS,                    ///< tasks_*
+  TRACE_KIND_COUNT
+};
+
+/**
+ * \brief Type of a single value stored in a TraceRecord
+ */
+enum TraceFieldType
+{
+  TRACE_FIELD_UINT = 0,   ///< Unsigned integer
+  TRACE_FIELD_INT,        ///< Signed integer
+  TRACE_FIELD_DOUBLE,     ///< Floating point value
+  TRACE_FIELD_TIME,       ///< ns3::Time stored as integer nanoseconds
+  TRACE_FIELD_SECONDS,    ///< ns3::Time stored as integer nanoseconds, written in seconds
+  TRACE_FIELD_ADDRESS,    ///< IPv4 address stored as host-order integer
+  TRACE_FIELD_POSITION,   ///< Position component, joined to the previous one with ':'
+  TRACE_FIELD_TEXT        ///< Pointer to a string literal with static storage
+};
+
+/**
+ * \brief A single typed value of a trace row
+ */
+struct TraceField
+{
+  uint8_t type;           ///< One of TraceFieldType
+  union
+  {
+    uint64_t u;
+    int64_t i;
+    double d;
+    const char* s;
+  };
+};
+
+/**
+ * \brief A fixed-size, typed row of a trace file
+ *
+ * Records only hold plain values, so building one does not allocate and
+ * formatting can be deferred until the record is written out.
+ */
+class TraceRecord
+{
+public:
+  /// Maximum number of values in a single row
+  static const uint32_t MAX_FIELDS = 20;
+
+  /**
+   * \brief Create an empty record
+   * \param kind The trace file the record belongs to
+   */
+  explicit TraceRecord(TraceKind kind = TRACE_OFFLOADING_TIME);
+
+  TraceRecord& AddUint(uint64_t value);
+  TraceRecord& AddInt(int64_t value);
+  TraceRecord& AddDouble(double value);
+  TraceRecord& AddTime(Time value);
+
+  /**
+   * \brief Add a time written in seconds in the CSV output
+   * \param value The time, kept with nanosecond resolution
+   */
+  TraceRecord& AddSeconds(Time value);
+
+  TraceRecord& AddAddress(Ipv4Address value);
+
+  /**
+   * \brief Add a position, written as x:y:z in a single CSV column
+   * \param value The position vector
+   */
+  TraceRecord& AddPosition(const Vector& value);
+
+  /**
+   * \brief Add a text value
+   * \param value A string literal (the pointer is stored, not the characters)
+   */
+  TraceRecord& AddText(const char* value);
+
+  TraceKind GetKind() const;
+  uint32_t GetNFields() const;
+  const TraceField& GetField(uint32_t index) const;
+
+private:
+  TraceField& NextField(TraceFieldType type);
+
+  uint8_t m_kind;                       ///< TraceKind of the record
+  uint8_t m_nFields;                    ///< Number of fields in use
+  TraceField m_fields[MAX_FIELDS];      ///< Row values
+};
+
+/**
+ * \brief On-disk format of the traces
+ */
+enum TraceFormat
+{
+  TRACE_FORMAT_CSV = 0,   ///< One CSV file per trace kind
+  TRACE_FORMAT_BINARY     ///< One folder of typed .npy columns per trace kind
+};
+
+class ColumnarTraceFile;
+
+/**
+ * \brief Buffered writer for a single trace file
+ *
+ * The file is opened lazily on the first write and kept open until Close().
+ * Rows are formatted into a user-space buffer that is written out in large
+ * blocks. In binary format the rows are appended to a ColumnarTraceFile
+ * instead.
+ */
+class TraceSink
+{
+public:
+  /// Size of the user-space buffer of every sink
+  static const size_t BUFFER_SIZE = 1 << 20;
+
+  TraceSink();
+  ~TraceSink();
+
+  /**
+   * \brief Set the file written by this sink
+   *
+   * \param kind Trace kind of the rows written to this sink
+   * \param filename Path of the output file without extension
+   * \param format Output format
+   */
+  void SetOutput(TraceKind kind, const std::string& filename, TraceFormat format);
+
+  /**
+   * \brief Format a record as one CSV row and append it to the buffer
+   * \param record The record to write
+   */
+  void Write(const TraceRecord& record);
+
+  /**
+   * \brief Write the buffered rows to the file
+   */
+  void Flush();
+
+  /**
+   * \brief Flush and close the file
+   */
+  void Close();
+
+  /**
+   * \brief Format a record as a CSV row, including the trailing newline
+   *
+   * \param record The record to format
+   * \param out Output buffer, at least MAX_ROW_SIZE bytes long
+   * \return Number of characters written
+   */
+  static size_t FormatRow(const TraceRecord& record, char* out);
+
+  /// Upper bound of the characters produced by FormatRow
+  static const size_t MAX_ROW_SIZE = TraceRecord::MAX_FIELDS * 32;
+
+private:
+  TraceKind m_kind;           ///< Trace kind of the rows
+  TraceFormat m_format;       ///< Output format
+  ColumnarTraceFile* m_columns; ///< Binary output, null in CSV format
+  std::string m_filename;     ///< Output file path
+  std::FILE* m_file;          ///< Output file, null until the first flush
+  std::vector<char> m_buffer; ///< Formatted rows not yet written
+  size_t m_used;              ///< Bytes in use in m_buffer
+};
+
+/**
+ * \brief What the event thread does when the asynchronous trace ring is full
+ */
+enum TraceFullPolicy
+{
+  TRACE_FULL_BLOCK = 0,   ///< Wait for the writer thread to free a slot
+  TRACE_FULL_DROP         ///< Drop the record and count it
+};
+
+/**
+ * \brief Registry of the trace sinks of a simulation run
+ *
+ * CoE.cc opens the registry once with the output folder and simulation type,
+ * the applications write records through it, and the registry is closed by
+ * an event scheduled to run at Simulator::Destroy.
+ *
+ * In asynchronous mode Write() only copies the record into a bounded
+ * lock-free ring; a background writer thread drains the ring, formats the
+ * rows and writes them to disk.
+ */
+class TraceSinkRegistry
+{
+public:
+  /**
+   * \brief Configure the sinks for a run
+   *
+   * \param outputFolder Folder of the output CSV files
+   * \param simType Simulation type appended to the file names
+   * \param format On-disk format of the traces
+   */
+  static void Open(const std::string& outputFolder, const std::string& simType,
+                   TraceFormat format = TRACE_FORMAT_CSV);
+
+  /**
+   * \brief Move formatting and file writes to a background writer thread
+   *
+   * Must be called after Open() and before the first Write().
+   *
+   * \param ringCapacity Number of records buffered between the threads
+   * \param policy Behaviour of Write() when the ring is full
+   */
+  static void EnableAsync(size_t ringCapacity, TraceFullPolicy policy);
+
+  /**
+   * \return The number of records dropped because the ring was full
+   */
+  static uint64_t GetDroppedRecords();
+
+  /**
+   * \brief Write a record to the sink of its trace kind
+   * \param record The record to write
+   */
+  static void Write(const TraceRecord& record);
+
+  /**
+   * \brief Flush all the sinks to disk (synchronous mode only)
+   */
+  static void FlushAll();
+
+  /**
+   * \brief Stop the writer thread, if any, then flush and close all the sinks
+   */
+  static void Close();
+
+  /**
+   * \brief Get the file name prefix of a trace kind
+   * \param kind The trace kind
+   * \return File name prefix, e.g. "offloading_time_"
+   */
+  static const char* GetFilePrefix(TraceKind kind);
+
+private:
+  /**
+   * \brief Body of the background writer thread
+   */
+  static void WriterLoop();
+
+  static TraceSink s_sinks[TRACE_KIND_COUNT];   ///< One sink per trace kind
+};
+
+} // namespace ns3
+
+#endif // NS3_TRACE_SINK_H
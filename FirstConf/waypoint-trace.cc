@@ -0,0 +1,211 @@
+/**
+ * Implementation of the memory-mapped waypoint traces
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/waypoint-mobility-model.h"
+
+#include "waypoint-trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("WaypointTrace");
+
+namespace {
+
+const char WAYPOINT_TRACE_MAGIC[8] = "COEWPT1";
+
+/**
+ * \brief Hand the next batch of waypoints of a vehicle to its mobility model
+ *
+ * Reschedules itself half-way through the batch, so that the model always
+ * knows where the vehicle goes next.
+ */
+void
+FeedWaypoints(Ptr<const WaypointTrace> trace, uint32_t vehicle, uint32_t next, uint32_t batch,
+              Ptr<WaypointMobilityModel> model)
+{
+  const WaypointTraceSample* waypoints = trace->GetWaypoints(vehicle);
+  uint32_t count = trace->GetNWaypoints(vehicle);
+  uint32_t end = std::min(next + batch, count);
+  for (uint32_t i = next; i < end; i++)
+  {
+    model->AddWaypoint(Waypoint(Seconds(waypoints[i].time),
+                                Vector(waypoints[i].x, waypoints[i].y, 0)));
+  }
+  if (end < count)
+  {
+    Time refill = Seconds(waypoints[next + (end - next) / 2].time);
+    Simulator::Schedule(Max(refill - Simulator::Now(), Seconds(0)), &FeedWaypoints, trace, vehicle,
+                        end, batch, model);
+  }
+}
+
+} // namespace
+
+WaypointTrace::WaypointTrace(const std::string& filename)
+  : m_data(nullptr),
+    m_size(0),
+    m_mapped(true)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  NS_ABORT_MSG_IF(fd < 0, "Cannot open waypoint trace " << filename << ": " << std::strerror(errno));
+  struct stat st;
+  NS_ABORT_MSG_IF(fstat(fd, &st) != 0, "Cannot stat waypoint trace " << filename);
+  m_size = st.st_size;
+  NS_ABORT_MSG_IF(m_size < sizeof(WaypointTraceHeader), "Truncated waypoint trace " << filename);
+
+  void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  NS_ABORT_MSG_IF(data == MAP_FAILED, "Cannot map waypoint trace " << filename << ": "
+                                      << std::strerror(errno));
+  m_data = static_cast<const uint8_t*>(data);
+  Parse(filename);
+
+  // Read ahead asynchronously: every vehicle walks through its waypoints during the run
+  madvise(data, m_size, MADV_WILLNEED);
+}
+
+WaypointTrace::WaypointTrace(const std::vector<std::vector<WaypointTraceSample>>& vehicles)
+  : m_mapped(false)
+{
+  uint64_t nWaypoints = 0;
+  for (const auto& waypoints : vehicles)
+  {
+    nWaypoints += waypoints.size();
+  }
+  m_size = sizeof(WaypointTraceHeader) + vehicles.size() * sizeof(WaypointTraceVehicle) +
+           nWaypoints * sizeof(WaypointTraceSample);
+  m_buffer.assign((m_size + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+  uint8_t* data = reinterpret_cast<uint8_t*>(m_buffer.data());
+  m_data = data;
+
+  WaypointTraceHeader* header = reinterpret_cast<WaypointTraceHeader*>(data);
+  std::memcpy(header->magic, WAYPOINT_TRACE_MAGIC, sizeof(WAYPOINT_TRACE_MAGIC));
+  header->nVehicles = vehicles.size();
+  header->nWaypoints = nWaypoints;
+
+  WaypointTraceVehicle* index = reinterpret_cast<WaypointTraceVehicle*>(data + sizeof(WaypointTraceHeader));
+  WaypointTraceSample* samples = reinterpret_cast<WaypointTraceSample*>(index + vehicles.size());
+  uint64_t first = 0;
+  for (uint32_t v = 0; v < vehicles.size(); v++)
+  {
+    index[v].first = first;
+    index[v].count = vehicles[v].size();
+    std::copy(vehicles[v].begin(), vehicles[v].end(), samples + first);
+    first += vehicles[v].size();
+  }
+  Parse("<generated>");
+}
+
+WaypointTrace::~WaypointTrace()
+{
+  if (m_mapped)
+  {
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+  }
+}
+
+void
+WaypointTrace::Parse(const std::string& name)
+{
+  m_header = reinterpret_cast<const WaypointTraceHeader*>(m_data);
+  NS_ABORT_MSG_IF(std::memcmp(m_header->magic, WAYPOINT_TRACE_MAGIC, sizeof(WAYPOINT_TRACE_MAGIC)) != 0,
+                  name << " is not a waypoint trace");
+  size_t expected = sizeof(WaypointTraceHeader) +
+                    m_header->nVehicles * sizeof(WaypointTraceVehicle) +
+                    m_header->nWaypoints * sizeof(WaypointTraceSample);
+  NS_ABORT_MSG_IF(m_size != expected, "Waypoint trace " << name << " has " << m_size
+                                      << " bytes instead of " << expected);
+
+  m_vehicles = reinterpret_cast<const WaypointTraceVehicle*>(m_data + sizeof(WaypointTraceHeader));
+  m_waypoints = reinterpret_cast<const WaypointTraceSample*>(m_vehicles + m_header->nVehicles);
+  for (uint32_t v = 0; v < m_header->nVehicles; v++)
+  {
+    NS_ABORT_MSG_IF(m_vehicles[v].first + m_vehicles[v].count > m_header->nWaypoints,
+                    "Waypoint trace " << name << ": vehicle " << v << " out of range");
+  }
+}
+
+void
+WaypointTrace::Write(const std::string& filename) const
+{
+  std::ofstream file(filename, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(m_data), m_size);
+  if (!file)
+  {
+    NS_LOG_ERROR("Cannot write waypoint trace " << filename);
+  }
+}
+
+uint32_t
+WaypointTrace::GetNVehicles() const
+{
+  return m_header->nVehicles;
+}
+
+uint32_t
+WaypointTrace::GetNWaypoints(uint32_t vehicle) const
+{
+  return m_vehicles[vehicle].count;
+}
+
+const WaypointTraceSample*
+WaypointTrace::GetWaypoints(uint32_t vehicle) const
+{
+  return m_waypoints + m_vehicles[vehicle].first;
+}
+
+WaypointTraceMobilityHelper::WaypointTraceMobilityHelper(const std::string& filename, uint32_t batch)
+  : m_trace(Create<WaypointTrace>(filename)),
+    m_batch(std::max(batch, 2u))
+{
+}
+
+WaypointTraceMobilityHelper::WaypointTraceMobilityHelper(Ptr<const WaypointTrace> trace, uint32_t batch)
+  : m_trace(trace),
+    m_batch(std::max(batch, 2u))
+{
+}
+
+void
+WaypointTraceMobilityHelper::Install(NodeContainer nodes) const
+{
+  if (nodes.GetN() > m_trace->GetNVehicles())
+  {
+    NS_LOG_WARN("The waypoint trace has " << m_trace->GetNVehicles() << " vehicles for "
+                << nodes.GetN() << " nodes: the remaining nodes stay at the origin");
+  }
+
+  for (uint32_t i = 0; i < nodes.GetN(); i++)
+  {
+    Ptr<Node> node = nodes.Get(i);
+    if (i >= m_trace->GetNVehicles() || m_trace->GetNWaypoints(i) == 0)
+    {
+      node->AggregateObject(CreateObject<ConstantPositionMobilityModel>());
+      continue;
+    }
+
+    // Course changes are notified when the position is queried, not with one event per waypoint
+    Ptr<WaypointMobilityModel> model = CreateObject<WaypointMobilityModel>();
+    model->SetAttribute("LazyNotify", BooleanValue(true));
+    node->AggregateObject(model);
+    FeedWaypoints(m_trace, i, 0, m_batch, model);
+  }
+}
+
+} // namespace ns3
@@ -0,0 +1,162 @@
+/**
+ * WaypointTrace - Memory-mapped binary vehicle traces
+ *
+ * Binary alternative to the ns-2 .tcl traces exported from SUMO, written by
+ * SUMO_Mobility/scripts/fcd_to_waypoints.py from the SUMO FCD output, or
+ * built in memory by ManhattanMobilityGenerator. Files are mapped read-only,
+ * so concurrent simulations share the same pages, and waypoints are handed
+ * to each vehicle WaypointMobilityModel in small batches while the
+ * simulation advances: the startup cost does not depend on the length of
+ * the trace.
+ *
+ * File layout (little-endian):
+ *   header     WaypointTraceHeader
+ *   index      nVehicles x WaypointTraceVehicle
+ *   waypoints  nWaypoints x WaypointTraceSample, per vehicle in time order
+ * Vehicle i is the i-th vehicle appearing in the FCD output, as node_(i) of
+ * the ns-2 trace exported from the same FCD file.
+ */
+
+#ifndef NS3_WAYPOINT_TRACE_H
+#define NS3_WAYPOINT_TRACE_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/node-container.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief First bytes of a waypoint trace file
+ */
+struct WaypointTraceHeader
+{
+  char magic[8];          ///< "COEWPT1" and a terminating zero
+  uint32_t nVehicles;     ///< Number of vehicles
+  uint32_t reserved;      ///< Zero
+  uint64_t nWaypoints;    ///< Total number of waypoints
+};
+
+/**
+ * \brief Waypoints of one vehicle
+ */
+struct WaypointTraceVehicle
+{
+  uint64_t first;         ///< Index of the first waypoint
+  uint32_t count;         ///< Number of waypoints
+  uint32_t reserved;      ///< Zero
+};
+
+/**
+ * \brief Position of a vehicle at a given time
+ */
+struct WaypointTraceSample
+{
+  float time;             ///< Seconds
+  float x;                ///< Meters
+  float y;                ///< Meters
+};
+
+/**
+ * \brief Waypoint trace, memory-mapped from a file or built in memory
+ */
+class WaypointTrace : public SimpleRefCount<WaypointTrace>
+{
+public:
+  /**
+   * \brief Map a file, aborting if it is not a valid waypoint trace
+   * \param filename The trace file
+   */
+  explicit WaypointTrace(const std::string& filename);
+
+  /**
+   * \brief Build a trace in memory, with the same layout as a file
+   * \param vehicles Waypoints of each vehicle, in time order
+   */
+  explicit WaypointTrace(const std::vector<std::vector<WaypointTraceSample>>& vehicles);
+
+  ~WaypointTrace();
+
+  /**
+   * \brief Save the trace, e.g. to reuse a generated one
+   * \param filename The trace file, overwritten
+   */
+  void Write(const std::string& filename) const;
+
+  /**
+   * \return The number of vehicles in the trace
+   */
+  uint32_t GetNVehicles() const;
+
+  /**
+   * \param vehicle Vehicle index
+   * \return The number of waypoints of the vehicle
+   */
+  uint32_t GetNWaypoints(uint32_t vehicle) const;
+
+  /**
+   * \param vehicle Vehicle index
+   * \return The waypoints of the vehicle, in time order
+   */
+  const WaypointTraceSample* GetWaypoints(uint32_t vehicle) const;
+
+private:
+  WaypointTrace(const WaypointTrace&) = delete;
+  WaypointTrace& operator=(const WaypointTrace&) = delete;
+
+  /**
+   * \brief Locate the index and the waypoints, aborting if the data is inconsistent
+   * \param name File name for the error messages
+   */
+  void Parse(const std::string& name);
+
+  const uint8_t* m_data;                    ///< Mapped file or m_buffer
+  size_t m_size;                            ///< Size of the data
+  bool m_mapped;                            ///< The data is a file mapping
+  std::vector<uint64_t> m_buffer;           ///< Data of a trace built in memory (8-byte aligned)
+  const WaypointTraceHeader* m_header;      ///< Header in the mapping
+  const WaypointTraceVehicle* m_vehicles;   ///< Index in the mapping
+  const WaypointTraceSample* m_waypoints;   ///< Waypoints in the mapping
+};
+
+/**
+ * \brief Installs WaypointMobilityModels fed from a waypoint trace
+ *
+ * Drop-in replacement of Ns2MobilityHelper for the vehicles: the i-th node
+ * follows the i-th vehicle of the trace.
+ */
+class WaypointTraceMobilityHelper
+{
+public:
+  /**
+   * \param filename The trace file
+   * \param batch Waypoints handed to a mobility model at a time
+   */
+  explicit WaypointTraceMobilityHelper(const std::string& filename, uint32_t batch = 64);
+
+  /**
+   * \param trace A trace already loaded or generated
+   * \param batch Waypoints handed to a mobility model at a time
+   */
+  explicit WaypointTraceMobilityHelper(Ptr<const WaypointTrace> trace, uint32_t batch = 64);
+
+  /**
+   * \brief Install a mobility model on each node
+   *
+   * Nodes beyond the vehicles of the trace stay at the origin.
+   *
+   * \param nodes The vehicle nodes
+   */
+  void Install(NodeContainer nodes) const;
+
+private:
+  Ptr<const WaypointTrace> m_trace;   ///< Shared mapping
+  uint32_t m_batch;                   ///< Waypoints per refill
+};
+
+} // namespace ns3
+
+#endif // NS3_WAYPOINT_TRACE_H
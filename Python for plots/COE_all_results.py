@@ -16,8 +16,11 @@ import os
 import logging
 from datetime import datetime
 from utils import (
+    OFFLOADING_TIME_COLUMNS,
     failure_rate_for_any_config,
     convert_nanoseconds_to_decimal_seconds,
+    load_binary_trace,
+    offloading_time_components,
     cars_number_in_vcc_for_any_config,
     plot_paradigm_for_any_config,
     workload_strategy_comparison,
@@ -222,6 +225,34 @@ def process_results():
 
                         # Process each input file
                         for input_file_name in input_file_names:
+                            # Binary trace (--traceFormat=binary): a folder of memory-mapped columns
+                            trace_folder = input_file_name[:-len('.csv')]
+                            if os.path.isdir(trace_folder):
+                                try:
+                                    columns = load_binary_trace(trace_folder)
+                                    times = offloading_time_components(columns)
+                                    x_values = np.asarray(columns[OFFLOADING_TIME_COLUMNS[simulation["index"]]])
+                                    paradigm = np.asarray(columns['where']) == choice
+
+                                    for k in range(len_x):
+                                        selected = paradigm & (x_values == simulation["x_axis"][k])
+                                        offloading_times = times['offloading'][selected]
+                                        if strategy == 'VCC_and_CC':
+                                            all_offloading_per_all_seeds[k].extend(offloading_times.tolist())
+                                        z[k] += np.count_nonzero(selected)
+                                        y[k] += offloading_times.sum()
+                                        a[k].extend(offloading_times.tolist())
+                                        uplink_times[k] += times['uplink'][selected].sum()
+                                        queueing_times[k] += times['queueing'][selected].sum()
+                                        elaboration_times[k] += times['elaboration'][selected].sum()
+                                        downlink_times[k] += times['downlink'][selected].sum()
+
+                                        if downlink_times[k] < 0:
+                                            logger.warning(f"Negative downlink time detected: {downlink_times[k]}")
+                                except Exception as e:
+                                    logger.error(f"Error processing trace {trace_folder}: {e}")
+                                continue
+
                             try:
                                 with open(input_file_name) as file:
                                     csvreader = csv.reader(file)
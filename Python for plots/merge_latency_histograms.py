@@ -0,0 +1,133 @@
+"""
+Latency Histogram Merger
+
+Merges the latency_histograms_<simType>.hist files dumped by the simulator
+(one per run) and prints exact-bucket percentiles of the offloading time and
+of its components, without reading the per-request offloading_time rows.
+
+Histograms are grouped by strategy, tier and component (the run column is
+dropped), so hundreds of replications of the same configuration collapse into
+a single histogram per group.
+
+Usage:
+    python merge_latency_histograms.py [--percentiles 50,90,95,99]
+                                       [--output merged.hist] files...
+"""
+import argparse
+import glob
+import sys
+from collections import OrderedDict
+
+FORMAT_HEADER = '# coe-latency-histogram v1'
+
+
+def bucket_lower_bound(index, sub_bucket_bits):
+    # Same layout as LatencyHistogram::GetBucketLowerBound in latency-histogram.cc
+    sub_bucket_count = 1 << sub_bucket_bits
+    if index < 2 * sub_bucket_count:
+        return index
+    shift = index // sub_bucket_count - 1
+    return (index - shift * sub_bucket_count) << shift
+
+
+def bucket_upper_bound(index, sub_bucket_bits):
+    return bucket_lower_bound(index + 1, sub_bucket_bits) - 1
+
+
+class Histogram:
+    def __init__(self):
+        self.count = 0
+        self.min = None
+        self.max = 0
+        self.sum = 0
+        self.buckets = {}
+
+    def merge_line(self, count, min_ns, max_ns, sum_ns, buckets):
+        self.count += count
+        self.min = min_ns if self.min is None else min(self.min, min_ns)
+        self.max = max(self.max, max_ns)
+        self.sum += sum_ns
+        for item in buckets.split():
+            index, bucket_count = item.split(':')
+            index = int(index)
+            self.buckets[index] = self.buckets.get(index, 0) + int(bucket_count)
+
+    def percentile(self, p):
+        # Nearest-rank percentile, resolved to the bucket it falls in
+        rank = int(p / 100.0 * self.count + 0.5)
+        rank = min(max(rank, 1), self.count)
+        seen = 0
+        for index in sorted(self.buckets):
+            seen += self.buckets[index]
+            if seen >= rank:
+                return index
+        return max(self.buckets)
+
+    def serialize(self):
+        buckets = ' '.join(f'{i}:{self.buckets[i]}' for i in sorted(self.buckets))
+        return f'{self.count},{self.min},{self.max},{self.sum},{buckets}'
+
+
+def read_histograms(file_names, merged):
+    sub_bucket_bits = None
+    for file_name in file_names:
+        with open(file_name) as f:
+            header = f.readline().strip()
+            if not header.startswith(FORMAT_HEADER):
+                sys.exit(f'{file_name}: not a latency histogram dump')
+            bits = int(header.split('sub_bucket_bits=')[1])
+            if sub_bucket_bits is not None and bits != sub_bucket_bits:
+                sys.exit(f'{file_name}: bucket layout differs from the other files')
+            sub_bucket_bits = bits
+
+            for line in f:
+                if line.startswith('#') or not line.strip():
+                    continue
+                strategy, _run, tier, component, count, min_ns, max_ns, sum_ns, buckets = \
+                    line.rstrip('\n').split(',', 8)
+                key = (strategy, tier, component)
+                merged.setdefault(key, Histogram()).merge_line(
+                    int(count), int(min_ns), int(max_ns), int(sum_ns), buckets)
+    return sub_bucket_bits
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Merge simulator latency histograms')
+    parser.add_argument('files', nargs='+', help='.hist files or glob patterns')
+    parser.add_argument('--percentiles', default='50,90,95,99')
+    parser.add_argument('--output', help='write the merged histograms to this file')
+    args = parser.parse_args()
+
+    file_names = []
+    for pattern in args.files:
+        file_names.extend(sorted(glob.glob(pattern)) or [pattern])
+
+    merged = OrderedDict()
+    sub_bucket_bits = read_histograms(file_names, merged)
+    percentiles = [float(p) for p in args.percentiles.split(',')]
+
+    columns = ['strategy', 'tier', 'component', 'count', 'mean_ms', 'min_ms', 'max_ms']
+    columns += [f'p{p:g}_ms' for p in percentiles]
+    print(','.join(columns))
+    for (strategy, tier, component), histogram in merged.items():
+        row = [strategy, tier, component, str(histogram.count),
+               f'{histogram.sum / histogram.count / 1e6:.6f}',
+               f'{histogram.min / 1e6:.6f}', f'{histogram.max / 1e6:.6f}']
+        for p in percentiles:
+            index = histogram.percentile(p)
+            # Report the bucket midpoint; the bucket width bounds the error
+            low = bucket_lower_bound(index, sub_bucket_bits)
+            high = bucket_upper_bound(index, sub_bucket_bits)
+            row.append(f'{(low + high) / 2 / 1e6:.6f}')
+        print(','.join(row))
+
+    if args.output:
+        with open(args.output, 'w') as out:
+            out.write(f'{FORMAT_HEADER} sub_bucket_bits={sub_bucket_bits}\n')
+            out.write('# strategy,run,tier,component,count,min_ns,max_ns,sum_ns,buckets\n')
+            for (strategy, tier, component), histogram in merged.items():
+                out.write(f'{strategy},merged,{tier},{component},{histogram.serialize()}\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -1,5 +1,6 @@
 import csv
 import decimal
+import os
 import statistics
 import numpy as np
 from matplotlib import pyplot as plt
@@ -16,6 +17,44 @@ def convert_nanoseconds_to_decimal_seconds(x):
     return res
 
 
+def load_binary_trace(trace_folder):
+    # Binary traces (--traceFormat=binary) are folders with one .npy file per column,
+    # e.g. offloading_time_<simType>/time_ns.npy. Columns are memory-mapped, not copied.
+    columns = {}
+    for file_name in sorted(os.listdir(trace_folder)):
+        if file_name.endswith('.npy'):
+            columns[file_name[:-4]] = np.load(os.path.join(trace_folder, file_name), mmap_mode='r')
+    return columns
+
+
+def nanoseconds_to_seconds(ns_column):
+    return np.asarray(ns_column, dtype=np.float64) * 1e-9
+
+
+# Columns of the offloading_time_ trace, in CSV order (binary traces name them)
+OFFLOADING_TIME_COLUMNS = ['node_id', 'packet_size', 'initial_time_ns', 'time_ns', 'where', 'request_rate',
+                           'cars_number', 'pedestrians_number', 'uplink_time_ns', 'elaboration_time_ns',
+                           'edge_computation_capacity', 'car_computation_capacity', 'queueing_time_ns',
+                           'workload', 'cars_in_vcc', 'vehicle_queue_length']
+
+
+def offloading_time_components(columns):
+    # Per-request offloading time and its uplink, queueing, elaboration and downlink parts (s),
+    # computed on whole columns of a binary offloading_time_ trace
+    initial = nanoseconds_to_seconds(columns['initial_time_ns'])
+    final = nanoseconds_to_seconds(columns['time_ns'])
+    uplink = nanoseconds_to_seconds(columns['uplink_time_ns'])
+    queueing = nanoseconds_to_seconds(columns['queueing_time_ns'])
+    elaboration = nanoseconds_to_seconds(columns['elaboration_time_ns'])
+    return {
+        'offloading': final - initial,
+        'uplink': uplink - initial,
+        'queueing': queueing - uplink,
+        'elaboration': elaboration,
+        'downlink': final - queueing - elaboration,
+    }
+
+
 def cars_number_in_vcc_for_any_config(input_files_VCC, x_axs, idx):
     m = np.zeros(len(x_axs))
     cars_in_vcc_x = np.zeros(len(x_axs))